@@ -0,0 +1,73 @@
+#ifndef COMBAT_HPP
+#define COMBAT_HPP
+
+#include "unit.hpp"
+#include <cstdint>
+
+/**
+ * @class CombatStage
+ * @brief Collects the attacks of a turn and resolves them in one batch.
+ *
+ * The health of the units that can be attacked is kept in a contiguous array. Attacks are
+ * validated when they are added and stored as (attacker type, target index) pairs. On
+ * resolution, the damage of every attack is gathered from the type-by-type damage matrix,
+ * summed per target and subtracted from the health array with saturating arithmetic, using
+ * AVX2 when useAVX2 allows it. Since damage saturates at 0, the final health is the same
+ * as when Unit::takeDamage is called once per attack.
+ */
+class CombatStage {
+private:
+    std::vector<Unit*> units;                   /**< The units that can be attacked, by index. */
+    std::vector<std::uint16_t> health;          /**< The health of each unit, padded to a multiple of 16. */
+    std::vector<std::uint8_t> types;            /**< The type index of each unit. */
+    std::unordered_map<const Unit*, std::uint32_t> indices; /**< The index of each unit. */
+
+    std::vector<std::uint8_t> attackerTypes;    /**< The type index of the attacker of each attack. */
+    std::vector<std::uint32_t> targetIndices;   /**< The target index of each attack. */
+
+public:
+    /**
+     * @brief Retrieves the type index of a unit type, used to address the damage matrix.
+     * @param initial The initial letter of the unit type.
+     * @return The type index, or 255 if the type is unknown.
+     */
+    static std::uint8_t typeIndex(char initial);
+
+    /**
+     * @brief Retrieves the damage one unit type deals to another.
+     * @param attackerType The type index of the attacker.
+     * @param targetType The type index of the target.
+     * @return The damage, as calculated by Unit::calculateDamage.
+     */
+    static std::uint16_t damage(std::uint8_t attackerType, std::uint8_t targetType);
+
+    /**
+     * @brief Loads the units that can be attacked during the turn and clears pending attacks.
+     * @param targets The unit lists holding the possible targets. They must not be modified until the turn is resolved.
+     */
+    void load(const std::vector<std::vector<Unit>*>& targets);
+
+    /**
+     * @brief Validates an attack with Unit::declareAttack and queues it for resolution.
+     * @param attacker The attacking unit.
+     * @param targetId The ID of the target unit.
+     * @param index The spatial index of the possible targets.
+     * @return The damage the attack will deal once resolved.
+     * @throws std::runtime_error if the attack is not allowed or the target has not been loaded.
+     */
+    std::uint16_t addAttack(Unit& attacker, unsigned short targetId, const SpatialIndex& index);
+
+    /**
+     * @brief Retrieves the number of queued attacks.
+     * @return The number of queued attacks.
+     */
+    size_t getAttackCount() const;
+
+    /**
+     * @brief Deals the damage of every queued attack and clears the queue.
+     * @return The IDs of the units destroyed by this resolution.
+     */
+    std::vector<unsigned short> resolve();
+};
+
+#endif  // COMBAT_HPP
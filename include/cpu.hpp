@@ -0,0 +1,45 @@
+#ifndef CPU_HPP
+#define CPU_HPP
+
+#include <atomic>
+#include <cstdlib>
+
+/**
+ * @brief Checks whether the running CPU supports the AVX2 instruction set.
+ *
+ * The result is queried once and cached, so the check is cheap enough to be
+ * used for dispatching inside hot loops.
+ *
+ * @return True if AVX2 kernels can be used, false otherwise.
+ */
+inline bool cpuHasAVX2() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Retrieves the switch that keeps every kernel on its portable version.
+ *
+ * The switch starts on when SKIRMISH_PORTABLE_KERNELS is set in the environment, so the
+ * portable kernels also run on hosts with AVX2. Benchmarks flip it to compare both kernels.
+ *
+ * @return The switch.
+ */
+inline std::atomic<bool>& portableKernels() {
+    static std::atomic<bool> forced(std::getenv("SKIRMISH_PORTABLE_KERNELS") != nullptr);
+    return forced;
+}
+
+/**
+ * @brief Checks whether kernels should dispatch to their AVX2 version.
+ * @return True if the CPU supports AVX2 and the portable kernels are not forced, false otherwise.
+ */
+inline bool useAVX2() {
+    return cpuHasAVX2() && !portableKernels().load(std::memory_order_relaxed);
+}
+
+#endif  // CPU_HPP
@@ -0,0 +1,123 @@
+#ifndef DEADLINE_HPP
+#define DEADLINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class CancellationToken
+ * @brief Tells long-running work that it should stop and return what it has so far.
+ *
+ * Tokens are cheap copies sharing the flag of a CancellationSource. Checking a token is a
+ * single atomic load, so planners can poll it in their innermost loop.
+ */
+class CancellationToken {
+private:
+    std::shared_ptr<const std::atomic<bool>> cancelled; /**< The flag of the source, or nullptr for a token that is never cancelled. */
+
+    friend class CancellationSource;
+    explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> cancelled);
+
+public:
+    /**
+     * @brief Constructs a token that is never cancelled.
+     */
+    CancellationToken() = default;
+
+    /**
+     * @brief Checks whether the work should stop.
+     * @return True once the source has been cancelled.
+     */
+    bool isCancelled() const;
+};
+
+/**
+ * @class CancellationSource
+ * @brief Hands out tokens and cancels all of them at once.
+ */
+class CancellationSource {
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled; /**< The flag shared with the tokens. */
+
+public:
+    /**
+     * @brief Constructs a source that has not been cancelled.
+     */
+    CancellationSource();
+
+    /**
+     * @brief Retrieves a token of the source.
+     * @return The token.
+     */
+    CancellationToken getToken() const;
+
+    /**
+     * @brief Cancels every token of the source.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks whether the source has been cancelled.
+     * @return True once cancel has been called.
+     */
+    bool isCancelled() const;
+};
+
+/**
+ * @class DeadlineTimer
+ * @brief Cancels a source once a deadline passes.
+ *
+ * A watcher thread waits on a condition variable until the deadline or until the timer is
+ * stopped, whichever comes first. Stopping the timer after a fast turn wakes the watcher
+ * right away, so the turn does not sleep out the rest of its time limit.
+ */
+class DeadlineTimer {
+private:
+    CancellationSource source;                          /**< The source cancelled at the deadline. */
+    std::chrono::steady_clock::time_point deadline;     /**< The time the source is cancelled at. */
+    mutable std::mutex mutex;                           /**< Guards the flags below. */
+    std::condition_variable wakeup;                     /**< Wakes the watcher when the timer is stopped. */
+    bool stopped;                                       /**< Whether the timer has been stopped. */
+    bool expired;                                       /**< Whether the deadline passed before the timer was stopped. */
+    std::thread watcher;                                /**< Waits for the deadline. */
+
+public:
+    /**
+     * @brief Starts the timer. A deadline that has already passed cancels the source at once.
+     * @param source The source to cancel at the deadline.
+     * @param deadline The deadline.
+     */
+    DeadlineTimer(const CancellationSource& source, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief Stops the timer.
+     */
+    ~DeadlineTimer();
+
+    DeadlineTimer(const DeadlineTimer&) = delete;
+    DeadlineTimer& operator=(const DeadlineTimer&) = delete;
+
+    /**
+     * @brief Stops the timer without cancelling the source and waits for the watcher to exit.
+     */
+    void stop();
+
+    /**
+     * @brief Checks whether the deadline passed before the timer was stopped.
+     * @return True if the timer cancelled the source.
+     */
+    bool hasExpired() const;
+};
+
+/**
+ * @brief Computes the time point a number of seconds from now.
+ * @param seconds The number of seconds.
+ * @return The time point.
+ */
+std::chrono::steady_clock::time_point deadlineAfter(double seconds);
+
+#endif  // DEADLINE_HPP
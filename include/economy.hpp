@@ -0,0 +1,126 @@
+#ifndef ECONOMY_HPP
+#define ECONOMY_HPP
+
+#include "player.hpp"
+#include <cstdint>
+
+/**
+ * @brief The amount of gold a worker standing on a mine earns per turn.
+ */
+const unsigned int goldPerWorker = 50;
+
+/**
+ * @class MineMap
+ * @brief A bitmap of the mine cells of a map and the index of every mine.
+ *
+ * The map does not change during a game, so a single mine map can be shared by every
+ * copy of a game state.
+ */
+class MineMap {
+private:
+    unsigned int width;                 /**< The width of the map. */
+    unsigned int height;                /**< The height of the map. */
+    unsigned int wordsPerRow;           /**< The number of 64-bit words of a bitmap row. */
+    std::vector<std::uint64_t> bits;    /**< One bit per cell, set for mine cells. */
+    std::vector<std::pair<unsigned short, unsigned short>> mines; /**< The position of every mine. */
+    std::unordered_map<unsigned int, unsigned int> mineIndices;   /**< The index of the mine of every mine cell. */
+
+public:
+    /**
+     * @brief Collects the mine cells of a map.
+     * @param map The map.
+     */
+    explicit MineMap(const Map& map);
+
+    /**
+     * @brief Checks whether a cell is a mine.
+     * @param x The X coordinate of the cell.
+     * @param y The Y coordinate of the cell.
+     * @return True if the cell is a mine, false otherwise or if the cell is out of bounds.
+     */
+    bool isMine(unsigned short x, unsigned short y) const {
+        return x < width && y < height && (bits[y * wordsPerRow + x / 64] >> (x % 64)) & 1;
+    }
+
+    /**
+     * @brief Retrieves the index of the mine on a cell.
+     * @param x The X coordinate of the cell.
+     * @param y The Y coordinate of the cell.
+     * @return The index of the mine, or -1 if the cell is not a mine.
+     */
+    int getMineIndex(unsigned short x, unsigned short y) const;
+
+    /**
+     * @brief Retrieves the positions of the mines, in index order.
+     * @return The positions of the mines.
+     */
+    const std::vector<std::pair<unsigned short, unsigned short>>& getMines() const;
+};
+
+/**
+ * @class Economy
+ * @brief The economy phase of a turn.
+ *
+ * Every living worker standing on a mine earns goldPerWorker gold for its owner. The units
+ * of all players are scanned in one pass that tests positions against the mine bitmap, and
+ * the gold of every player is credited once at the end of the pass.
+ */
+class Economy {
+private:
+    MineMap mineMap;                        /**< The mines of the map. */
+    unsigned int workerGold;                /**< The gold a worker on a mine earns per turn. */
+    std::vector<std::uint16_t> occupancy;   /**< The number of workers on every mine during the last step. */
+    unsigned int income[maxPlayers];        /**< The income of each owner during the last step. */
+
+public:
+    /**
+     * @brief Constructs the economy of a map.
+     * @param map The map.
+     * @param workerGold The gold a worker on a mine earns per turn.
+     */
+    explicit Economy(const Map& map, unsigned int workerGold = goldPerWorker);
+
+    /**
+     * @brief Checks whether a unit earns gold in the economy step, which only living workers on a mine do.
+     * @param unit The unit.
+     * @return True if the unit earns workerGold, false otherwise.
+     */
+    bool earnsGold(const Unit& unit) const {
+        return unit.getInitial() == 'W' && unit.getHealth() > 0 && mineMap.isMine(unit.getPositionX(), unit.getPositionY());
+    }
+
+    /**
+     * @brief Counts the workers on every mine and credits the income of every player.
+     * @param players The players.
+     */
+    void step(const std::vector<Player*>& players);
+
+    /**
+     * @brief Computes the gold a unit list earns in one step, without crediting it.
+     * @param units The units.
+     * @return The income in gold.
+     */
+    unsigned int computeIncome(const std::vector<Unit>& units) const;
+
+    /**
+     * @brief Retrieves the mines of the map.
+     * @return The mine map.
+     */
+    const MineMap& getMineMap() const;
+
+    /**
+     * @brief Retrieves the number of workers on a mine during the last step.
+     * @param mineIndex The index of the mine.
+     * @return The number of workers.
+     */
+    std::uint16_t getOccupancy(unsigned int mineIndex) const;
+
+    /**
+     * @brief Retrieves the income of an owner during the last step.
+     * @param owner The owner.
+     * @return The income in gold.
+     */
+    unsigned int getIncome(OwnerId owner) const;
+};
+
+#endif  // ECONOMY_HPP
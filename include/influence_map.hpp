@@ -0,0 +1,198 @@
+#ifndef INFLUENCE_MAP_HPP
+#define INFLUENCE_MAP_HPP
+
+#include "unit.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+/**
+ * @class InfluenceMap
+ * @brief Per-cell threat and influence of the units of each owner.
+ *
+ * The threat of a cell is the damage the units of an owner could deal to a unit of a given
+ * type standing on it, taken from the damage matrix of CombatStage. The influence of a cell
+ * is the number of units of an owner that have it within attack range. Bases cannot attack
+ * and add nothing. The map is two-sided: owner 0 against the units of every other owner,
+ * which are added together as owner 1.
+ *
+ * Every unit contributes a diamond-shaped stencil of its attack range around its position.
+ * The maps are updated by adding and subtracting single stencils when a unit spawns, moves
+ * or dies, and queries read a single cell.
+ */
+class InfluenceMap {
+private:
+    unsigned int width;     /**< The width of the map. */
+    unsigned int height;    /**< The height of the map. */
+    std::vector<std::uint32_t> threat[2];       /**< The threat of each owner, with the threat to every target type stored together per cell. */
+    std::vector<std::uint16_t> influence[2];    /**< The influence of each owner. */
+
+public:
+    /**
+     * @brief Constructs empty maps.
+     * @param width The width of the map.
+     * @param height The height of the map.
+     */
+    InfluenceMap(unsigned int width, unsigned int height);
+
+    /**
+     * @brief Clears the maps and adds every unit of the given lists.
+     * @param armies The unit lists. Units with 0 health are left out.
+     */
+    void rebuild(const std::vector<const std::vector<Unit>*>& armies);
+
+    /**
+     * @brief Adds the stencil of a unit at its current position.
+     * @param unit The unit that has spawned.
+     */
+    void addUnit(const Unit& unit);
+
+    /**
+     * @brief Subtracts the stencil of a unit at its current position.
+     * @param unit The unit that has died or is about to be removed.
+     */
+    void removeUnit(const Unit& unit);
+
+    /**
+     * @brief Moves the stencil of a unit from its previous position to its current one.
+     * @param unit The unit that has moved.
+     * @param fromX The previous X position of the unit.
+     * @param fromY The previous Y position of the unit.
+     */
+    void moveUnit(const Unit& unit, unsigned short fromX, unsigned short fromY);
+
+    /**
+     * @brief Retrieves the damage the units of an owner could deal to a unit on a cell.
+     * @param owner The owner of the threatening units.
+     * @param x The X coordinate of the cell.
+     * @param y The Y coordinate of the cell.
+     * @param targetType The type index of the target, as returned by CombatStage::typeIndex.
+     * @return The total damage, or 0 if the cell or the type is out of bounds.
+     */
+    std::uint32_t getThreat(bool owner, unsigned short x, unsigned short y, std::uint8_t targetType) const;
+
+    /**
+     * @brief Retrieves the damage the units of an owner could deal to a unit if it stood on a cell.
+     * @param owner The owner of the threatening units.
+     * @param x The X coordinate of the cell.
+     * @param y The Y coordinate of the cell.
+     * @param target The threatened unit.
+     * @return The total damage, or 0 if the cell is out of bounds.
+     */
+    std::uint32_t getThreat(bool owner, unsigned short x, unsigned short y, const Unit& target) const;
+
+    /**
+     * @brief Retrieves the number of units of an owner that have a cell within attack range.
+     * @param owner The owner of the units.
+     * @param x The X coordinate of the cell.
+     * @param y The Y coordinate of the cell.
+     * @return The number of units, or 0 if the cell is out of bounds.
+     */
+    std::uint16_t getInfluence(bool owner, unsigned short x, unsigned short y) const;
+
+private:
+    /**
+     * @brief Adds or subtracts the stencil of a unit at a position.
+     * @param unit The unit.
+     * @param x The X position of the stencil center.
+     * @param y The Y position of the stencil center.
+     * @param sign 1 to add the stencil, -1 to subtract it.
+     */
+    void applyStencil(const Unit& unit, unsigned short x, unsigned short y, int sign);
+};
+
+/**
+ * @class InfluenceOverlay
+ * @brief An InfluenceMap shared by many copies of a game state, with the changes of one copy on top.
+ *
+ * Copying the full maps costs as much as the map is large, which dominates game states
+ * that are copied on every search iteration. The overlay shares the maps of the starting
+ * position read-only and records, for every unit that has since spawned, moved or died,
+ * its stencil in the shared maps and its current stencil. A query adds the differences of
+ * those stencils to the shared value, so both copies and queries cost as much as the
+ * number of changed units, whatever the size of the map.
+ */
+class InfluenceOverlay {
+private:
+    /**
+     * @struct Stencil
+     * @brief The footprint of a unit in the maps.
+     */
+    struct Stencil {
+        bool owner;                 /**< The side of the unit, as in InfluenceMap. */
+        std::uint8_t type;          /**< The type index of the unit. */
+        unsigned short range;       /**< The attack range of the unit. */
+        unsigned short x;           /**< The X coordinate of the center. */
+        unsigned short y;           /**< The Y coordinate of the center. */
+
+        bool covers(unsigned short cellX, unsigned short cellY) const;
+    };
+
+    /**
+     * @struct Change
+     * @brief The stencils of a unit that differs from the shared maps.
+     */
+    struct Change {
+        unsigned short unitId;          /**< The ID of the unit. */
+        std::optional<Stencil> shared;  /**< The stencil of the unit in the shared maps, if it was there. */
+        std::optional<Stencil> current; /**< The current stencil of the unit, if it is alive. */
+    };
+
+    unsigned int width;                         /**< The width of the map. */
+    unsigned int height;                        /**< The height of the map. */
+    std::shared_ptr<const InfluenceMap> base;   /**< The maps of the starting position, shared by all copies. */
+    std::vector<Change> changes;                /**< The units that differ from the shared maps. */
+
+    static std::optional<Stencil> stencilOf(const Unit& unit, unsigned short x, unsigned short y);
+    Change& findChange(const Unit& unit, unsigned short x, unsigned short y);
+    void dropIfUnchanged(Change& change);
+
+public:
+    /**
+     * @brief Builds the shared maps of a starting position.
+     * @param width The width of the map.
+     * @param height The height of the map.
+     * @param armies The unit lists. Units with 0 health are left out.
+     */
+    InfluenceOverlay(unsigned int width, unsigned int height, const std::vector<const std::vector<Unit>*>& armies);
+
+    /**
+     * @brief Adds the stencil of a unit at its current position.
+     * @param unit The unit that has spawned.
+     */
+    void addUnit(const Unit& unit);
+
+    /**
+     * @brief Subtracts the stencil of a unit at its current position.
+     * @param unit The unit that has died or is about to be removed.
+     */
+    void removeUnit(const Unit& unit);
+
+    /**
+     * @brief Moves the stencil of a unit from its previous position to its current one.
+     * @param unit The unit that has moved.
+     * @param fromX The previous X position of the unit.
+     * @param fromY The previous Y position of the unit.
+     */
+    void moveUnit(const Unit& unit, unsigned short fromX, unsigned short fromY);
+
+    /**
+     * @brief Retrieves the damage the units of an owner could deal to a unit if it stood on a cell.
+     * @see InfluenceMap::getThreat
+     */
+    std::uint32_t getThreat(bool owner, unsigned short x, unsigned short y, const Unit& target) const;
+
+    /**
+     * @brief Retrieves the number of units of an owner that have a cell within attack range.
+     * @see InfluenceMap::getInfluence
+     */
+    std::uint16_t getInfluence(bool owner, unsigned short x, unsigned short y) const;
+
+    /**
+     * @brief Retrieves the number of units that differ from the shared maps.
+     * @return The number of changed units.
+     */
+    size_t getChangeCount() const;
+};
+
+#endif  // INFLUENCE_MAP_HPP
@@ -6,6 +6,49 @@
 #include <fstream>
 #include <stdexcept>
 #include <utility>
+#include <cstdint>
+#include <memory>
+#include "owner.hpp"
+
+/**
+ * @struct RegionLink
+ * @brief An entrance from one region of the map into a neighbouring region.
+ *
+ * An entrance is a run of adjacent cell pairs along the border of two regions. The link
+ * holds the pair in the middle of the run.
+ */
+struct RegionLink {
+    std::uint32_t region;   /**< The neighbouring region. */
+    unsigned int x;         /**< The X coordinate of the cell of the entrance on this side. */
+    unsigned int y;         /**< The Y coordinate of the cell of the entrance on this side. */
+    unsigned int toX;       /**< The X coordinate of the cell of the entrance in the neighbouring region. */
+    unsigned int toY;       /**< The Y coordinate of the cell of the entrance in the neighbouring region. */
+    unsigned int width;     /**< The number of cell pairs of the entrance. */
+};
+
+/**
+ * @struct BitGrid
+ * @brief One bit per map cell, packed into 64-bit words per row.
+ *
+ * Every row has a zero padding word on each side and the grid has a zero padding row
+ * above and below the map, so neighbour reads never need bounds checks. Bit b of word w
+ * in a row stands for the cell x = (w - 1) * 64 + b.
+ */
+struct BitGrid {
+    unsigned int words = 0;          /**< Words holding map cells per row, rounded up to a multiple of 4. */
+    unsigned int stride = 2;         /**< Words per row including padding. */
+    std::vector<std::uint64_t> bits; /**< The packed rows. */
+
+    BitGrid() = default;
+    BitGrid(unsigned int width, unsigned int height)
+        : words(((width + 63) / 64 + 3) / 4 * 4), stride(words + 2), bits(static_cast<size_t>(stride) * (height + 2), 0) {}
+
+    std::uint64_t* row(unsigned int y) { return bits.data() + static_cast<size_t>(y + 1) * stride; }
+    const std::uint64_t* row(unsigned int y) const { return bits.data() + static_cast<size_t>(y + 1) * stride; }
+
+    bool test(unsigned int x, unsigned int y) const { return row(y)[1 + x / 64] >> (x % 64) & 1; }
+    void set(unsigned int x, unsigned int y) { row(y)[1 + x / 64] |= std::uint64_t(1) << (x % 64); }
+};
 
 /**
  * @class Map
@@ -17,9 +60,24 @@
  */
 class Map {
 private:
-    std::vector<std::vector<char>> grid; /**< The grid of cells representing the map. */
+    std::vector<std::vector<char>> grid;            /**< The grid of cells representing the map. */
+    BitGrid passableBits;                           /**< The cells that can be entered, packed for bit-parallel searches. */
+    std::shared_ptr<const std::int32_t> labels;     /**< The component of every cell, then its region, indexed as y * width + x, -1 for obstacles. */
+    std::vector<bool> chokepoints;                  /**< Whether every cell is part of a chokepoint, indexed as y * width + x. */
+    std::vector<std::vector<RegionLink>> regionLinks; /**< The entrances of every region. */
+    std::uint32_t componentCount = 0;               /**< The number of connected components. */
 
 public:
+    /** The label of obstacle cells, which belong to no component and no region. */
+    static constexpr std::uint32_t noLabel = UINT32_MAX;
+    /** The side of the square sectors the components are broken into regions along. */
+    static constexpr unsigned int regionSize = 16;
+    /** The widest entrance between two regions that is marked as a chokepoint. */
+    static constexpr unsigned int maxChokepointWidth = 3;
+
+    /** Whether a constructor labels the topology of the map or leaves it to setTopologyLabels. */
+    enum class Topology { Labelled, Deferred };
+
     /**
      * @brief Constructs a Map object by loading map data from a file.
      * @param filename The name of the file containing the map data.
@@ -28,12 +86,22 @@ public:
     Map(const std::string& filename);
 
     /**
-     * @brief Constructs a Map object by loading map data from a file.
-     * @param filename The name of the file containing the map data.
-     * @throw std::runtime_error If the map data fails to load from the file.
+     * @brief Constructs a Map object by loading map data from a stream.
+     * @param file The stream containing the map data.
+     * @param topology Whether to label the topology, or to leave it to setTopologyLabels.
+     * @throw std::runtime_error If the map data fails to load from the stream.
      */
-    Map(std::ifstream& file);
+    Map(std::istream& file, Topology topology = Topology::Labelled);
 
+    /**
+     * @brief Constructs a Map object from the cells of an already loaded map.
+     * @param width The width of the map.
+     * @param height The height of the map.
+     * @param cells The cells of the map, row by row, without line breaks.
+     * @param topology Whether to label the topology, or to leave it to setTopologyLabels.
+     * @throw std::runtime_error If a cell is invalid or the dimensions are invalid.
+     */
+    Map(unsigned int width, unsigned int height, const char* cells, Topology topology = Topology::Labelled);
 
     /**
      * @brief Retrieves the width of the map.
@@ -57,13 +125,140 @@ public:
     char getCell(unsigned int x, unsigned int y) const;
 
     /**
-     * @brief Retrieves the coordinates of the base cell with value "1" or "2".
+     * @brief Retrieves the cell marking the base of a player.
+     *
+     * Players 0 and 1 keep the markers "1" and "2" of two-player maps, and players 2 to 15
+     * are marked with the letters "c" to "p".
+     *
+     * @param owner The ID of the player.
+     * @return The marker of the player's base.
+     */
+    static char baseMarker(OwnerId owner);
+
+    /**
+     * @brief Counts the players the map has bases for.
+     * @return The number of consecutive players, from player 0, whose base marker is on the map.
+     */
+    unsigned int getBaseCount() const;
+
+    /**
+     * @brief Retrieves the coordinates of the base cell with the given marker, see baseMarker.
      * @return The coordinates of the base cell as a pair of integers (x, y).
      * @throw std::runtime_error If no base cell is found or if the base cell value is invalid.
      */
     std::pair<unsigned int, unsigned int> getBasePosition(char baseCell) const;
 
+    /**
+     * @brief Computes a 64-bit FNV-1a hash of the dimensions and cells of the map.
+     * @return The hash, identical for maps with the same contents.
+     */
+    std::uint64_t computeHash() const;
+
+    /**
+     * @brief Retrieves the connected component of a cell.
+     *
+     * Components are labelled with union-find when the map is loaded, so two cells can reach
+     * each other exactly when they have the same label.
+     *
+     * @return The component, numbered from 0 in row order, or noLabel for an obstacle.
+     * @throw std::out_of_range If the provided coordinates are out of bounds.
+     * @throw std::runtime_error If the topology has not been labelled.
+     */
+    std::uint32_t getComponent(unsigned int x, unsigned int y) const;
+
+    /**
+     * @brief Retrieves the number of connected components.
+     * @return The number of components.
+     */
+    std::uint32_t getComponentCount() const;
+
+    /**
+     * @brief Checks whether a unit can walk from one cell to another.
+     * @return True if both cells are passable and in the same component.
+     * @throw std::out_of_range If the provided coordinates are out of bounds.
+     * @throw std::runtime_error If the topology has not been labelled.
+     */
+    bool isReachable(unsigned int fromX, unsigned int fromY, unsigned int toX, unsigned int toY) const;
+
+    /**
+     * @brief Retrieves the region of a cell.
+     *
+     * Regions are the connected parts of a component within each square sector of regionSize
+     * cells, so a large component is broken into regions that neighbour each other through
+     * the entrances listed by getRegionLinks.
+     *
+     * @return The region, numbered from 0 in row order, or noLabel for an obstacle.
+     * @throw std::out_of_range If the provided coordinates are out of bounds.
+     * @throw std::runtime_error If the topology has not been labelled.
+     */
+    std::uint32_t getRegion(unsigned int x, unsigned int y) const;
+
+    /**
+     * @brief Retrieves the number of regions.
+     * @return The number of regions.
+     */
+    std::uint32_t getRegionCount() const;
+
+    /**
+     * @brief Retrieves the entrances of a region into its neighbouring regions.
+     * @param region The region.
+     * @return The entrances, at least one per neighbouring region.
+     * @throw std::out_of_range If the region does not exist.
+     */
+    const std::vector<RegionLink>& getRegionLinks(std::uint32_t region) const;
+
+    /**
+     * @brief Checks whether a cell is part of a chokepoint, an entrance between two regions no wider than maxChokepointWidth.
+     * @return True if the cell is on either side of a chokepoint.
+     * @throw std::out_of_range If the provided coordinates are out of bounds.
+     * @throw std::runtime_error If the topology has not been labelled.
+     */
+    bool isChokepoint(unsigned int x, unsigned int y) const;
+
+    /**
+     * @brief Retrieves the passable cells packed one bit per cell.
+     *
+     * The bits are packed once when the map is loaded and shared by every search workspace.
+     *
+     * @return The passable cells.
+     */
+    const BitGrid& getPassableBits() const;
+
+    /**
+     * @brief Checks whether the topology of the map has been labelled.
+     * @return False for a map constructed with Topology::Deferred until setTopologyLabels is called.
+     */
+    bool hasTopology() const;
+
+    /**
+     * @brief Labels the components and regions of the map with union-find, the costly part of labelling its topology.
+     * @return The component of every cell followed by the region of every cell, both indexed as y * width + x, with
+     *         noLabel stored as -1. The labels only depend on the cells, so they can be stored and reused.
+     * @throw std::runtime_error If the map has too many cells to label.
+     */
+    std::vector<std::int32_t> computeTopologyLabels() const;
+
+    /**
+     * @brief Sets the topology of the map from labels returned by computeTopologyLabels, and finds the entrances between regions.
+     *
+     * The labels are kept rather than copied, and shared by copies of the map, so they may
+     * stay in a mapping of the map cache.
+     *
+     * @param labels The components followed by the regions, width * height values each.
+     */
+    void setTopologyLabels(std::shared_ptr<const std::int32_t> labels);
+
 private:
+    /**
+     * @brief Labels the components and regions of the map and finds the entrances between regions.
+     */
+    void labelTopology();
+
+    /**
+     * @brief Packs the passable cells into the bit grid.
+     */
+    void packPassableCells();
+
     /**
      * @brief Loads the map data from a file.
      * @param filename The name of the file containing the map data.
@@ -0,0 +1,197 @@
+#ifndef MAP_CACHE_HPP
+#define MAP_CACHE_HPP
+
+#include "map.hpp"
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+/** Environment variable naming the cache directory, which overrides defaultMapCacheDirectory. */
+constexpr const char* mapCacheVariable = "SKIRMISH_CACHE_DIR";
+/** The cache directory used when mapCacheVariable is not set, relative to the working directory. */
+constexpr const char* defaultMapCacheDirectory = "data/cache";
+
+/** Identifies the cache files, "SKMC" in little-endian order. */
+constexpr std::uint32_t mapCacheMagic = 0x434D4B53;
+/** Version of the cache files, increased whenever the header or the layout of an artifact changes. */
+constexpr std::uint32_t mapCacheVersion = 1;
+
+/**
+ * @struct MapCacheHeader
+ * @brief The start of a cache file, followed by planeCount planes of width * height 32-bit values.
+ *
+ * The map hash and dimensions tie the file to the map it was computed for, so a file left
+ * over from another map or an older build is recomputed instead of being used.
+ */
+struct MapCacheHeader {
+    std::uint32_t magic;        /**< Always mapCacheMagic. */
+    std::uint32_t version;      /**< Always mapCacheVersion. */
+    std::uint64_t mapHash;      /**< The hash of the map, see Map::computeHash. */
+    std::uint32_t width;        /**< The width of the map. */
+    std::uint32_t height;       /**< The height of the map. */
+    std::uint32_t planeCount;   /**< The number of per-cell planes in the file. */
+    std::uint32_t reserved;     /**< Padding, always 0. */
+    std::uint64_t valueCount;   /**< The number of values following the header. */
+};
+
+/**
+ * @class CachedArray
+ * @brief A read-only array of 32-bit values, either mapped from a cache file or computed in memory.
+ */
+class CachedArray {
+private:
+    std::vector<std::int32_t> owned;    /**< The values when they are not mapped. */
+    void* mapping;                      /**< The start of the file mapping, or nullptr. */
+    size_t mappingSize;                 /**< The size of the file mapping. */
+    const std::int32_t* values;         /**< The first value. */
+    size_t count;                       /**< The number of values. */
+
+public:
+    /**
+     * @brief Constructs an array owning computed values.
+     * @param values The values.
+     */
+    explicit CachedArray(std::vector<std::int32_t> values = {});
+
+    /**
+     * @brief Constructs an array over a file mapping, which is unmapped on destruction.
+     * @param mapping The start of the mapping.
+     * @param mappingSize The size of the mapping.
+     * @param offset The offset of the first value in the mapping.
+     * @param count The number of values.
+     */
+    CachedArray(void* mapping, size_t mappingSize, size_t offset, size_t count);
+
+    CachedArray(CachedArray&& other) noexcept;
+    CachedArray& operator=(CachedArray&& other) noexcept;
+    CachedArray(const CachedArray&) = delete;
+    CachedArray& operator=(const CachedArray&) = delete;
+    ~CachedArray();
+
+    const std::int32_t* data() const;
+    size_t size() const;
+
+    /**
+     * @brief Checks whether the values were mapped from a cache file.
+     * @return True if the values come from the cache.
+     */
+    bool isMapped() const;
+};
+
+/**
+ * @class MapCache
+ * @brief Stores artifacts precomputed from a map in a directory shared by every bot invocation.
+ *
+ * Files are named after the hash of the map and the artifact, so any number of maps share
+ * one directory. A file is written to a temporary name and renamed into place, so readers
+ * in other processes never see a partial file. A missing, stale or unwritable cache only
+ * costs the time to compute the artifact again.
+ */
+class MapCache {
+private:
+    const Map& map;         /**< The map the artifacts are computed from. */
+    std::string directory;  /**< The cache directory. */
+    std::uint64_t mapHash;  /**< The hash of the map. */
+
+public:
+    /**
+     * @brief Constructs a cache for a map.
+     * @param map The map. It must outlive the cache.
+     * @param directory The cache directory, created when the first artifact is stored.
+     */
+    explicit MapCache(const Map& map, std::string directory = getDefaultDirectory());
+
+    /**
+     * @brief Retrieves the cache directory named by the environment, or defaultMapCacheDirectory.
+     * @return The directory.
+     */
+    static std::string getDefaultDirectory();
+
+    /**
+     * @brief Builds the path of the file of an artifact.
+     * @param artifact The name of the artifact.
+     * @return The path.
+     */
+    std::string getPath(const std::string& artifact) const;
+
+    /**
+     * @brief Maps an artifact from its file, or computes and stores it if the file is missing or stale.
+     * @param artifact The name of the artifact.
+     * @param planeCount The number of per-cell planes of the artifact.
+     * @param compute Computes the planes one after another, width * height values each.
+     * @return The values of the artifact.
+     * @throw std::runtime_error If the computed artifact does not have the expected size.
+     */
+    CachedArray load(const std::string& artifact, unsigned int planeCount, const std::function<std::vector<std::int32_t>()>& compute) const;
+
+    const Map& getMap() const;
+};
+
+/**
+ * @brief Labels the topology of a map from the cache, computing the labels on the first use of the map.
+ *
+ * The component and region labels are the costly part of the topology and only depend on
+ * the cells, so they are stored as the "topology" artifact. The entrances between regions
+ * are found again from the labels, which only reads the sector borders.
+ *
+ * @param map The map, usually constructed with Map::Topology::Deferred.
+ * @param cache The cache of the map.
+ * @return True if the labels were mapped from the cache rather than computed.
+ * @throw std::runtime_error If the cache belongs to another map.
+ */
+bool loadTopology(Map& map, const MapCache& cache);
+
+/**
+ * @class MineFields
+ * @brief The distance from every cell to the nearest mine, and which mine that is.
+ *
+ * Both planes come from a single multi-source BFS from all mines. Among mines at the same
+ * distance, the one first in row order is taken, as findSpecifiedObject does.
+ */
+class MineFields {
+private:
+    unsigned int width;     /**< The width of the map. */
+    size_t cellCount;       /**< The number of cells of the map. */
+    CachedArray planes;     /**< The distances, then the cell index of the nearest mine, -1 where no mine can be reached. */
+
+public:
+    /**
+     * @brief Loads the fields of a map from the cache, computing them on the first use of the map.
+     * @param cache The cache of the map.
+     */
+    explicit MineFields(const MapCache& cache);
+
+    /**
+     * @brief Computes both planes of a map without a cache.
+     * @param map The map.
+     * @return The distances followed by the nearest mine indices.
+     */
+    static std::vector<std::int32_t> compute(const Map& map);
+
+    /**
+     * @brief Retrieves the distance from a cell to the nearest mine.
+     * @return The distance, or -1 if no mine can be reached.
+     */
+    int getDistance(unsigned short x, unsigned short y) const;
+
+    /**
+     * @brief Copies the distance plane.
+     * @return The distance of every cell, indexed as y * width + x.
+     */
+    std::vector<int> getDistanceField() const;
+
+    /**
+     * @brief Finds the nearest mine reachable from a cell.
+     * @return The coordinates of the mine, or std::nullopt if no mine can be reached.
+     */
+    std::optional<std::pair<unsigned short, unsigned short>> findNearest(unsigned short x, unsigned short y) const;
+
+    /**
+     * @brief Checks whether the fields were mapped from the cache rather than computed.
+     */
+    bool isCached() const;
+};
+
+#endif  // MAP_CACHE_HPP
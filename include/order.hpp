@@ -0,0 +1,37 @@
+#ifndef ORDER_HPP
+#define ORDER_HPP
+
+#include <string>
+
+/**
+ * @struct Order
+ * @brief A single line of the orders file.
+ *
+ * Orders are written as "<unit id> B <unit type>", "<unit id> M <x> <y>" or
+ * "<unit id> A <target id>".
+ */
+struct Order {
+    unsigned short unitId = 0;      /**< The ID of the unit receiving the order. */
+    char action = 0;                /**< The action: 'B' (build), 'M' (move) or 'A' (attack). */
+    char unitType = 0;              /**< The abbreviated type of the unit to build. */
+    unsigned short x = 0;           /**< The X coordinate to move to. */
+    unsigned short y = 0;           /**< The Y coordinate to move to. */
+    unsigned short targetId = 0;    /**< The ID of the unit to attack. */
+};
+
+/**
+ * @brief Formats an order as a line of the orders file, without the line break.
+ * @param order The order to format.
+ * @return The formatted order.
+ */
+std::string formatOrder(const Order& order);
+
+/**
+ * @brief Parses a line of the orders file.
+ * @param line The line to parse.
+ * @param order Receives the parsed order.
+ * @return True if the line holds a valid order, false otherwise.
+ */
+bool parseOrder(const std::string& line, Order& order);
+
+#endif  // ORDER_HPP
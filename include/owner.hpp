@@ -0,0 +1,92 @@
+#ifndef OWNER_HPP
+#define OWNER_HPP
+
+#include <cstdint>
+
+/** The ID of a player, which owns units. Players are numbered from 0. */
+using OwnerId = std::uint8_t;
+
+/** The largest number of players in a match. */
+constexpr unsigned int maxPlayers = 16;
+
+/**
+ * @class OwnerSet
+ * @brief A set of owners stored as one bit per owner.
+ *
+ * Owner sets let unit queries filter by owner without a branch per player, for instance
+ * to find "the units of every enemy of X" in a free-for-all.
+ */
+class OwnerSet {
+private:
+    std::uint16_t bits; /**< Bit i is set when owner i is in the set. */
+
+    constexpr explicit OwnerSet(std::uint16_t bits) : bits(bits) {}
+
+public:
+    /**
+     * @brief Constructs an empty set.
+     */
+    constexpr OwnerSet() : bits(0) {}
+
+    /**
+     * @brief Constructs the set holding a single owner.
+     * @param owner The owner.
+     * @return The set.
+     */
+    static constexpr OwnerSet of(OwnerId owner) {
+        return OwnerSet(static_cast<std::uint16_t>(1u << owner));
+    }
+
+    /**
+     * @brief Constructs the set of the first players of a match.
+     * @param playerCount The number of players.
+     * @return The set holding owners 0 to playerCount - 1.
+     */
+    static constexpr OwnerSet all(unsigned int playerCount = maxPlayers) {
+        return OwnerSet(static_cast<std::uint16_t>((1u << playerCount) - 1));
+    }
+
+    constexpr bool contains(OwnerId owner) const {
+        return bits >> owner & 1;
+    }
+
+    constexpr bool intersects(OwnerSet other) const {
+        return (bits & other.bits) != 0;
+    }
+
+    constexpr bool empty() const {
+        return bits == 0;
+    }
+
+    /**
+     * @brief Checks whether the set holds more than one owner.
+     * @return True if at least two owners are in the set.
+     */
+    constexpr bool hasSeveral() const {
+        return (bits & (bits - 1)) != 0;
+    }
+
+    constexpr OwnerSet without(OwnerId owner) const {
+        return OwnerSet(static_cast<std::uint16_t>(bits & ~(1u << owner)));
+    }
+
+    constexpr OwnerSet operator|(OwnerSet other) const {
+        return OwnerSet(static_cast<std::uint16_t>(bits | other.bits));
+    }
+
+    OwnerSet& operator|=(OwnerSet other) {
+        bits |= other.bits;
+        return *this;
+    }
+};
+
+/**
+ * @brief Retrieves the enemies of an owner: every other player.
+ * @param owner The owner.
+ * @return The set of every owner but the given one.
+ */
+constexpr OwnerSet enemiesOf(OwnerId owner) {
+    return OwnerSet::all().without(owner);
+}
+
+#endif  // OWNER_HPP
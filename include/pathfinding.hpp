@@ -0,0 +1,158 @@
+#ifndef PATHFINDING_HPP
+#define PATHFINDING_HPP
+
+#include "map.hpp"
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+/**
+ * @class BitBFS
+ * @brief Reusable workspace for hybrid bit-parallel BFS searches on a single map.
+ *
+ * The searches read the passable cells packed by the map and keep their buffers between
+ * searches, so one instance per thread serves any number of searches without reallocating.
+ * Wide frontiers are expanded a word of cells at a time, while narrow ones such as maze
+ * corridors are expanded cell by cell from a queue, where whole-word steps would waste
+ * most of their bits.
+ */
+class BitBFS {
+private:
+    const Map& map;                             /**< The map being searched. */
+    const BitGrid& passable;                    /**< The cells that can be entered, owned by the map. */
+    BitGrid visited;                            /**< The cells reached by the last search. */
+    BitGrid frontier;                           /**< The cells reached on the previous level. */
+    BitGrid next;                               /**< The cells reached on the current level. */
+    std::vector<int> distance;                  /**< The distances of the last search, valid for visited cells only. */
+    std::vector<std::uint32_t> cells;           /**< The frontier as cell indices while it is narrow. */
+    std::vector<std::uint32_t> nextCells;       /**< The cells reached on the current level while the frontier is narrow. */
+
+    /**
+     * @brief Runs a search, stopping after the first level that reaches the goal.
+     * @param startX The X coordinate of the starting position.
+     * @param startY The Y coordinate of the starting position.
+     * @param goal The index y * width + x of a goal cell, or -1 for none.
+     * @param goals The goal cells, or nullptr for none.
+     */
+    void run(unsigned short startX, unsigned short startY, long goal, const BitGrid* goals);
+
+public:
+    /**
+     * @brief Constructs the workspace for a map.
+     * @param map The map to search. It must outlive the workspace.
+     */
+    explicit BitBFS(const Map& map);
+
+    /**
+     * @brief Calculates the distance from the starting position to every cell.
+     * @param startX The X coordinate of the starting position.
+     * @param startY The Y coordinate of the starting position.
+     */
+    void search(unsigned short startX, unsigned short startY);
+
+    /**
+     * @brief Calculates the distances from the starting position until a goal cell is reached.
+     *
+     * Every cell no farther than the goal gets its distance, farther cells may be left out.
+     *
+     * @param startX The X coordinate of the starting position.
+     * @param startY The Y coordinate of the starting position.
+     * @param goalX The X coordinate of the goal.
+     * @param goalY The Y coordinate of the goal.
+     */
+    void searchUntil(unsigned short startX, unsigned short startY, unsigned short goalX, unsigned short goalY);
+
+    /**
+     * @brief Calculates the distances from the starting position until the nearest of several goal cells is reached.
+     *
+     * Every cell no farther than the nearest goal gets its distance, farther cells may be left out.
+     *
+     * @param startX The X coordinate of the starting position.
+     * @param startY The Y coordinate of the starting position.
+     * @param goals The goal cells.
+     */
+    void searchUntil(unsigned short startX, unsigned short startY, const BitGrid& goals);
+
+    /**
+     * @brief Retrieves the distance of a cell found by the last search.
+     * @param x The X coordinate of the cell.
+     * @param y The Y coordinate of the cell.
+     * @return The distance, or -1 if the last search has not reached the cell.
+     */
+    int getDistance(unsigned short x, unsigned short y) const {
+        return visited.test(x, y) ? distance[static_cast<size_t>(y) * map.getWidth() + x] : -1;
+    }
+
+    /**
+     * @brief Retrieves the map being searched.
+     * @return The map.
+     */
+    const Map& getMap() const;
+};
+
+/**
+ * @brief Calculates the distance from the starting position to every cell using a queue-based BFS.
+ *
+ * This is the reference implementation. Unreachable cells and obstacles are marked with -1.
+ *
+ * @param map The map to search.
+ * @param startX The X coordinate of the starting position.
+ * @param startY The Y coordinate of the starting position.
+ * @return The distance grid indexed as [y][x].
+ */
+std::vector<std::vector<int>> performBFS(const Map& map, unsigned short startX, unsigned short startY);
+
+/**
+ * @brief Calculates the same distance grid as performBFS using a BitBFS workspace.
+ *
+ * Wide BFS levels expand the frontier with shifts and masks on the passable cells packed
+ * by the map, using AVX2 when useAVX2 allows it and a portable kernel otherwise.
+ *
+ * @param map The map to search.
+ * @param startX The X coordinate of the starting position.
+ * @param startY The Y coordinate of the starting position.
+ * @return The distance grid indexed as [y][x], identical to the one returned by performBFS.
+ */
+std::vector<std::vector<int>> performBitBFS(const Map& map, unsigned short startX, unsigned short startY);
+
+/**
+ * @brief Finds the nearest cell containing the specified object.
+ * @param map The map to search.
+ * @param startX The X coordinate of the starting position.
+ * @param startY The Y coordinate of the starting position.
+ * @param object The cell character to look for.
+ * @return The coordinates of the nearest object that can be reached, or std::nullopt if there is none.
+ */
+std::optional<std::pair<unsigned short, unsigned short>> findSpecifiedObject(const Map& map, unsigned short startX, unsigned short startY,
+                                                                             char object);
+
+/**
+ * @brief Finds the nearest cell containing the specified object using an existing search workspace.
+ * @param bfs The search workspace of the map.
+ * @param startX The X coordinate of the starting position.
+ * @param startY The Y coordinate of the starting position.
+ * @param object The cell character to look for.
+ * @return The coordinates of the nearest object that can be reached, or std::nullopt if there is none.
+ */
+std::optional<std::pair<unsigned short, unsigned short>> findSpecifiedObject(BitBFS& bfs, unsigned short startX, unsigned short startY,
+                                                                             char object);
+
+/**
+ * @brief Finds the cell within a Manhattan radius that is closest to a target along passable cells.
+ *
+ * The target cell itself is never chosen, so a unit stops next to the unit it is heading for.
+ *
+ * @param bfs The search workspace of the map.
+ * @param fromX The X coordinate of the current position.
+ * @param fromY The Y coordinate of the current position.
+ * @param radius The maximum Manhattan distance of the step, usually the unit's speed.
+ * @param targetX The X coordinate of the target.
+ * @param targetY The Y coordinate of the target.
+ * @param isBlocked Optional check for cells that cannot be entered, such as cells held by enemy units.
+ * @return The chosen cell, or the current position if no cell brings the unit closer.
+ */
+std::pair<unsigned short, unsigned short> findStepTowards(BitBFS& bfs, unsigned short fromX, unsigned short fromY, unsigned short radius,
+                                                          unsigned short targetX, unsigned short targetY,
+                                                          const std::function<bool(unsigned short, unsigned short)>& isBlocked = nullptr);
+
+#endif  // PATHFINDING_HPP
@@ -11,11 +11,26 @@
  * the player's ID, name, and units.
  */
 class Player {
+public:
+    /**
+     * @struct CompactionStats
+     * @brief Counters of the sweeps that remove destroyed units.
+     */
+    struct CompactionStats {
+        size_t sweeps = 0;          /**< The number of sweeps. */
+        size_t removedUnits = 0;    /**< The total number of removed units. */
+        size_t lastRemoved = 0;     /**< The number of units removed by the last sweep. */
+        size_t lastScanned = 0;     /**< The number of units scanned by the last sweep. */
+        size_t peakUnits = 0;       /**< The largest number of stored units after a sweep. */
+    };
+
 private:
-    bool playerId; /**< The ID of the player. */
+    OwnerId playerId; /**< The ID of the player. */
     unsigned int playerGold; /**< The amount of gold player has. */
     std::string playerName; /**< The name of the player. */
     std::vector<Unit> playerUnits; /**< The units owned by the player. */
+    std::unordered_map<unsigned short, size_t> unitIndices; /**< The index of every unit in playerUnits by unit ID. */
+    CompactionStats compactionStats; /**< The counters of the sweeps. */
 
 public:
     /**
@@ -23,7 +38,7 @@ public:
      * @param id The ID of the player.
      * @param name The name of the player.
      */
-    Player(bool id, const std::string& name, unsigned int gold);
+    Player(OwnerId id, const std::string& name, unsigned int gold);
 
     unsigned int getGold() const;
 
@@ -31,7 +46,7 @@ public:
      * @brief Retrieves the ID of the player.
      * @return The ID of the player.
      */
-    bool getID() const;
+    OwnerId getID() const;
 
     /**
      * @brief Retrieves the name of the player.
@@ -41,11 +56,43 @@ public:
 
     /**
      * @brief Retrieves the units owned by the player.
+     *
+     * Units must be added with addUnitToPlayerUnits, so they can be found by their ID.
+     *
      * @return The units owned by the player.
      */
-    std::vector<Unit> getPlayerUnits();
+    std::vector<Unit>& getPlayerUnits();
 
-    Unit getUnitByID(unsigned short id);
+    /**
+     * @brief Retrieves a unit owned by the player by its ID.
+     * @param id The ID of the unit.
+     * @return The unit with the given ID.
+     * @throws std::runtime_error if the player owns no unit with the given ID.
+     */
+    Unit& getUnitByID(unsigned short id);
+
+    /**
+     * @brief Finds a unit owned by the player by its ID.
+     * @param id The ID of the unit.
+     * @return The unit with the given ID, or nullptr if the player owns no such unit.
+     */
+    Unit* findUnitByID(unsigned short id);
+
+    /**
+     * @brief Removes the destroyed units of the player.
+     *
+     * Each destroyed unit is replaced by the last unit of the list, so the order of the units
+     * changes while their IDs stay valid. References to units are invalidated.
+     *
+     * @return The number of removed units.
+     */
+    size_t removeDestroyedUnits();
+
+    /**
+     * @brief Retrieves the counters of the sweeps that remove destroyed units.
+     * @return The counters.
+     */
+    const CompactionStats& getCompactionStats() const;
 
     void setGold(unsigned int amount);
 
@@ -0,0 +1,148 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include "map.hpp"
+#include "order.hpp"
+#include "player.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/** Version of the replay format, increased whenever the format changes. */
+constexpr std::uint32_t replayVersion = 2;
+
+/**
+ * @struct ReplayUnit
+ * @brief The state of a unit after a recorded turn.
+ */
+struct ReplayUnit {
+    std::uint16_t id = 0;       /**< The ID of the unit. */
+    std::uint8_t owner = 0;     /**< The ID of the player owning the unit. */
+    char initial = 0;           /**< The abbreviated type of the unit. */
+    std::uint16_t x = 0;        /**< The X coordinate of the unit. */
+    std::uint16_t y = 0;        /**< The Y coordinate of the unit. */
+    std::uint16_t health = 0;   /**< The remaining health of the unit. */
+
+    bool operator==(const ReplayUnit& other) const;
+};
+
+/**
+ * @struct ReplayTurn
+ * @brief A recorded player turn: the orders given and the state they led to.
+ */
+struct ReplayTurn {
+    std::uint64_t time = 0;             /**< The time step of the turn. */
+    std::uint8_t playerId = 0;          /**< The ID of the player who took the turn. */
+    std::vector<std::uint32_t> gold;    /**< The gold of every player after the turn, by player ID. */
+    std::vector<Order> orders;          /**< The orders of the player, as given. */
+    std::vector<ReplayUnit> units;      /**< The units of every player after the turn, in ID order. */
+};
+
+/**
+ * @class ReplayWriter
+ * @brief Records a match into a compact replay file.
+ *
+ * The file starts with a header holding the map hash, the map dimensions and the seeds of
+ * the match. Every turn is then stored as a record holding its orders and the state of the
+ * units after it. Numbers are written as LEB128 varints. Every keyframeInterval-th record is
+ * a keyframe with the complete state, the others only hold the differences with the
+ * previous record. A seek index with the offset of every record and a fixed-size footer
+ * pointing to it close the file, so a reader can find any turn without scanning.
+ */
+class ReplayWriter {
+private:
+    std::ofstream file;                         /**< The replay file. */
+    unsigned int keyframeInterval;              /**< The number of records between keyframes. */
+    std::vector<std::uint64_t> offsets;         /**< The offset of every record so far. */
+    std::vector<ReplayUnit> previousUnits;      /**< The units of the previous record, in ID order. */
+    std::vector<std::uint32_t> previousGold;    /**< The gold of the previous record. */
+    std::string record;                         /**< The record being encoded, reused between turns. */
+    bool closed;                                /**< Whether the index and footer have been written. */
+
+public:
+    /**
+     * @brief Creates the replay file and writes its header.
+     * @param path The replay file.
+     * @param map The map of the match.
+     * @param seeds The seeds of the match, if any.
+     * @param keyframeInterval The number of records between keyframes.
+     * @throw std::runtime_error If the file cannot be created.
+     */
+    ReplayWriter(const std::string& path, const Map& map, const std::vector<std::uint64_t>& seeds, unsigned int keyframeInterval = 32);
+
+    /**
+     * @brief Closes the replay if it has not been closed yet.
+     */
+    ~ReplayWriter();
+
+    /**
+     * @brief Records a player turn.
+     * @param time The time step of the turn.
+     * @param playerId The ID of the player who took the turn.
+     * @param orders The orders of the player.
+     * @param players Every player, in any order, after the turn.
+     */
+    void addTurn(std::uint64_t time, unsigned int playerId, const std::vector<Order>& orders, const std::vector<Player*>& players);
+
+    /**
+     * @brief Writes the seek index and the footer and closes the file.
+     * @throw std::runtime_error If the file cannot be written.
+     */
+    void close();
+};
+
+/**
+ * @class ReplayReader
+ * @brief Streams the turns of a replay file.
+ *
+ * Only the header, the footer and the records being decoded are read. Seeking reads one
+ * index entry, jumps to the keyframe at or before the turn and decodes forward from there.
+ */
+class ReplayReader {
+private:
+    std::ifstream file;                     /**< The replay file. */
+    std::uint64_t mapHash;                  /**< The hash of the map. */
+    unsigned int width;                     /**< The width of the map. */
+    unsigned int height;                    /**< The height of the map. */
+    std::vector<std::uint64_t> seeds;       /**< The seeds of the match. */
+    unsigned int keyframeInterval;          /**< The number of records between keyframes. */
+    std::uint64_t turnCount;                /**< The number of records. */
+    std::uint64_t indexOffset;              /**< The offset of the seek index. */
+    std::uint64_t nextTurn;                 /**< The index of the record next() decodes. */
+    ReplayTurn current;                     /**< The last decoded record, the base of the next delta. */
+
+    std::uint64_t readIndexEntry(std::uint64_t turn);
+    void decodeRecord(ReplayTurn& turn);
+
+public:
+    /**
+     * @brief Opens a replay file and reads its header and footer.
+     * @param path The replay file.
+     * @throw std::runtime_error If the file cannot be read or is not a replay.
+     */
+    explicit ReplayReader(const std::string& path);
+
+    std::uint64_t getMapHash() const;
+    unsigned int getWidth() const;
+    unsigned int getHeight() const;
+    const std::vector<std::uint64_t>& getSeeds() const;
+    std::uint64_t getTurnCount() const;
+
+    /**
+     * @brief Positions the reader so that the next call to next() returns a given turn.
+     * @param turn The index of the turn, from 0.
+     * @throw std::runtime_error If the turn is out of range or the file is corrupted.
+     */
+    void seek(std::uint64_t turn);
+
+    /**
+     * @brief Decodes the next turn.
+     * @param turn Receives the turn.
+     * @return True if a turn was decoded, false at the end of the replay.
+     * @throw std::runtime_error If the file is corrupted.
+     */
+    bool next(ReplayTurn& turn);
+};
+
+#endif  // REPLAY_HPP
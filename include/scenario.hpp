@@ -0,0 +1,108 @@
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP
+
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @enum ScenarioKind
+ * @brief The layouts the scenario generator can produce.
+ */
+enum class ScenarioKind {
+    Open,       /**< Open ground with scattered obstacles. */
+    Maze,       /**< A maze of one-cell wide corridors. */
+    Islands,    /**< Round islands in a sea of obstacles, linked by bridges. */
+    Cave        /**< Cave-like open areas grown from smoothed noise. */
+};
+
+/**
+ * @struct ScenarioOptions
+ * @brief The parameters of a generated scenario.
+ */
+struct ScenarioOptions {
+    ScenarioKind kind = ScenarioKind::Open; /**< The layout of the map. */
+    unsigned int size = 64;                 /**< The width and height of the map. */
+    unsigned int seed = 1;                  /**< The seed of the generator. */
+    double obstacleDensity = -1.0;          /**< The share of obstacle cells, or a negative value for the default of the layout. */
+    unsigned int mineCount = 8;             /**< The number of mines. */
+    unsigned int armySize = 8;              /**< The number of units each player starts with besides its base. */
+    unsigned int gold = 2500;               /**< The gold each player starts with. */
+    unsigned int playerCount = 2;           /**< The number of players, from 2 to maxPlayers. */
+};
+
+/**
+ * @struct Scenario
+ * @brief A generated map and the status file holding the starting armies.
+ */
+struct Scenario {
+    std::vector<std::string> rows;  /**< The rows of the map, in the map file format. */
+    std::string status;             /**< The starting status, with the owner ID of every unit. */
+    unsigned int unitCount = 0;     /**< The number of units of all players, bases included. */
+};
+
+/**
+ * @brief Parses the name of a layout.
+ * @param name One of "open", "maze", "islands" and "cave".
+ * @return The layout.
+ * @throw std::runtime_error If the name is unknown.
+ */
+ScenarioKind parseScenarioKind(const std::string& name);
+
+/**
+ * @brief Retrieves the name of a layout.
+ * @param kind The layout.
+ * @return The name, as accepted by parseScenarioKind.
+ */
+std::string scenarioKindName(ScenarioKind kind);
+
+/**
+ * @brief Generates an open map with randomly scattered obstacles.
+ * @param size The width and height of the map.
+ * @param density The probability of a cell being an obstacle.
+ * @param gen The random generator.
+ * @return The rows of the map.
+ */
+std::vector<std::string> generateOpenRows(unsigned int size, double density, std::mt19937& gen);
+
+/**
+ * @brief Generates a maze with one-cell wide corridors using a randomized depth-first search.
+ * @param size The width and height of the map.
+ * @param gen The random generator.
+ * @return The rows of the map.
+ */
+std::vector<std::string> generateMazeRows(unsigned int size, std::mt19937& gen);
+
+/**
+ * @brief Generates round islands linked in a chain by straight bridges.
+ * @param size The width and height of the map.
+ * @param density The share of the map left as sea.
+ * @param gen The random generator.
+ * @return The rows of the map.
+ */
+std::vector<std::string> generateIslandRows(unsigned int size, double density, std::mt19937& gen);
+
+/**
+ * @brief Generates a cave-like map by smoothing random noise with a cellular automaton.
+ * @param size The width and height of the map.
+ * @param density The probability of a cell starting as an obstacle.
+ * @param gen The random generator.
+ * @return The rows of the map.
+ */
+std::vector<std::string> generateCaveRows(unsigned int size, double density, std::mt19937& gen);
+
+/**
+ * @brief Generates a complete scenario.
+ *
+ * The bases are placed on the passable cells closest to points spread evenly around the edge
+ * of the map, starting with two opposite corners, and marked with Map::baseMarker. All
+ * passable cells can reach each other. Mines are spread over the cells reachable from the bases, and the starting
+ * armies are placed on the free cells closest to their base.
+ *
+ * @param options The parameters of the scenario.
+ * @return The scenario.
+ * @throw std::runtime_error If the player count is invalid or the map has no room for the bases, mines and armies.
+ */
+Scenario generateScenario(const ScenarioOptions& options);
+
+#endif  // SCENARIO_HPP
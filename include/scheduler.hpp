@@ -0,0 +1,171 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include "unit.hpp"
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
+
+/**
+ * @struct ScheduledEvent
+ * @brief Something that happens to a unit at the start of a turn.
+ */
+struct ScheduledEvent {
+    /**
+     * @enum Type
+     * @brief The kinds of scheduled events.
+     */
+    enum class Type : std::uint8_t {
+        Reset,          /**< The unit gets its speed and attack back. */
+        BuildComplete   /**< The base finishes its current build and deploys the unit. */
+    };
+
+    std::uint64_t time;     /**< The turn the event happens on, see TurnScheduler::turnTime. */
+    Type type;              /**< The kind of event. */
+    OwnerId owner;          /**< The owner of the unit. */
+    unsigned short unitId;  /**< The ID of the unit, or of the base for build events. */
+};
+
+/**
+ * @class TimingWheel
+ * @brief A hierarchical timing wheel of scheduled events.
+ *
+ * Each level has 64 slots. Level 0 holds the events of the next 64 turns, one slot per
+ * turn, and every further level covers 64 times the span of the level below it. When the
+ * current time crosses the boundary of a level, the events of its current slot are spread
+ * over the lower levels. Scheduling is constant time and advancing only touches the slots
+ * that are passed.
+ */
+class TimingWheel {
+private:
+    static constexpr unsigned int slotBits = 6;                 /**< The number of time bits addressed by one level. */
+    static constexpr unsigned int slotCount = 1u << slotBits;   /**< The number of slots per level. */
+    static constexpr unsigned int levelCount = 4;               /**< The number of levels. */
+
+    std::uint64_t now;  /**< The last time that has been advanced to. */
+    std::array<std::array<std::vector<ScheduledEvent>, slotCount>, levelCount> levels; /**< The slots of every level. */
+    std::vector<ScheduledEvent> overflow;   /**< The events too far ahead for the wheel. */
+    std::vector<ScheduledEvent> ready;      /**< The events that are due. */
+    size_t pending;                         /**< The number of scheduled events not returned yet. */
+
+public:
+    /**
+     * @brief Constructs an empty wheel at time 0.
+     */
+    TimingWheel();
+
+    /**
+     * @brief Schedules an event. Events at or before the current time are returned by the next advance.
+     * @param event The event.
+     */
+    void schedule(const ScheduledEvent& event);
+
+    /**
+     * @brief Advances the wheel and collects the events that are due.
+     * @param time The time to advance to. Earlier times leave the wheel where it is.
+     * @return The due events, in the order they were scheduled for every time.
+     */
+    std::vector<ScheduledEvent> advance(std::uint64_t time);
+
+    /**
+     * @brief Retrieves the last time that has been advanced to.
+     * @return The current time.
+     */
+    std::uint64_t getTime() const;
+
+    /**
+     * @brief Retrieves the number of scheduled events that are not due yet.
+     * @return The number of events.
+     */
+    size_t size() const;
+
+private:
+    /**
+     * @brief Puts an event into the slot that matches its distance from the current time.
+     * @param event The event.
+     */
+    void place(const ScheduledEvent& event);
+};
+
+/**
+ * @class TurnScheduler
+ * @brief Schedules production and resets of the engine on a timing wheel.
+ *
+ * Time advances by one for every player turn, so the units of a player act on every
+ * playerCount-th time step. Every base has a queue of builds, the front of which is in progress. A build
+ * finishes after as many turns of its owner as its building time, and the next queued build
+ * starts right away. Units that have moved or attacked get their speed and attack back at
+ * the start of their owner's next turn. Units with nothing scheduled are never touched.
+ */
+class TurnScheduler {
+private:
+    TimingWheel wheel;                                              /**< The scheduled events. */
+    std::unordered_map<unsigned short, std::deque<Unit>> buildQueues; /**< The builds of every base by base ID. */
+    std::unordered_set<unsigned short> pendingResets;               /**< The units that have a reset scheduled. */
+    size_t maxQueueLength;                                          /**< The maximum number of builds per base. */
+    unsigned int playerCount;                                       /**< The number of players taking turns. */
+
+public:
+    /**
+     * @brief Constructs an empty scheduler.
+     * @param maxQueueLength The maximum number of builds a base can hold, including the one in progress.
+     * @param playerCount The number of players taking turns.
+     */
+    explicit TurnScheduler(size_t maxQueueLength = 5, unsigned int playerCount = 2);
+
+    /**
+     * @brief Retrieves the time of a player's turn.
+     * @param turn The turn number, starting at 0.
+     * @param owner The player.
+     * @return The time of the turn.
+     */
+    std::uint64_t turnTime(unsigned int turn, OwnerId owner) const;
+
+    /**
+     * @brief Adds a build to the queue of a base and starts it if the base is idle.
+     * @param base The base.
+     * @param unit The unit to build.
+     * @param now The current time.
+     * @throws std::runtime_error if the unit is not a base or its queue is full.
+     */
+    void enqueueBuild(const Unit& base, const Unit& unit, std::uint64_t now);
+
+    /**
+     * @brief Schedules a reset of a unit for the start of its owner's next turn.
+     * @param unit The unit that has moved or attacked.
+     * @param now The current time, during the owner's turn.
+     */
+    void scheduleReset(const Unit& unit, std::uint64_t now);
+
+    /**
+     * @brief Advances to a time and collects the events that are due.
+     * @param time The time to advance to.
+     * @return The due events.
+     */
+    std::vector<ScheduledEvent> advance(std::uint64_t time);
+
+    /**
+     * @brief Finishes the build in progress of a base and starts the next one in its queue.
+     * @param event The BuildComplete event of the base.
+     * @param base The base, or nullptr if it has been destroyed, in which case its queue is dropped.
+     * @return The finished unit, deployed on the base, or nothing if the base has been destroyed.
+     */
+    std::optional<Unit> completeBuild(const ScheduledEvent& event, const Unit* base);
+
+    /**
+     * @brief Retrieves the build in progress of a base.
+     * @param baseId The ID of the base.
+     * @return The unit being built, or nullptr if the base is idle.
+     */
+    const Unit* getCurrentBuild(unsigned short baseId) const;
+
+    /**
+     * @brief Retrieves the number of builds of a base, including the one in progress.
+     * @param baseId The ID of the base.
+     * @return The number of builds.
+     */
+    size_t getQueueLength(unsigned short baseId) const;
+};
+
+#endif  // SCHEDULER_HPP
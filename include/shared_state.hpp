@@ -0,0 +1,327 @@
+#ifndef SHARED_STATE_HPP
+#define SHARED_STATE_HPP
+
+#include "map.hpp"
+#include "order.hpp"
+#include "player.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+/** Environment variable holding the name of the game state segment. */
+constexpr const char* sharedStateVariable = "SKIRMISH_SHARED_STATE";
+/** Environment variable holding the name of the orders ring segment. */
+constexpr const char* sharedOrdersVariable = "SKIRMISH_SHARED_ORDERS";
+
+/** Identifies the segments, "SKRM" in little-endian order. */
+constexpr std::uint32_t sharedStateMagic = 0x4D524B53;
+/** Version of the binary layout, increased whenever the layout changes. */
+constexpr std::uint32_t sharedStateVersion = 2;
+
+/**
+ * @struct SharedUnit
+ * @brief A unit as stored in the game state segment.
+ */
+struct SharedUnit {
+    std::uint16_t id;       /**< The ID of the unit. */
+    std::uint16_t x;        /**< The X coordinate of the unit. */
+    std::uint16_t y;        /**< The Y coordinate of the unit. */
+    std::uint16_t health;   /**< The remaining health of the unit. */
+    std::uint8_t owner;     /**< The ID of the player owning the unit. */
+    char initial;           /**< The abbreviated type of the unit. */
+    char creation;          /**< For bases, the initial of the unit being built, or '0' when idle. */
+    std::uint8_t reserved;  /**< Padding, always 0. */
+};
+
+/**
+ * @struct SharedStateHeader
+ * @brief The start of the game state segment.
+ *
+ * The header is followed by the map cells, row by row, at mapOffset and by the unit array
+ * at unitsOffset. The writer makes the sequence odd while it updates the segment and even
+ * again once it is done, so readers retry any copy that overlapped an update.
+ */
+struct SharedStateHeader {
+    std::uint32_t magic;                /**< Always sharedStateMagic. */
+    std::uint32_t version;              /**< Always sharedStateVersion. */
+    std::atomic<std::uint32_t> sequence;/**< The seqlock sequence, odd while an update is in progress. */
+    std::uint32_t width;                /**< The width of the map. */
+    std::uint32_t height;               /**< The height of the map. */
+    std::uint32_t playerId;             /**< The ID of the player about to take its turn, 0 when all play at once. */
+    std::uint32_t playerCount;          /**< The number of players. */
+    std::uint32_t gold[maxPlayers];     /**< The gold of every player, by player ID. */
+    std::uint32_t unitCount;            /**< The number of units in the unit array. */
+    std::uint32_t unitCapacity;         /**< The number of units the unit array has room for. */
+    std::uint64_t turnTime;             /**< The time step of the turn about to be taken. */
+    std::uint64_t mapOffset;            /**< The offset of the map cells from the start of the segment. */
+    std::uint64_t unitsOffset;          /**< The offset of the unit array from the start of the segment. */
+};
+
+/**
+ * @struct SharedOrderRingHeader
+ * @brief The start of the orders ring segment, followed by capacity order slots.
+ *
+ * The bot taking its turn is the only producer and the mediator the only consumer. An
+ * order at index i lives in slot i % capacity.
+ */
+struct SharedOrderRingHeader {
+    std::uint32_t magic;                        /**< Always sharedStateMagic. */
+    std::uint32_t version;                      /**< Always sharedStateVersion. */
+    std::uint32_t capacity;                     /**< The number of order slots. */
+    std::uint32_t reserved;                     /**< Padding, always 0. */
+    std::atomic<std::uint64_t> head;            /**< The index of the next order to be pushed. */
+    std::atomic<std::uint64_t> tail;            /**< The index of the next order to be consumed. */
+    std::atomic<std::uint64_t> turnTime;        /**< The time step of the turn being taken. */
+    std::atomic<std::uint64_t> committedTurn;   /**< The time step of the last turn whose orders are complete, plus one. */
+};
+
+/**
+ * @class SharedMemory
+ * @brief A mapped POSIX shared memory object.
+ */
+class SharedMemory {
+private:
+    std::string name;   /**< The name of the object. */
+    void* address;      /**< The start of the mapping. */
+    size_t size;        /**< The size of the mapping. */
+    int descriptor;     /**< The descriptor of the object. */
+    bool owner;         /**< Whether the object is unlinked on destruction. */
+
+public:
+    /**
+     * @brief Creates a shared memory object, replacing any object with the same name.
+     * @param name The name of the object, starting with '/'.
+     * @param size The size of the object.
+     * @return The mapping, which unlinks the object when destroyed.
+     * @throw std::runtime_error If the object cannot be created or mapped.
+     */
+    static SharedMemory create(const std::string& name, size_t size);
+
+    /**
+     * @brief Maps an existing shared memory object.
+     * @param name The name of the object.
+     * @param writable Whether the mapping can be written to.
+     * @return The mapping, which leaves the object in place when destroyed.
+     * @throw std::runtime_error If the object cannot be opened or mapped.
+     */
+    static SharedMemory open(const std::string& name, bool writable);
+
+    SharedMemory(SharedMemory&& other) noexcept;
+    SharedMemory& operator=(SharedMemory&& other) = delete;
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+    ~SharedMemory();
+
+    /**
+     * @brief Grows the object and maps it again. Only the creator may resize.
+     * @param newSize The new size of the object.
+     * @throw std::runtime_error If the object cannot be resized or mapped.
+     */
+    void resize(size_t newSize);
+
+    void* getAddress() const;
+    size_t getSize() const;
+    const std::string& getName() const;
+
+private:
+    SharedMemory(const std::string& name, void* address, size_t size, int descriptor, bool owner);
+};
+
+/**
+ * @class SharedStatePublisher
+ * @brief Publishes the map and the armies to the game state segment.
+ *
+ * The map is written once. Every publish rewrites the unit array under the seqlock,
+ * growing the segment when the armies outgrow it.
+ */
+class SharedStatePublisher {
+private:
+    SharedMemory memory;    /**< The game state segment. */
+
+    SharedStateHeader& header() const;
+
+public:
+    /**
+     * @brief Creates the segment and writes the map into it.
+     * @param name The name of the segment.
+     * @param map The map of the match.
+     * @param unitCapacity The number of units to make room for initially.
+     * @throw std::runtime_error If the segment cannot be created.
+     */
+    SharedStatePublisher(const std::string& name, const Map& map, unsigned int unitCapacity = 256);
+
+    /**
+     * @brief Publishes the armies before a player's turn.
+     * @param players Every player, by ID.
+     * @param playerId The ID of the player about to take its turn, 0 when all play at once.
+     * @param turnTime The time step of the turn.
+     * @param currentBuild Returns the initial of the unit a base is building, or '0' when idle.
+     * @throw std::runtime_error If the segment cannot be grown.
+     */
+    void publish(const std::vector<Player*>& players, OwnerId playerId, std::uint64_t turnTime,
+                 const std::function<char(const Unit&)>& currentBuild);
+
+    /**
+     * @brief Retrieves the name of the segment.
+     * @return The name, as bots find it in sharedStateVariable.
+     */
+    const std::string& getName() const;
+};
+
+/**
+ * @struct SharedSnapshot
+ * @brief A consistent copy of the armies in the game state segment.
+ */
+struct SharedSnapshot {
+    std::uint32_t playerId = 0;         /**< The ID of the player about to take its turn, 0 when all play at once. */
+    std::vector<std::uint32_t> gold;    /**< The gold of every player, by player ID. */
+    std::uint64_t turnTime = 0;         /**< The time step of the turn. */
+    std::vector<SharedUnit> units;      /**< The units of every player. */
+};
+
+/**
+ * @class SharedStateView
+ * @brief A read-only mapping of the game state segment.
+ *
+ * The map cells are read in place. The armies are copied out under the seqlock, since
+ * the segment may be rewritten between turns.
+ */
+class SharedStateView {
+private:
+    SharedMemory memory;    /**< The game state segment. */
+
+    const SharedStateHeader& header() const;
+
+public:
+    /**
+     * @brief Maps the segment and checks its layout.
+     * @param name The name of the segment.
+     * @throw std::runtime_error If the segment cannot be mapped or has another layout version.
+     */
+    explicit SharedStateView(const std::string& name);
+
+    unsigned int getWidth() const;
+    unsigned int getHeight() const;
+
+    /**
+     * @brief Retrieves the map cells, row by row, without line breaks.
+     * @return The cells, valid for the lifetime of the view.
+     */
+    const char* getCells() const;
+
+    /**
+     * @brief Copies the armies out of the segment, retrying while an update is in progress.
+     * @return The snapshot.
+     */
+    SharedSnapshot snapshot() const;
+};
+
+/**
+ * @brief Fills the players of a bot from a snapshot, like readStatus does from a status file.
+ *
+ * The units of playerId go to player and the units of the other players to enemy, under the
+ * IDs of the given players, and the enemy's gold is the sum of theirs. In simultaneous turns
+ * every bot loads the same snapshot.
+ *
+ * @param snapshot The snapshot.
+ * @param playerId The ID of the player loading the snapshot.
+ * @param player Receives the gold and the units of the player.
+ * @param enemy Receives the gold and the units of the enemy.
+ * @throw std::runtime_error If a unit has an invalid type.
+ */
+void loadSnapshot(const SharedSnapshot& snapshot, unsigned int playerId, Player& player, Player& enemy);
+
+/**
+ * @class SharedOrderRing
+ * @brief The orders ring, seen from the mediator or from a bot.
+ */
+class SharedOrderRing {
+private:
+    SharedMemory memory;    /**< The orders ring segment. */
+
+    SharedOrderRingHeader& header() const;
+    Order* slots() const;
+
+    explicit SharedOrderRing(SharedMemory&& memory);
+
+public:
+    /**
+     * @brief Creates the ring. Used by the mediator.
+     * @param name The name of the segment.
+     * @param capacity The number of order slots.
+     * @return The ring.
+     * @throw std::runtime_error If the segment cannot be created.
+     */
+    static SharedOrderRing create(const std::string& name, unsigned int capacity = 65536);
+
+    /**
+     * @brief Maps an existing ring. Used by the bots.
+     * @param name The name of the segment.
+     * @return The ring.
+     * @throw std::runtime_error If the segment cannot be mapped or has another layout version.
+     */
+    static SharedOrderRing open(const std::string& name);
+
+    /**
+     * @brief Discards any leftover orders and opens the ring for a turn. Used by the mediator.
+     * @param turnTime The time step of the turn.
+     */
+    void beginTurn(std::uint64_t turnTime);
+
+    /**
+     * @brief Pushes an order. Used by the bots.
+     * @param order The order.
+     * @throw std::runtime_error If the ring is full.
+     */
+    void push(const Order& order);
+
+    /**
+     * @brief Marks the orders of the current turn as complete. Used by the bots.
+     */
+    void commit();
+
+    /**
+     * @brief Takes the orders of the current turn. Used by the mediator.
+     * @param orders Receives the orders.
+     * @return True if the bot committed its orders for the current turn, false otherwise.
+     */
+    bool drain(std::vector<Order>& orders);
+
+    /**
+     * @brief Retrieves the name of the segment.
+     * @return The name, as bots find it in sharedOrdersVariable.
+     */
+    const std::string& getName() const;
+};
+
+/**
+ * @brief Maps the game state segment named in the environment, if the mediator provides one.
+ * @return The view, or nothing if sharedStateVariable is not set.
+ * @throw std::runtime_error If the segment is named but cannot be mapped.
+ */
+std::optional<SharedStateView> openSharedState();
+
+/**
+ * @brief Loads a bot's turn from the game state segment.
+ * @param view The game state segment.
+ * @param playerId The ID of the player taking the turn.
+ * @param player Receives the gold and the units of the player.
+ * @param enemy Receives the gold and the units of the enemy.
+ * @param topology Whether to label the topology of the map, or to leave it to the caller.
+ * @return The map, built from the cells in the segment.
+ * @throw std::runtime_error If the map or a unit is invalid.
+ */
+Map loadSharedTurn(const SharedStateView& view, unsigned int playerId, Player& player, Player& enemy,
+                   Map::Topology topology = Map::Topology::Labelled);
+
+/**
+ * @brief Pushes the orders of a bot's turn into the orders ring named in the environment and commits them.
+ * @param orders The orders, in the orders file format.
+ * @throw std::runtime_error If the ring cannot be mapped or is full.
+ */
+void submitSharedOrders(const std::string& orders);
+
+#endif  // SHARED_STATE_HPP
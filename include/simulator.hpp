@@ -0,0 +1,140 @@
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include "unit.hpp"
+#include "order.hpp"
+#include "influence_map.hpp"
+#include "economy.hpp"
+#include "scheduler.hpp"
+
+/**
+ * @class Simulator
+ * @brief An in-memory copy of a game state that applies orders with the engine's rules.
+ *
+ * Moves and attacks are carried out through Unit::moveAction and Unit::attackAction, builds
+ * are queued and completed and units reset by a TurnScheduler, and the income is paid by an
+ * Economy once per round, so a simulated turn follows the same rules as a real one. Time
+ * advances by one with every turn, as in the engine with two players. The state is a plain
+ * value and can be copied cheaply to explore alternative futures. The influence map of the
+ * units is kept up to date as orders move, create and destroy units, as an overlay on the
+ * maps of the starting position so copies do not grow with the map, and so is a Zobrist
+ * hash of the units and the side to move.
+ */
+class Simulator {
+private:
+    const Map* map;                         /**< The map the game is played on. */
+    std::vector<Unit> units[2];             /**< The units of each side. */
+    unsigned int gold[2];                   /**< The gold of each side. */
+    unsigned short nextUnitId;              /**< The ID given to the next created unit. */
+    TurnScheduler scheduler;                /**< The queued builds and pending resets of both sides. */
+    std::uint64_t now;                      /**< The time of the current turn. */
+    bool roundEndingSide;                   /**< The side whose turn ends a round and is followed by the economy step. */
+    InfluenceOverlay influence;             /**< The threat and influence of the living units of both sides, shared by all copies. */
+    std::shared_ptr<const Economy> economy; /**< The economy of the map, shared by all copies. */
+    std::uint64_t hash;                     /**< The Zobrist hash of the units and the side to move. */
+
+public:
+    /**
+     * @brief Constructs a simulator from the units of both sides.
+     * @param map The map the game is played on. It must outlive the simulator.
+     * @param playerUnits The units of side 0.
+     * @param enemyUnits The units of side 1.
+     * @param playerGold The gold of side 0.
+     * @param enemyGold The gold of side 1.
+     * @param roundEndingSide The side that plays the last turn of every round, which is side 0 if its player has the highest ID.
+     */
+    Simulator(const Map& map, const std::vector<Unit>& playerUnits, const std::vector<Unit>& enemyUnits,
+              unsigned int playerGold, unsigned int enemyGold, bool roundEndingSide = true);
+
+    /**
+     * @brief Retrieves the map the game is played on.
+     * @return The map.
+     */
+    const Map& getMap() const;
+
+    /**
+     * @brief Retrieves the units of a side.
+     * @param side The side.
+     * @return The units of the side.
+     */
+    const std::vector<Unit>& getUnits(bool side) const;
+
+    /**
+     * @brief Retrieves the gold of a side.
+     * @param side The side.
+     * @return The gold of the side.
+     */
+    unsigned int getGold(bool side) const;
+
+    /**
+     * @brief Retrieves the threat and influence of the living units of both sides.
+     * @return The influence map.
+     */
+    const InfluenceOverlay& getInfluenceMap() const;
+
+    /**
+     * @brief Retrieves the Zobrist hash of the state, updated with every move, attack, creation and removal.
+     *
+     * The hash covers the type, owner, position and health of every unit and which side
+     * moves next, so it can key a TranspositionTable. Gold and building progress are not
+     * hashed.
+     *
+     * @return The hash.
+     */
+    std::uint64_t getHash() const;
+
+    /**
+     * @brief Finds a unit of a side by its ID.
+     * @param side The side.
+     * @param id The ID of the unit.
+     * @return The unit, or nullptr if the side has no unit with this ID.
+     */
+    const Unit* findUnit(bool side, unsigned short id) const;
+
+    /**
+     * @brief Applies an order of a side.
+     *
+     * Build orders are queued on the base if the side can pay the cost of the unit and the queue is not full.
+     *
+     * @param side The side giving the order.
+     * @param order The order.
+     * @return True if the order has been carried out, false if the rules rejected it.
+     */
+    bool applyOrder(bool side, const Order& order);
+
+    /**
+     * @brief Ends the turn of a side.
+     *
+     * Destroyed units of both sides are removed, then the builds and resets due at the start
+     * of the next turn are carried out. If the turn ends the round, the workers of both sides
+     * on mines earn gold.
+     *
+     * @param side The side ending its turn.
+     */
+    void endTurn(bool side);
+
+    /**
+     * @brief Checks whether a side has lost its base.
+     * @param side The side.
+     * @return True if the side has no base left, false otherwise.
+     */
+    bool isBaseDestroyed(bool side) const;
+
+private:
+    /**
+     * @brief Finds a unit of a side by its ID for modification.
+     * @param side The side.
+     * @param id The ID of the unit.
+     * @return The unit, or nullptr if the side has no unit with this ID.
+     */
+    Unit* findMutableUnit(bool side, unsigned short id);
+
+    /**
+     * @brief Adds a finished unit to its side.
+     * @param side The side.
+     * @param unit The finished unit.
+     */
+    void addUnit(bool side, const std::optional<Unit>& unit);
+};
+
+#endif  // SIMULATOR_HPP
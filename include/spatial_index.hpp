@@ -0,0 +1,115 @@
+#ifndef SPATIAL_INDEX_HPP
+#define SPATIAL_INDEX_HPP
+
+#include "unit.hpp"
+
+/**
+ * @class SpatialIndex
+ * @brief A uniform grid of buckets holding the positions of the units of every owner.
+ *
+ * The index is rebuilt from the unit lists once per turn. Radius and nearest-unit queries
+ * only visit the buckets around the query position, so their cost depends on the number
+ * of units nearby instead of the size of the armies. Every bucket also records the set of
+ * owners it holds, so queries filtered by owner skip the buckets holding none of them.
+ */
+class SpatialIndex {
+public:
+    /**
+     * @struct Entry
+     * @brief A unit stored in the index.
+     */
+    struct Entry {
+        unsigned short id;  /**< The ID of the unit. */
+        unsigned short x;   /**< The X position of the unit. */
+        unsigned short y;   /**< The Y position of the unit. */
+        OwnerId owner;      /**< The owner of the unit. */
+        const Unit* unit;   /**< The indexed unit. */
+    };
+
+private:
+    unsigned int width;         /**< The width of the map. */
+    unsigned int height;        /**< The height of the map. */
+    unsigned int cellSize;      /**< The width and height of a bucket in map cells. */
+    unsigned int bucketsX;      /**< The number of bucket columns. */
+    unsigned int bucketsY;      /**< The number of bucket rows. */
+    std::vector<unsigned int> bucketStart;  /**< The index of the first entry of each bucket, plus a final end index. */
+    std::vector<Entry> entries;             /**< The entries of all owners sorted by bucket. */
+    std::vector<OwnerSet> bucketOwners;     /**< The owners holding units in each bucket. */
+    std::unordered_map<unsigned short, Entry> byId; /**< The entries of all owners by unit ID. */
+
+public:
+    /**
+     * @brief Constructs an empty index for a map.
+     * @param width The width of the map.
+     * @param height The height of the map.
+     * @param cellSize The width and height of a bucket in map cells.
+     */
+    SpatialIndex(unsigned int width, unsigned int height, unsigned int cellSize = 8);
+
+    /**
+     * @brief Rebuilds the index from the current unit lists.
+     *
+     * Entries point into the given lists, which must not be modified until the next rebuild.
+     * Units with 0 health are left out.
+     *
+     * @param armies The unit lists to index, of any number of owners.
+     */
+    void rebuild(const std::vector<const std::vector<Unit>*>& armies);
+
+    /**
+     * @brief Finds a unit by its ID.
+     * @param id The ID of the unit.
+     * @return The entry of the unit, or nullptr if the unit is not indexed.
+     */
+    const Entry* find(unsigned short id) const;
+
+    /**
+     * @brief Finds the units of some owners within a Manhattan radius of a position.
+     * @param owners The owners of the units, e.g. enemiesOf(player).
+     * @param x The X coordinate of the position.
+     * @param y The Y coordinate of the position.
+     * @param radius The maximum Manhattan distance.
+     * @return The entries of the units within the radius.
+     */
+    std::vector<Entry> withinRange(OwnerSet owners, unsigned short x, unsigned short y, unsigned short radius) const;
+
+    /**
+     * @brief Finds the units of some owners closest to a position by Manhattan distance.
+     * @param owners The owners of the units, e.g. enemiesOf(player).
+     * @param x The X coordinate of the position.
+     * @param y The Y coordinate of the position.
+     * @param k The maximum number of units to return.
+     * @return Up to k entries sorted by increasing distance, ties broken by unit ID.
+     */
+    std::vector<Entry> kNearest(OwnerSet owners, unsigned short x, unsigned short y, size_t k) const;
+
+    /**
+     * @brief Checks whether a unit of some owners stands on a position.
+     * @param owners The owners of the units.
+     * @param x The X coordinate of the position.
+     * @param y The Y coordinate of the position.
+     * @return True if such a unit is indexed at the position, false otherwise.
+     */
+    bool isOccupied(OwnerSet owners, unsigned short x, unsigned short y) const;
+
+    /**
+     * @brief Checks whether a unit is within a Manhattan radius of a position.
+     * @param id The ID of the unit.
+     * @param x The X coordinate of the position.
+     * @param y The Y coordinate of the position.
+     * @param radius The maximum Manhattan distance.
+     * @return True if the unit is indexed and within the radius, false otherwise.
+     */
+    bool isWithinRange(unsigned short id, unsigned short x, unsigned short y, unsigned short radius) const;
+
+private:
+    /**
+     * @brief Retrieves the bucket holding a position.
+     * @param x The X coordinate of the position.
+     * @param y The Y coordinate of the position.
+     * @return The index of the bucket.
+     */
+    unsigned int bucketOf(unsigned short x, unsigned short y) const;
+};
+
+#endif  // SPATIAL_INDEX_HPP
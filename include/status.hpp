@@ -0,0 +1,73 @@
+#ifndef STATUS_HPP
+#define STATUS_HPP
+
+#include "player.hpp"
+#include <istream>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Creates a unit of the status from the prototype of its type.
+ * @param owner The ID of the player the unit is given to.
+ * @param initial The abbreviated type of the unit.
+ * @param id The ID of the unit.
+ * @param x The X coordinate of the unit.
+ * @param y The Y coordinate of the unit.
+ * @param health The remaining health of the unit.
+ * @return The unit.
+ * @throw std::runtime_error If the unit type or the owner is invalid, or the health is above the maximum of the type.
+ */
+Unit makeStatusUnit(OwnerId owner, char initial, unsigned short id, unsigned short x, unsigned short y, unsigned short health);
+
+/**
+ * @brief Parses the contents of a status file into both armies in a single pass.
+ *
+ * The status does not depend on who reads it. The first line holds the gold of every player
+ * in ID order, and every following line describes a unit, starting with the ID of its owner.
+ * The units and the gold of playerId go to the player and the others to the enemy, under the
+ * IDs of the given players: a bot reading as player 1 still sees its own units owned by its
+ * Player object. With more than two players, the units of every other player go to the enemy
+ * and the enemy's gold is the sum of theirs. A single gold value is given to both players. The buffer is scanned in
+ * place, without allocating per line, and units are copied from per-type prototypes instead
+ * of being looked up by name.
+ *
+ * @param buffer The contents of the status file.
+ * @param playerId The ID of the player reading the status.
+ * @param player Receives the gold and the units of playerId.
+ * @param enemy Receives the gold and the units of the other players.
+ * @throw std::runtime_error If the gold is not a number, or a unit line is missing a field, has a number out of range,
+ *        an invalid type or more health than its type allows.
+ */
+void parseStatus(std::string_view buffer, unsigned int playerId, Player& player, Player& enemy);
+
+/**
+ * @brief Parses the contents of a status file into the armies of every player.
+ *
+ * Unlike the two-sided overload, every player keeps its own units and gold, as the mediator
+ * needs them. A single gold value is given to every player.
+ *
+ * @param buffer The contents of the status file.
+ * @param players The players, by ID.
+ * @throw std::runtime_error If the status is invalid as for the two-sided overload, or a unit has an owner without a player.
+ */
+void parseStatus(std::string_view buffer, const std::vector<Player*>& players);
+
+/**
+ * @brief Reads a whole status stream with a single read and parses it with parseStatus.
+ * @param statusFile The status stream.
+ * @param playerId The ID of the player reading the status.
+ * @param player Receives the gold and the units of playerId.
+ * @param enemy Receives the gold and the units of the other players.
+ * @throw std::runtime_error If the status is invalid, see parseStatus.
+ */
+void readStatus(std::istream& statusFile, unsigned int playerId, Player& player, Player& enemy);
+
+/**
+ * @brief Reads a whole status stream with a single read and parses it into every player's army.
+ * @param statusFile The status stream.
+ * @param players The players, by ID.
+ * @throw std::runtime_error If the status is invalid or a unit has an owner without a player, see parseStatus.
+ */
+void readStatus(std::istream& statusFile, const std::vector<Player*>& players);
+
+#endif  // STATUS_HPP
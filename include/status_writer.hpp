@@ -0,0 +1,91 @@
+#ifndef STATUS_WRITER_HPP
+#define STATUS_WRITER_HPP
+
+#include "player.hpp"
+#include "scheduler.hpp"
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Serializes the canonical status of the match into a buffer.
+ *
+ * The status is the same whichever player reads it. The first line holds the gold of every
+ * player in ID order, followed by one line per unit starting with the ID of its owner, from
+ * "0 ..." up to maxPlayers - 1. Bases end with the initial of the unit they are building, or
+ * 0 when idle. Numbers are formatted with std::to_chars and the buffer is reused, so no
+ * allocation happens once it has grown large enough.
+ *
+ * @param buffer Receives the status, replacing its previous contents.
+ * @param players The players, in ID order.
+ * @param scheduler The scheduler holding the builds in progress.
+ */
+void serializeStatus(std::string& buffer, const std::vector<Player*>& players, const TurnScheduler& scheduler);
+
+/**
+ * @class StatusWriter
+ * @brief Publishes status snapshots to disk from a background thread.
+ *
+ * The writer owns two buffers. The mediator fills the back buffer while the writer thread
+ * writes the front one, so serializing the next snapshot never waits for the disk. Each
+ * snapshot is written to a temporary file with a single write and renamed over the status
+ * file, so the bots never see a partially written status.
+ */
+class StatusWriter {
+private:
+    std::filesystem::path path;         /**< The status file. */
+    std::filesystem::path temporaryPath;/**< The file snapshots are written to before being renamed. */
+    std::string buffers[2];             /**< The front buffer being written and the back buffer being filled. */
+    int back;                           /**< The index of the back buffer. */
+    bool pending;                       /**< Whether the front buffer holds a snapshot still to be written. */
+    bool stopping;                      /**< Whether the writer thread should exit once idle. */
+    std::string error;                  /**< The first error met by the writer thread. */
+    std::mutex mutex;                   /**< Guards the state shared with the writer thread. */
+    std::condition_variable changed;    /**< Signals a new snapshot, a finished write or a stop. */
+    std::thread thread;                 /**< The writer thread. */
+
+    void run();
+    void writeSnapshot(const std::string& contents);
+
+public:
+    /**
+     * @brief Starts the writer thread.
+     * @param path The status file to publish the snapshots to.
+     */
+    explicit StatusWriter(const std::filesystem::path& path);
+
+    /**
+     * @brief Writes the last published snapshot and stops the writer thread.
+     */
+    ~StatusWriter();
+
+    StatusWriter(const StatusWriter&) = delete;
+    StatusWriter& operator=(const StatusWriter&) = delete;
+
+    /**
+     * @brief Retrieves the back buffer to serialize the next snapshot into.
+     * @return The back buffer, owned by the caller until publish is called.
+     */
+    std::string& getBackBuffer();
+
+    /**
+     * @brief Hands the back buffer over to the writer thread.
+     *
+     * Waits only if the previous snapshot has not been written yet, since its buffer becomes
+     * the new back buffer.
+     *
+     * @throw std::runtime_error If a previous snapshot could not be written.
+     */
+    void publish();
+
+    /**
+     * @brief Waits until every published snapshot is on disk.
+     * @throw std::runtime_error If a snapshot could not be written.
+     */
+    void flush();
+};
+
+#endif  // STATUS_WRITER_HPP
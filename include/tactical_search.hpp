@@ -0,0 +1,98 @@
+#ifndef TACTICAL_SEARCH_HPP
+#define TACTICAL_SEARCH_HPP
+
+#include "unit.hpp"
+#include "order.hpp"
+#include "spatial_index.hpp"
+#include "transposition_table.hpp"
+#include "deadline.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct Skirmish
+ * @brief A local fight: a few units of one side and the enemy units they can reach this turn.
+ *
+ * Side 0 is the side searching for its orders, side 1 every enemy. Units of both sides are
+ * sorted by ID, the order the mediator carries out orders in.
+ */
+struct Skirmish {
+    std::vector<Unit> units[2]; /**< The units of each side. */
+};
+
+/**
+ * @struct TacticalResult
+ * @brief The orders chosen by a tactical search for the units of side 0.
+ */
+struct TacticalResult {
+    std::vector<unsigned short> unitIds;    /**< The units whose orders were decided. A decided unit without orders stays in place. */
+    std::vector<Order> orders;              /**< The orders, in unit ID order, a move before an attack of the same unit. */
+    int value = 0;                          /**< The material balance at the horizon of the last completed iteration. */
+    unsigned int depth = 0;                 /**< The depth of the last completed iteration, in unit actions. */
+    size_t nodes = 0;                       /**< The number of positions visited. */
+    TranspositionStatistics statistics;     /**< The use of the transposition table by this search alone. */
+};
+
+/**
+ * @class TacticalSearch
+ * @brief Depth-limited alpha-beta search over the move and attack orders of a skirmish.
+ *
+ * Every ply is the action of a single unit: a move to one of a few candidate cells (stay,
+ * close in while keeping an attack, close in as far as possible, fall back), optionally
+ * followed by an attack on an enemy in range. Units act in ID order, and once every unit
+ * of a side has acted the other side takes its turn. Orders are carried out with the
+ * engine's own Unit::moveAction and Unit::attackAction, and the Zobrist hash of the
+ * position is updated around those calls, so positions reached along
+ * different lines share their transposition table entry. The search deepens iteratively
+ * until the maximum depth, the node limit or the cancellation of the token, and returns
+ * the orders of the last completed iteration.
+ */
+class TacticalSearch {
+public:
+    static constexpr unsigned int defaultMaxDepth = 8;      /**< Unit actions searched by default. */
+    static constexpr size_t defaultNodeLimit = 200000;      /**< Positions visited by default. */
+
+private:
+    const Map& map;                 /**< The map the skirmish is fought on. */
+    TranspositionTable& table;      /**< The table, possibly shared with searches on other threads. */
+    unsigned int maxDepth;          /**< The deepest iteration, in unit actions. */
+    size_t nodeLimit;               /**< The number of positions after which the search stops. */
+
+public:
+    /**
+     * @brief Constructs a search.
+     * @param map The map the skirmishes are fought on. It must outlive the search.
+     * @param table The transposition table. It must outlive the search.
+     * @param maxDepth The deepest iteration, in unit actions.
+     * @param nodeLimit The number of positions after which the search stops.
+     */
+    TacticalSearch(const Map& map, TranspositionTable& table, unsigned int maxDepth = defaultMaxDepth,
+                   size_t nodeLimit = defaultNodeLimit);
+
+    /**
+     * @brief Searches the orders of side 0 for a skirmish.
+     * @param skirmish The skirmish. Side 0 moves first, with every unit ready to act.
+     * @param token Stops the search, which then returns the orders of the last completed iteration.
+     * @return The orders, empty if not even the first iteration completed.
+     */
+    TacticalResult search(const Skirmish& skirmish, const CancellationToken& token = CancellationToken()) const;
+};
+
+/**
+ * @brief Groups the fighting units of a side into skirmishes.
+ *
+ * A unit other than a base or a worker is engaged when an enemy unit is within its speed
+ * plus its attack range. Engaged units sharing an enemy in reach fight in the same
+ * skirmish. Skirmishes with more units per side than the limit are left out, their units
+ * are better served by simpler rules than by a search that cannot finish.
+ *
+ * @param units The units of the side.
+ * @param enemyIndex The index of the enemy units.
+ * @param enemies The owners of the enemy units.
+ * @param maxUnitsPerSide The largest number of units of either side in a skirmish.
+ * @return The skirmishes.
+ */
+std::vector<Skirmish> findSkirmishes(const std::vector<Unit>& units, const SpatialIndex& enemyIndex, OwnerSet enemies,
+                                     size_t maxUnitsPerSide);
+
+#endif  // TACTICAL_SEARCH_HPP
@@ -0,0 +1,155 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @enum TelemetryEncoding
+ * @brief How the values of a telemetry column are stored in a row group.
+ */
+enum class TelemetryEncoding : std::uint8_t {
+    Varint = 0,         /**< Unsigned LEB128 varints. */
+    Delta = 1,          /**< Zigzag varints of the difference with the previous row. */
+    Dictionary = 2      /**< A dictionary of distinct strings followed by one varint code per row. */
+};
+
+/**
+ * @struct TelemetryRow
+ * @brief The record of one unit after one player turn.
+ */
+struct TelemetryRow {
+    std::uint64_t time = 0;     /**< The time step of the turn. */
+    std::uint8_t owner = 0;     /**< The ID of the player owning the unit. */
+    std::uint16_t unitId = 0;   /**< The ID of the unit. */
+    std::string type;           /**< The type of the unit. */
+    std::uint16_t x = 0;        /**< The X coordinate of the unit after the turn. */
+    std::uint16_t y = 0;        /**< The Y coordinate of the unit after the turn. */
+    std::uint16_t health = 0;   /**< The remaining health of the unit after the turn. */
+    std::uint32_t damage = 0;   /**< The damage dealt by the unit during the turn. */
+    std::string orders;         /**< The actions ordered to the unit during the turn, such as "M" or "MA". */
+};
+
+/**
+ * @class TelemetryWriter
+ * @brief Streams telemetry rows into a columnar file.
+ *
+ * Rows are buffered column by column and flushed as a row group every rowGroupSize rows,
+ * so memory stays bounded however long the run is. Within a row group every column is a
+ * separate chunk: the time, X and Y columns are delta encoded, the type and orders columns
+ * dictionary encoded and the others plain varints. A footer lists the offset and length of
+ * every chunk, so readers only read the columns they need.
+ */
+class TelemetryWriter {
+private:
+    std::ofstream file;                     /**< The telemetry file. */
+    size_t rowGroupSize;                    /**< The number of rows per row group. */
+    std::vector<std::uint64_t> times;       /**< The buffered time column. */
+    std::vector<std::uint64_t> owners;      /**< The buffered owner column. */
+    std::vector<std::uint64_t> unitIds;     /**< The buffered unit ID column. */
+    std::vector<std::string> types;         /**< The buffered type column. */
+    std::vector<std::uint64_t> xs;          /**< The buffered X column. */
+    std::vector<std::uint64_t> ys;          /**< The buffered Y column. */
+    std::vector<std::uint64_t> healths;     /**< The buffered health column. */
+    std::vector<std::uint64_t> damages;     /**< The buffered damage column. */
+    std::vector<std::string> orders;        /**< The buffered orders column. */
+    std::string footer;                     /**< The encoded locations of the flushed row groups. */
+    std::uint64_t rowGroupCount;            /**< The number of flushed row groups. */
+    bool closed;                            /**< Whether the footer has been written. */
+
+    void flushRowGroup();
+
+public:
+    /**
+     * @brief Creates the telemetry file and writes its header.
+     * @param path The telemetry file.
+     * @param rowGroupSize The number of rows buffered before they are flushed.
+     * @throw std::runtime_error If the file cannot be created.
+     */
+    explicit TelemetryWriter(const std::string& path, size_t rowGroupSize = 16384);
+
+    /**
+     * @brief Closes the file if it has not been closed yet.
+     */
+    ~TelemetryWriter();
+
+    /**
+     * @brief Appends a row, flushing a row group when the buffer is full.
+     * @param row The row.
+     */
+    void addRow(const TelemetryRow& row);
+
+    /**
+     * @brief Flushes the buffered rows, writes the footer and closes the file.
+     * @throw std::runtime_error If the file cannot be written.
+     */
+    void close();
+};
+
+/**
+ * @class TelemetryReader
+ * @brief Reads single columns of single row groups from a telemetry file.
+ */
+class TelemetryReader {
+private:
+    struct Chunk {
+        std::uint64_t offset;   /**< The offset of the chunk in the file. */
+        std::uint64_t length;   /**< The length of the chunk. */
+    };
+    struct RowGroup {
+        std::uint64_t rowCount;     /**< The number of rows. */
+        std::vector<Chunk> chunks;  /**< The chunk of every column, in column order. */
+    };
+
+    std::ifstream file;                 /**< The telemetry file. */
+    std::vector<RowGroup> rowGroups;    /**< The location of every row group. */
+
+    std::string readChunk(size_t rowGroup, const std::string& column);
+
+public:
+    /**
+     * @brief Opens a telemetry file and reads its footer.
+     * @param path The telemetry file.
+     * @throw std::runtime_error If the file cannot be read or is not a telemetry file.
+     */
+    explicit TelemetryReader(const std::string& path);
+
+    /**
+     * @brief Retrieves the names of the columns, in file order.
+     * @return The names.
+     */
+    static const std::vector<std::string>& getColumnNames();
+
+    /**
+     * @brief Retrieves the encoding of a column.
+     * @param column The name of the column.
+     * @return The encoding.
+     * @throw std::runtime_error If the column does not exist.
+     */
+    static TelemetryEncoding getEncoding(const std::string& column);
+
+    size_t getRowGroupCount() const;
+    std::uint64_t getRowCount(size_t rowGroup) const;
+
+    /**
+     * @brief Reads a numeric column of a row group.
+     * @param rowGroup The index of the row group.
+     * @param column The name of the column.
+     * @return The values, one per row.
+     * @throw std::runtime_error If the column is not numeric or the file is corrupted.
+     */
+    std::vector<std::int64_t> readNumbers(size_t rowGroup, const std::string& column);
+
+    /**
+     * @brief Reads a dictionary-encoded column of a row group.
+     * @param rowGroup The index of the row group.
+     * @param column The name of the column.
+     * @return The values, one per row.
+     * @throw std::runtime_error If the column is not dictionary encoded or the file is corrupted.
+     */
+    std::vector<std::string> readStrings(size_t rowGroup, const std::string& column);
+};
+
+#endif  // TELEMETRY_HPP
@@ -0,0 +1,99 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <memory>
+
+/**
+ * @class ThreadPool
+ * @brief A fixed-size pool of worker threads with per-worker task queues and work stealing.
+ *
+ * Tasks of a batch are spread over the worker queues. Each worker takes tasks from the
+ * front of its own queue and steals from the back of the other queues once its own queue
+ * is empty. The calling thread takes part in every batch as worker 0.
+ */
+class ThreadPool {
+private:
+    /**
+     * @struct WorkerQueue
+     * @brief The task indices assigned to a single worker.
+     */
+    struct WorkerQueue {
+        std::mutex mutex;           /**< Guards the task indices. */
+        std::deque<size_t> tasks;   /**< The indices of the tasks waiting to be run. */
+    };
+
+    std::vector<std::thread> threads;                   /**< The background worker threads. */
+    std::vector<std::unique_ptr<WorkerQueue>> queues;   /**< One task queue per worker. */
+
+    std::mutex batchMutex;                  /**< Guards the batch state below. */
+    std::condition_variable batchStarted;   /**< Wakes the workers when a batch starts. */
+    std::condition_variable batchFinished;  /**< Wakes the caller when the last task has finished. */
+    const std::function<void(size_t, unsigned int)>* task = nullptr; /**< The task of the current batch. */
+    unsigned long generation = 0;           /**< Incremented for every batch. */
+    bool stopping = false;                  /**< Set when the pool is being destroyed. */
+    std::atomic<size_t> remaining{0};       /**< The number of tasks of the current batch left to run. */
+    std::exception_ptr failure;             /**< The first exception thrown by a task of the current batch. */
+
+public:
+    /**
+     * @brief Constructs a thread pool.
+     * @param threadCount The number of workers including the calling thread. 0 selects the number of hardware threads.
+     */
+    explicit ThreadPool(unsigned int threadCount = 0);
+
+    /**
+     * @brief Stops and joins the worker threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Retrieves the number of workers, including the calling thread.
+     * @return The number of workers. Worker indices passed to tasks are below this value.
+     */
+    unsigned int size() const;
+
+    /**
+     * @brief Runs task(index, worker) for every index in [0, count) and waits for all of them.
+     *
+     * The worker index can be used to select per-thread scratch space. If any task throws,
+     * the first exception is rethrown once the batch has finished.
+     *
+     * @param count The number of tasks.
+     * @param task The task to run.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t, unsigned int)>& task);
+
+private:
+    /**
+     * @brief The main loop of a background worker.
+     * @param worker The index of the worker.
+     */
+    void workerLoop(unsigned int worker);
+
+    /**
+     * @brief Runs tasks of the current batch until none are left in any queue.
+     * @param worker The index of the worker.
+     */
+    void runTasks(unsigned int worker);
+
+    /**
+     * @brief Takes the next task for a worker, stealing from other queues when its own is empty.
+     * @param worker The index of the worker.
+     * @param index Receives the task index.
+     * @return True if a task was taken, false if all queues are empty.
+     */
+    bool takeTask(unsigned int worker, size_t& index);
+};
+
+#endif  // THREAD_POOL_HPP
@@ -0,0 +1,155 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** Environment variable naming the directory the traces are written to. Tracing is off when it is not set. */
+constexpr const char* traceDirectoryVariable = "SKIRMISH_TRACE_DIR";
+/** Environment variable holding the ID of the match, shared by the mediator and every bot process it starts. */
+constexpr const char* traceMatchVariable = "SKIRMISH_TRACE_MATCH";
+
+/** The trace lane of the mediator. The bot of player N is traced on lane N + traceBotLane. */
+constexpr std::uint32_t traceMediatorLane = 1;
+/** The trace lane of the bot of the first player. */
+constexpr std::uint32_t traceBotLane = 2;
+
+/**
+ * @struct TraceEvent
+ * @brief A completed span of one thread.
+ */
+struct TraceEvent {
+    const char* name;           /**< The name of the span, a string literal. */
+    const char* category;       /**< The category of the span, a string literal. */
+    std::uint64_t start;        /**< The start of the span, in microseconds of the shared clock. */
+    std::uint64_t duration;     /**< The duration of the span, in microseconds. */
+    std::uint32_t thread;       /**< The ID of the thread in the operating system. */
+    const char* argumentName;   /**< The name of the integer argument of the span, or nullptr. */
+    std::int64_t argument;      /**< The value of the integer argument. */
+};
+
+/**
+ * @class Tracer
+ * @brief Buffers the spans of a process and writes them as Chrome trace-event JSON at exit.
+ *
+ * Every process of a match records into its own buffer and writes its own file,
+ * <directory>/<match>_<pid>.json, so processes never contend for a file. Timestamps come
+ * from the monotonic clock of the system, which every process on the machine shares, and
+ * every process of a match writes to the same lane whichever process played the turn, so
+ * the files of a match merge into one timeline (see mergeTraces). When the trace directory
+ * is not set in the environment, spans only check that tracing is off and nothing is written.
+ */
+class Tracer {
+private:
+    bool enabled;                   /**< Whether spans are recorded. */
+    bool flushed;                   /**< Whether the buffer has been written. */
+    std::string directory;          /**< The directory the trace is written to. */
+    std::uint32_t lane;             /**< The lane of the process in the timeline. */
+    std::string processName;        /**< The name of the lane. */
+    std::vector<TraceEvent> events; /**< The completed spans. */
+    std::mutex mutex;               /**< Guards the buffer, spans end on any thread. */
+
+    Tracer();
+
+public:
+    /**
+     * @brief Writes the buffer if it has not been written yet.
+     */
+    ~Tracer();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    /**
+     * @brief Retrieves the tracer of the process, configured from the environment on first use.
+     * @return The tracer.
+     */
+    static Tracer& get();
+
+    /**
+     * @brief Reads the shared clock.
+     * @return The time in microseconds.
+     */
+    static std::uint64_t now();
+
+    /**
+     * @brief Checks whether spans are recorded.
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Names the lane of the process in the timeline.
+     * @param lane The lane, traceMediatorLane or the lane of a bot.
+     * @param name The name shown for the lane.
+     */
+    void setProcess(std::uint32_t lane, const std::string& name);
+
+    /**
+     * @brief Appends a completed span to the buffer.
+     * @param event The span.
+     */
+    void record(const TraceEvent& event);
+
+    /**
+     * @brief Writes the buffered spans to the trace file of the process and stops recording.
+     * @return The path of the file, empty if tracing is off or the file cannot be written.
+     */
+    std::string flush();
+};
+
+/**
+ * @class TraceSpan
+ * @brief Records the time between its construction and its destruction as a span.
+ */
+class TraceSpan {
+private:
+    const char* name;           /**< The name of the span. */
+    const char* category;       /**< The category of the span. */
+    const char* argumentName;   /**< The name of the argument, or nullptr. */
+    std::int64_t argument;      /**< The value of the argument. */
+    std::uint64_t start;        /**< The start of the span, 0 when tracing is off. */
+
+public:
+    /**
+     * @brief Starts a span.
+     * @param name The name of the span. It must be a string literal.
+     * @param category The category of the span. It must be a string literal.
+     * @param argumentName The name of an integer shown with the span, such as "turn", or nullptr.
+     * @param argument The value of the integer.
+     */
+    explicit TraceSpan(const char* name, const char* category = "skirmish", const char* argumentName = nullptr,
+                       std::int64_t argument = 0);
+
+    /**
+     * @brief Ends the span and records it.
+     */
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+/**
+ * @brief Retrieves the trace directory named by the environment.
+ * @return The directory, empty if tracing is off.
+ */
+std::string getTraceDirectory();
+
+/**
+ * @brief Retrieves the ID of the match named by the environment.
+ * @return The ID, "match_<pid>" of the calling process if it is not set.
+ */
+std::string getTraceMatch();
+
+/**
+ * @brief Merges the trace files of every process of a match into <directory>/<match>.json and removes them.
+ * @param directory The trace directory.
+ * @param match The ID of the match.
+ * @return The path of the merged trace.
+ * @throw std::runtime_error If the merged trace cannot be written.
+ */
+std::string mergeTraces(const std::string& directory, const std::string& match);
+
+#endif  // TRACE_HPP
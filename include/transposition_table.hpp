@@ -0,0 +1,147 @@
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @struct TranspositionEntry
+ * @brief The result of searching a position, as stored in a transposition table.
+ */
+struct TranspositionEntry {
+    /**
+     * @brief How the value relates to the true value of the position.
+     */
+    enum class Bound : std::uint8_t {
+        None = 0,   /**< Marks an empty slot, never stored. */
+        Exact = 1,  /**< The value is exact. */
+        Lower = 2,  /**< The search failed high, the true value is at least the value. */
+        Upper = 3   /**< The search failed low, the true value is at most the value. */
+    };
+
+    std::int32_t value = 0;         /**< The value of the position for the side to move. */
+    std::uint8_t depth = 0;         /**< The remaining depth the position was searched to. */
+    Bound bound = Bound::None;      /**< How the value relates to the true value. */
+    std::uint8_t bestMove = 0;      /**< The index of the best move found, in the order moves are generated. */
+};
+
+/**
+ * @struct TranspositionStatistics
+ * @brief Counters of the use of a transposition table.
+ *
+ * Every search counts its own lookups and writes in a local copy and adds it to the table
+ * once it is done, so threads sharing a table never write the same counter while searching.
+ */
+struct TranspositionStatistics {
+    std::uint64_t probes = 0;       /**< Lookups. */
+    std::uint64_t hits = 0;         /**< Lookups that found the position. */
+    std::uint64_t stores = 0;       /**< Entries written. */
+    std::uint64_t replacements = 0; /**< Entries written over an entry of another position. */
+
+    /**
+     * @brief Computes the share of lookups that found the position.
+     * @return The hit rate, 0 when nothing has been looked up.
+     */
+    double getHitRate() const;
+
+    /**
+     * @brief Adds the counters of another search.
+     * @param other The counters to add.
+     */
+    void add(const TranspositionStatistics& other);
+};
+
+/**
+ * @class TranspositionTable
+ * @brief A fixed-size table of searched positions, shared by any number of threads without locks.
+ *
+ * Every slot holds the entry packed into one 64-bit word and a check word, the XOR of the
+ * entry and the position's hash. Both are written with relaxed atomic stores, so a reader
+ * racing a writer may see the words of two different writes, but then the check fails and
+ * the slot reads as a miss. Slots are grouped in buckets of four. A position goes to the
+ * bucket given by the low bits of its hash, and evicts the slot of the same position, an
+ * empty slot, or else the slot least worth keeping: the shallowest, counting entries from
+ * earlier searches as shallower the older they are.
+ */
+class TranspositionTable {
+public:
+    static constexpr size_t bucketSize = 4;     /**< The number of slots per bucket. */
+
+private:
+    /**
+     * @struct Slot
+     * @brief One entry and its check word.
+     */
+    struct Slot {
+        std::atomic<std::uint64_t> check;   /**< The hash of the position XOR data. */
+        std::atomic<std::uint64_t> data;    /**< The packed entry. */
+    };
+
+    std::unique_ptr<Slot[]> slots;           /**< The slots, bucket by bucket. */
+    size_t bucketMask;                       /**< The number of buckets minus one. */
+    std::atomic<std::uint8_t> generation;    /**< The number of the current search, stored in every entry. */
+    std::atomic<std::uint64_t> probes;       /**< Lookups of the searches that have reported. */
+    std::atomic<std::uint64_t> hits;         /**< Lookups that found the position. */
+    std::atomic<std::uint64_t> stores;       /**< Entries written. */
+    std::atomic<std::uint64_t> replacements; /**< Entries written over an entry of another position. */
+
+public:
+    /**
+     * @brief Constructs an empty table.
+     * @param bucketCount The number of buckets, rounded up to a power of two.
+     * @throw std::runtime_error If the bucket count is 0.
+     */
+    explicit TranspositionTable(size_t bucketCount);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    /**
+     * @brief Looks a position up.
+     * @param hash The hash of the position.
+     * @param entry Receives the entry of the position if it is found.
+     * @param statistics The counters of the calling search.
+     * @return True if the position is found.
+     */
+    bool probe(std::uint64_t hash, TranspositionEntry& entry, TranspositionStatistics& statistics) const;
+
+    /**
+     * @brief Stores the entry of a position.
+     * @param hash The hash of the position.
+     * @param entry The entry. Its bound must not be Bound::None.
+     * @param statistics The counters of the calling search.
+     */
+    void store(std::uint64_t hash, const TranspositionEntry& entry, TranspositionStatistics& statistics);
+
+    /**
+     * @brief Starts a new search, so the entries of earlier searches are replaced first.
+     */
+    void newSearch();
+
+    /**
+     * @brief Empties the table and resets the counters. Must not run alongside other calls.
+     */
+    void clear();
+
+    /**
+     * @brief Adds the counters of a finished search to the counters of the table.
+     * @param statistics The counters of the search.
+     */
+    void addStatistics(const TranspositionStatistics& statistics);
+
+    /**
+     * @brief Retrieves the counters added by the searches using the table.
+     * @return The counters.
+     */
+    TranspositionStatistics getStatistics() const;
+
+    /**
+     * @brief Retrieves the number of slots of the table.
+     * @return The number of slots.
+     */
+    size_t getCapacity() const;
+};
+
+#endif  // TRANSPOSITION_TABLE_HPP
@@ -2,7 +2,12 @@
 #define UNIT_H
 
 #include "map.hpp"
+#include "owner.hpp"
 #include <unordered_map>
+#include <memory>
+#include <optional>
+
+class SpatialIndex;
 
 // Mapping of abbreviated unit types to full names
 const std::unordered_map<char, std::string> unitTypeMap = {
@@ -43,12 +48,30 @@ private:
     unsigned short position[2];     /**< The position of the unit. */
     std::string name;               /**< The name of the unit. */
 
-    bool owner;                     /**< The owner's ID. */
+    OwnerId owner;                  /**< The owner's ID. */
 
     unsigned short baseSpeed;       /**< The base speed of the unit. */
     bool hasAttacked;               /**< Flag for when the unit has taken an attack action. */
 
-    Unit* currentCreation = nullptr;/**< Pointer to the unit currently being created by the base. */
+    /**
+     * @struct Creation
+     * @brief Owns the unit being created by a base.
+     *
+     * Copying a base copies the unit it is creating, so copies of a game state never share
+     * building progress.
+     */
+    struct Creation {
+        std::unique_ptr<Unit> unit; /**< The unit being created, or nullptr if the base is idle. */
+
+        Creation() = default;
+        Creation(const Creation& other);
+        Creation& operator=(const Creation& other);
+        Creation(Creation&& other) noexcept = default;
+        Creation& operator=(Creation&& other) noexcept = default;
+        ~Creation();
+    };
+
+    Creation currentCreation;       /**< The unit currently being created by the base. */
 
 public:
     /**
@@ -58,7 +81,7 @@ public:
      * @param name The name of the unit.
      * @throws std::runtime_error if the unit name is invalid and not found in the unitAttributesMap.
      */
-    Unit(bool owner, unsigned short id, const std::string& name);
+    Unit(OwnerId owner, unsigned short id, const std::string& name);
 
     // Getters
 
@@ -120,7 +143,7 @@ public:
      * @brief Get the owner of the unit.
      * @return The owner of the unit.
      */
-    bool getOwner() const;
+    OwnerId getOwner() const;
 
     /**
      * @brief Get the initial letter of the unit's name.
@@ -129,13 +152,23 @@ public:
     char getInitial() const;
 
     Unit* getCurrentCreation() {
-        return currentCreation;
+        return currentCreation.unit.get();
+    }
+
+    const Unit* getCurrentCreation() const {
+        return currentCreation.unit.get();
     }
 
     // Setters
 
     void setPosition(unsigned int x, unsigned int y);
 
+    /**
+     * @brief Set the ID of the unit.
+     * @param newId The new ID of the unit.
+     */
+    void setId(unsigned short newId);
+
     // Other member functions
 
     /**
@@ -151,7 +184,7 @@ public:
      * @param y The Y coordinate of the new position.
      * @return The distance between the current position and the specified coordinates.
      */
-    unsigned short calculateDistance(unsigned short x, unsigned short y);
+    unsigned short calculateDistance(unsigned short x, unsigned short y) const;
 
     /**
      * @brief Performs an attack action on a target unit with the specified ID.
@@ -161,6 +194,26 @@ public:
      */
     void attackAction(unsigned short targetId, const std::vector<Unit>& units);
 
+    /**
+     * @brief Performs an attack action on a target unit looked up in a spatial index.
+     * @param targetId The ID of the target unit to attack.
+     * @param index The spatial index of the units. It must have been rebuilt since the units last changed.
+     * @throws std::runtime_error if the target unit with the specified ID is not found.
+     */
+    void attackAction(unsigned short targetId, const SpatialIndex& index);
+
+    /**
+     * @brief Validates an attack on a target unit and spends the unit's attack, without dealing any damage.
+     *
+     * Used by batched combat resolution, which deals the damage of all attacks of a turn at once.
+     *
+     * @param targetId The ID of the target unit to attack.
+     * @param index The spatial index of the units. It must have been rebuilt since the units last changed.
+     * @return The target unit.
+     * @throws std::runtime_error if the target unit is not found or cannot be attacked.
+     */
+    const Unit& declareAttack(unsigned short targetId, const SpatialIndex& index);
+
     /**
      * @brief Performs a move action by changing the position of the unit to the specified coordinates.
      * @param x The X coordinate of the new position.
@@ -171,6 +224,20 @@ public:
      */
     void moveAction(unsigned short x, unsigned short y, const std::vector<Unit>& units, const Map& map);
 
+    /**
+     * @brief Performs a move action, checking the target position against the units of a spatial index.
+     *
+     * Only the bucket holding the target position is looked at, so a move costs the same
+     * however many units the enemies have.
+     *
+     * @param x The X coordinate of the new position.
+     * @param y The Y coordinate of the new position.
+     * @param index The spatial index of the units to check for collisions.
+     * @param map The map object to check for obstacles.
+     * @throws std::runtime_error if the movement distance exceeds the unit's speed, if the target position is an obstacle or if an enemy unit holds it.
+     */
+    void moveAction(unsigned short x, unsigned short y, const SpatialIndex& index, const Map& map);
+
     /**
      * @brief Inflicts damage to the unit based on the specified amount.
      * @param amount The amount of damage to be inflicted.
@@ -207,9 +274,36 @@ public:
      */
     bool isWorkerOnMine(const Map& map) const;
 
-    void createUnit(const Unit& unit);
+    /**
+     * @brief Start or continue creating a unit on the base.
+     *
+     * Every call advances the building time of the unit by one tick. Once the unit is
+     * finished, it is deployed on the base and returned.
+     *
+     * @param unit The unit to create.
+     * @return The deployed unit if it has been finished by this call, std::nullopt otherwise.
+     * @throws std::runtime_error if the unit is not a base or if the base is already creating a different unit.
+     */
+    std::optional<Unit> createUnit(const Unit& unit);
 
 private:
+    /**
+     * @brief Validates an attack on the target unit and deals the damage.
+     * @param target The target unit, or nullptr if it was not found.
+     * @param targetId The ID of the target unit.
+     * @throws std::runtime_error if the attack is not allowed or the target unit was not found.
+     */
+    void attackUnit(const Unit* target, unsigned short targetId);
+
+    /**
+     * @brief Validates an attack on the target unit and spends the unit's attack for this turn.
+     * @param target The target unit, or nullptr if it was not found.
+     * @param targetId The ID of the target unit.
+     * @return The target unit.
+     * @throws std::runtime_error if the attack is not allowed or the target unit was not found.
+     */
+    const Unit& prepareAttack(const Unit* target, unsigned short targetId);
+
     /**
      * @brief Initialize the unit's attributes based on its name.
      */
@@ -0,0 +1,41 @@
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include "unit.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Computes the Zobrist key of a unit from its ID, type, owner, position and health.
+ *
+ * The type, owner, position and health are packed into 64 bits and scrambled with a
+ * bijective mixer, so every combination has its own key without a table the size of the
+ * map, and the ID is mixed in on top. The hash of a state is the XOR of the keys of its
+ * units, so moving or damaging a unit updates the hash with two XORs: the key before the
+ * change and the key after it. Without the ID, two identical units of a side on one cell,
+ * such as units deployed on their base, would cancel each other out.
+ *
+ * @param unit The unit.
+ * @return The key.
+ */
+std::uint64_t zobristUnitKey(const Unit& unit);
+
+/**
+ * @brief Computes a key standing for a small piece of search state, such as the side to move.
+ * @param kind The kind of state, distinct from every other kind hashed into the same state.
+ * @param value The value of the state.
+ * @return The key.
+ */
+std::uint64_t zobristStateKey(std::uint32_t kind, std::uint32_t value);
+
+/**
+ * @brief Computes the hash of a set of armies from scratch.
+ *
+ * Incrementally updated hashes must always equal the hash computed by this function.
+ *
+ * @param armies The units of every side.
+ * @return The XOR of the keys of all units.
+ */
+std::uint64_t zobristHash(const std::vector<const std::vector<Unit>*>& armies);
+
+#endif  // ZOBRIST_HPP
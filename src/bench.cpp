@@ -0,0 +1,144 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "scenario.hpp"
+
+namespace fs = std::filesystem;
+
+struct RunResult {
+    bool succeeded;     // The process exited with status 0
+    double seconds;     // Wall-clock time of the process
+    long peakRssKb;     // Peak resident set size of the process and the children it waited for
+};
+
+// Run a program in a directory with its output sent to a log file, and measure it
+RunResult runProcess(const std::vector<std::string>& args, const fs::path& directory) {
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        return {false, 0.0, 0};
+    }
+
+    if (pid == 0) {
+        if (chdir(directory.c_str()) != 0) {
+            _exit(127);
+        }
+        int log = open("log.txt", O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (log >= 0) {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+        std::vector<char*> argv;
+        for (const std::string& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage = {};
+    wait4(pid, &status, 0, &usage);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {WIFEXITED(status) && WEXITSTATUS(status) == 0, elapsed.count(), usage.ru_maxrss};
+}
+
+// Print a result as a single line of JSON
+void report(const std::string& benchmark, const std::string& name, const ScenarioOptions& options, const Scenario& scenario,
+            const std::string& subject, unsigned int turns, const RunResult& result, double secondsPerTurn, double throughput,
+            const std::string& throughputUnit) {
+    std::cout << "{\"benchmark\": \"" << benchmark << "\", \"scenario\": \"" << name << "\", \"size\": " << options.size
+              << ", \"seed\": " << options.seed << ", \"units\": " << scenario.unitCount << ", \"subject\": \"" << subject
+              << "\", \"turns\": " << turns << ", \"ok\": " << (result.succeeded ? "true" : "false")
+              << ", \"seconds_per_turn\": " << secondsPerTurn << ", \"peak_rss_kb\": " << result.peakRssKb
+              << ", \"" << throughputUnit << "\": " << throughput << "}" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4 || argc > 7) {
+        std::cerr << "Invalid amount of arguments. Usage: ./bench <mediator> <player 1 bot> <player 2 bot> [max size] [turns] [seed]" << std::endl;
+        return 1;
+    }
+
+    const fs::path mediator = fs::absolute(argv[1]);
+    const fs::path bots[2] = {fs::absolute(argv[2]), fs::absolute(argv[3])};
+    const unsigned int maxSize = argc > 4 ? std::stoi(argv[4]) : 1024;
+    const unsigned int turns = argc > 5 ? std::max(1, std::stoi(argv[5])) : 3;
+    const unsigned int seed = argc > 6 ? std::stoul(argv[6]) : 1;
+
+    const fs::path scratch = fs::temp_directory_path() / ("skirmish_bench_" + std::to_string(getpid()));
+    bool allSucceeded = true;
+
+    for (unsigned int size : {64u, 256u, 1024u, 4096u, 8192u}) {
+        if (size > maxSize) {
+            break;
+        }
+        for (ScenarioKind kind : {ScenarioKind::Open, ScenarioKind::Maze, ScenarioKind::Islands}) {
+            // Larger maps get more mines and larger armies
+            ScenarioOptions options;
+            options.kind = kind;
+            options.size = size;
+            options.seed = seed;
+            options.mineCount = std::max(8u, size / 8);
+            options.armySize = 8 + size / 128;
+            Scenario scenario = generateScenario(options);
+            std::string name = scenarioKindName(kind);
+            std::cerr << "Running " << name << " " << size << "x" << size << " (" << scenario.unitCount << " units)" << std::endl;
+
+            // Write the scenario into a fresh directory laid out like the repository's data directory
+            const fs::path directory = scratch / (name + "_" + std::to_string(size));
+            fs::create_directories(directory / "data");
+            {
+                std::ofstream mapFile(directory / "data" / "map.txt");
+                for (const std::string& row : scenario.rows) {
+                    mapFile << row << '\n';
+                }
+                std::ofstream(directory / "data" / "scenario.txt") << scenario.status;
+                std::ofstream(directory / "data" / "status.txt") << scenario.status;
+                std::ofstream(directory / "data" / "orders.txt");
+            }
+
+            // A single bot turn on the starting position as player 1 without a time limit, repeated and averaged
+            for (const fs::path& bot : bots) {
+                RunResult total = {true, 0.0, 0};
+                for (unsigned int turn = 0; turn < turns; ++turn) {
+                    RunResult run = runProcess({bot.string(), "data/map.txt", "data/status.txt", "data/orders.txt", "0", "0"}, directory);
+                    total.succeeded = total.succeeded && run.succeeded;
+                    total.seconds += run.seconds;
+                    total.peakRssKb = std::max(total.peakRssKb, run.peakRssKb);
+                }
+                double secondsPerTurn = total.seconds / turns;
+                report("bot_turn", name, options, scenario, bot.filename().string(), turns, total, secondsPerTurn,
+                       (options.armySize + 1) / secondsPerTurn, "units_per_second");
+                allSucceeded = allSucceeded && total.succeeded;
+            }
+
+            // A whole match through the mediator's turn loop, without time limits
+            RunResult match = runProcess({mediator.string(), "data/map.txt", bots[0].string(), bots[1].string(),
+                                          std::to_string(turns), "0", "data/scenario.txt"}, directory);
+            double secondsPerTurn = match.seconds / (2 * turns);
+            report("match", name, options, scenario, mediator.filename().string(), 2 * turns, match, secondsPerTurn,
+                   1.0 / secondsPerTurn, "turns_per_second");
+            allSucceeded = allSucceeded && match.succeeded;
+
+            if (match.succeeded) {
+                fs::remove_all(directory);
+            } else {
+                std::cerr << "The match failed, see " << (directory / "log.txt") << std::endl;
+            }
+        }
+    }
+
+    if (allSucceeded) {
+        fs::remove_all(scratch);
+    }
+    return allSucceeded ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <functional>
+#include "pathfinding.hpp"
+#include "cpu.hpp"
+#include "scenario.hpp"
+
+// Pick the passable start cell that reaches the most cells out of a few random candidates
+std::pair<unsigned short, unsigned short> pickStart(const Map& map, std::mt19937& gen) {
+    std::uniform_int_distribution<unsigned int> disX(0, map.getWidth() - 1);
+    std::uniform_int_distribution<unsigned int> disY(0, map.getHeight() - 1);
+    std::pair<unsigned short, unsigned short> best = {0, 0};
+    size_t bestReached = 0;
+    BitBFS bfs(map);
+
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        unsigned int x = disX(gen);
+        unsigned int y = disY(gen);
+        if (map.getCell(x, y) == '9') {
+            continue;
+        }
+        size_t reached = 0;
+        bfs.search(x, y);
+        for (unsigned int cellY = 0; cellY < map.getHeight(); ++cellY) {
+            for (unsigned int cellX = 0; cellX < map.getWidth(); ++cellX) {
+                reached += bfs.getDistance(cellX, cellY) >= 0;
+            }
+        }
+        if (reached > bestReached) {
+            best = {x, y};
+            bestReached = reached;
+        }
+    }
+    return best;
+}
+
+Map buildMap(const std::vector<std::string>& rows) {
+    std::stringstream stream;
+    for (const auto& row : rows) {
+        stream << row << '\n';
+    }
+    return Map(stream);
+}
+
+// Check that a search stopped at a goal agrees with the reference on every cell no farther than the goal
+bool matchesUntilGoal(BitBFS& bfs, const std::vector<std::vector<int>>& reference, unsigned short startX, unsigned short startY,
+                      std::mt19937& gen) {
+    const Map& map = bfs.getMap();
+    std::uniform_int_distribution<unsigned int> disX(0, map.getWidth() - 1);
+    std::uniform_int_distribution<unsigned int> disY(0, map.getHeight() - 1);
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        unsigned int goalX = disX(gen);
+        unsigned int goalY = disY(gen);
+        int goalDistance = reference[goalY][goalX];
+        if (goalDistance < 0) {
+            continue;
+        }
+        bfs.searchUntil(startX, startY, goalX, goalY);
+        for (unsigned int y = 0; y < map.getHeight(); ++y) {
+            for (unsigned int x = 0; x < map.getWidth(); ++x) {
+                int distance = reference[y][x];
+                if (distance >= 0 && distance <= goalDistance && bfs.getDistance(x, y) != distance) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Check that the portable kernel and, when the CPU supports it, the AVX2 kernel both give the reference distances
+bool kernelsMatch(const Map& map, const std::vector<std::vector<int>>& reference, unsigned short startX, unsigned short startY) {
+    bool forced = portableKernels();
+    portableKernels() = true;
+    bool match = performBitBFS(map, startX, startY) == reference;
+    portableKernels() = false;
+    match = match && (!cpuHasAVX2() || performBitBFS(map, startX, startY) == reference);
+    portableKernels() = forced;
+    return match;
+}
+
+// Run the search repeatedly and return the throughput in cells per second
+double measure(const std::function<void()>& search, const Map& map, int runs) {
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run) {
+        search();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(map.getWidth()) * map.getHeight() * runs / elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    unsigned int size = 512;
+    int runs = 10;
+
+    if (argc > 1) {
+        size = std::stoi(argv[1]);
+    }
+    if (argc > 2) {
+        runs = std::stoi(argv[2]);
+    }
+
+    std::mt19937 gen(42);
+    std::vector<std::pair<std::string, std::vector<std::string>>> scenarios = {
+        {"open", generateOpenRows(size, 0.05, gen)},
+        {"maze", generateMazeRows(size, gen)},
+        {"islands", generateIslandRows(size, 0.5, gen)},
+        {"cave", generateCaveRows(size, 0.45, gen)}
+    };
+
+    std::cout << "Map size: " << size << "x" << size << ", runs: " << runs
+              << ", AVX2: " << (useAVX2() ? "yes" : cpuHasAVX2() ? "forced off" : "no") << std::endl;
+
+    bool allMatch = true;
+    for (const auto& [name, rows] : scenarios) {
+        Map map = buildMap(rows);
+        auto [startX, startY] = pickStart(map, gen);
+
+        // The bots keep one workspace per thread, so the workspace is reused between runs
+        BitBFS bfs(map);
+        std::vector<std::vector<int>> reference = performBFS(map, startX, startY);
+        bool match = reference == performBitBFS(map, startX, startY) && matchesUntilGoal(bfs, reference, startX, startY, gen);
+        bool kernels = kernelsMatch(map, reference, startX, startY);
+        allMatch = allMatch && match && kernels;
+
+        double scalar = measure([&]() { performBFS(map, startX, startY); }, map, runs);
+        double bitParallel = measure([&]() { bfs.search(startX, startY); }, map, runs);
+
+        std::cout << name << ": scalar " << scalar / 1e6 << " Mcells/s, bit-parallel " << bitParallel / 1e6
+                  << " Mcells/s, speedup " << bitParallel / scalar << "x, distances "
+                  << (match ? "match" : "DIFFER") << ", kernels " << (kernels ? "match" : "DIFFER") << std::endl;
+    }
+
+    return allMatch ? 0 : 1;
+}
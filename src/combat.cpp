@@ -0,0 +1,158 @@
+#include "combat.hpp"
+#include "spatial_index.hpp"
+#include "cpu.hpp"
+#include <array>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COMBAT_HAS_AVX2_KERNEL 1
+#endif
+
+namespace {
+
+// The unit types in type index order
+const std::string typeInitials = "BWSKRCPA";
+
+// Damage matrix indexed by attacker type * 8 + target type, built from Unit::calculateDamage
+const std::array<std::uint16_t, 64>& damageMatrix() {
+    static const std::array<std::uint16_t, 64> matrix = []() {
+        std::array<std::uint16_t, 64> result = {};
+        for (size_t attacker = 0; attacker < typeInitials.size(); ++attacker) {
+            Unit attackerUnit(false, 0, unitTypeMap.at(typeInitials[attacker]));
+            for (size_t target = 0; target < typeInitials.size(); ++target) {
+                Unit targetUnit(true, 0, unitTypeMap.at(typeInitials[target]));
+                result[attacker * 8 + target] = attackerUnit.calculateDamage(targetUnit);
+            }
+        }
+        return result;
+    }();
+    return matrix;
+}
+
+// Subtracts the damage totals from the health array, 16 units at a time, and collects the
+// indices of the units whose health dropped to 0
+void applyDamagePortable(std::uint16_t* health, const std::uint32_t* totals, size_t count, std::vector<std::uint32_t>& killed) {
+    for (size_t i = 0; i < count; ++i) {
+        std::uint16_t before = health[i];
+        std::uint32_t amount = totals[i];
+        health[i] = amount >= before ? 0 : before - amount;
+        if (before != 0 && health[i] == 0) {
+            killed.push_back(i);
+        }
+    }
+}
+
+#ifdef COMBAT_HAS_AVX2_KERNEL
+__attribute__((target("avx2")))
+void applyDamageAVX2(std::uint16_t* health, const std::uint32_t* totals, size_t count, std::vector<std::uint32_t>& killed) {
+    const __m256i limit = _mm256_set1_epi32(0xFFFF);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (size_t i = 0; i < count; i += 16) {
+        // Clamp the totals to 16 bits and narrow them to the layout of the health array
+        __m256i low = _mm256_min_epu32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(totals + i)), limit);
+        __m256i high = _mm256_min_epu32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(totals + i + 8)), limit);
+        __m256i amount = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xD8);
+
+        __m256i before = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(health + i));
+        __m256i after = _mm256_subs_epu16(before, amount);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(health + i), after);
+
+        // A unit is destroyed when it had health left and has none now
+        __m256i destroyed = _mm256_andnot_si256(_mm256_cmpeq_epi16(before, zero), _mm256_cmpeq_epi16(after, zero));
+        unsigned int mask = _mm256_movemask_epi8(destroyed);
+        while (mask) {
+            unsigned int bit = __builtin_ctz(mask);
+            killed.push_back(i + bit / 2);
+            mask &= ~(3u << bit);
+        }
+    }
+}
+#endif
+
+}  // namespace
+
+std::uint8_t CombatStage::typeIndex(char initial) {
+    size_t index = typeInitials.find(initial);
+    return index == std::string::npos ? 255 : static_cast<std::uint8_t>(index);
+}
+
+std::uint16_t CombatStage::damage(std::uint8_t attackerType, std::uint8_t targetType) {
+    return damageMatrix()[attackerType * 8 + targetType];
+}
+
+void CombatStage::load(const std::vector<std::vector<Unit>*>& targets) {
+    units.clear();
+    health.clear();
+    types.clear();
+    indices.clear();
+    attackerTypes.clear();
+    targetIndices.clear();
+
+    for (std::vector<Unit>* army : targets) {
+        for (Unit& unit : *army) {
+            indices[&unit] = units.size();
+            units.push_back(&unit);
+            health.push_back(unit.getHealth());
+            types.push_back(typeIndex(unit.getInitial()));
+        }
+    }
+
+    // Pad the health array so the vector kernel can always work on full blocks
+    health.resize((health.size() + 15) / 16 * 16, 0);
+}
+
+std::uint16_t CombatStage::addAttack(Unit& attacker, unsigned short targetId, const SpatialIndex& index) {
+    // Look the target up before spending the attack, so a target outside the stage is rejected as a whole
+    const SpatialIndex::Entry* entry = index.find(targetId);
+    if (entry && indices.find(entry->unit) == indices.end()) {
+        throw std::runtime_error("Target unit with ID " + std::to_string(targetId) + " is not part of the combat stage.");
+    }
+
+    const Unit& target = attacker.declareAttack(targetId, index);
+    attackerTypes.push_back(typeIndex(attacker.getInitial()));
+    targetIndices.push_back(indices.at(&target));
+    return damage(attackerTypes.back(), types[targetIndices.back()]);
+}
+
+size_t CombatStage::getAttackCount() const {
+    return attackerTypes.size();
+}
+
+std::vector<unsigned short> CombatStage::resolve() {
+    // Gather the damage of every attack and sum it per target
+    std::vector<std::uint32_t> totals(health.size(), 0);
+    for (size_t attack = 0; attack < attackerTypes.size(); ++attack) {
+        std::uint32_t target = targetIndices[attack];
+        totals[target] += damage(attackerTypes[attack], types[target]);
+    }
+
+    // Apply the totals to the health array in one pass
+    std::vector<std::uint32_t> killed;
+#ifdef COMBAT_HAS_AVX2_KERNEL
+    if (useAVX2()) {
+        applyDamageAVX2(health.data(), totals.data(), health.size(), killed);
+    } else {
+        applyDamagePortable(health.data(), totals.data(), health.size(), killed);
+    }
+#else
+    applyDamagePortable(health.data(), totals.data(), health.size(), killed);
+#endif
+
+    // Write the new health back to the units
+    for (std::uint32_t target : targetIndices) {
+        Unit* unit = units[target];
+        if (unit->getHealth() != health[target]) {
+            unit->takeDamage(unit->getHealth() - health[target]);
+        }
+    }
+
+    std::vector<unsigned short> killedIds;
+    for (std::uint32_t index : killed) {
+        killedIds.push_back(units[index]->getId());
+    }
+
+    attackerTypes.clear();
+    targetIndices.clear();
+    return killedIds;
+}
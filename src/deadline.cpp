@@ -0,0 +1,67 @@
+#include "deadline.hpp"
+#include <utility>
+
+CancellationToken::CancellationToken(std::shared_ptr<const std::atomic<bool>> cancelled) : cancelled(std::move(cancelled)) {
+}
+
+bool CancellationToken::isCancelled() const {
+    return cancelled && cancelled->load(std::memory_order_acquire);
+}
+
+CancellationSource::CancellationSource() : cancelled(std::make_shared<std::atomic<bool>>(false)) {
+}
+
+CancellationToken CancellationSource::getToken() const {
+    return CancellationToken(cancelled);
+}
+
+void CancellationSource::cancel() {
+    cancelled->store(true, std::memory_order_release);
+}
+
+bool CancellationSource::isCancelled() const {
+    return cancelled->load(std::memory_order_acquire);
+}
+
+DeadlineTimer::DeadlineTimer(const CancellationSource& source, std::chrono::steady_clock::time_point deadline)
+    : source(source), deadline(deadline), stopped(false), expired(false) {
+    // A deadline in the past needs no watcher, and the work must not get to start
+    if (std::chrono::steady_clock::now() >= deadline) {
+        expired = true;
+        this->source.cancel();
+        return;
+    }
+
+    watcher = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!wakeup.wait_until(lock, this->deadline, [this]() { return stopped; })) {
+            expired = true;
+            this->source.cancel();
+        }
+    });
+}
+
+DeadlineTimer::~DeadlineTimer() {
+    stop();
+}
+
+void DeadlineTimer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    wakeup.notify_one();
+    if (watcher.joinable()) {
+        watcher.join();
+    }
+}
+
+bool DeadlineTimer::hasExpired() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return expired;
+}
+
+std::chrono::steady_clock::time_point deadlineAfter(double seconds) {
+    return std::chrono::steady_clock::now() +
+           std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
@@ -5,301 +5,301 @@
 #include <thread>
 #include <queue>
 #include <atomic>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
 #include "player.hpp"
+#include "pathfinding.hpp"
+#include "spatial_index.hpp"
+#include "influence_map.hpp"
+#include "status.hpp"
+#include "shared_state.hpp"
+#include "thread_pool.hpp"
+#include "deadline.hpp"
+#include "map_cache.hpp"
+#include "tactical_search.hpp"
+#include "trace.hpp"
 
 #define PLAYER_ID 0
 #define ENEMY_ID 1
 
-// Function to perform pathfinding using Breadth-First Search (BFS)
-std::vector<std::vector<int>> performBFS(const Map& map, unsigned short startX, unsigned short startY) {
-    unsigned int width = map.getWidth();
-    unsigned int height = map.getHeight();
-    std::vector<std::vector<int>> distance(height, std::vector<int>(width, -1));  // Initialize distances to -1 (unreachable)
-    std::queue<std::pair<unsigned short, unsigned short>> q;
-
-    // Starting position has distance 0
-    distance[startY][startX] = 0;
-    q.push({startX, startY});
-
-    while (!q.empty()) {
-        auto [x, y] = q.front();
-        q.pop();
-
-        // Check neighboring cells (up, down, left, right)
-        std::vector<std::pair<int, int>> neighbors = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
-        for (const auto& [dx, dy] : neighbors) {
-            unsigned short nx = x + dx;
-            unsigned short ny = y + dy;
-
-            // Check if the neighboring cell is within the map boundaries and reachable
-            if (nx >= 0 && nx < width && ny >= 0 && ny < height && map.getCell(nx, ny) != '9') {
-                if (distance[ny][nx] == -1) {
-                    // Update the distance and enqueue the neighboring cell
-                    distance[ny][nx] = distance[y][x] + 1;
-                    q.push({nx, ny});
-                }
-            }
-        }
-    }
+// Share of the time limit the turn may take, leaving the rest to write the orders
+const double turnTimeFraction = 0.9;
 
-    return distance;
-}
+// Tactical search of local skirmishes: the largest skirmish searched, and the buckets of the shared table
+const size_t maxSkirmishUnits = 4;
+const size_t transpositionBuckets = 1 << 16;
+
+// Decide the orders of a single unit. Only the unit itself and the worker's scratch space are modified,
+// so the decisions of different units can be made in parallel.
+std::string decideUnitOrders(Unit& unit, const Map& map, const std::vector<Unit>& enemyUnits, const SpatialIndex& enemyIndex,
+                             const InfluenceMap& influence, const MineFields& mines, BitBFS& bfs, std::mt19937& gen, unsigned short newUnitId) {
+    std::ostringstream orders;
+    std::uniform_int_distribution<> dis(0, 1);
 
-// Function to find the nearest object using pathfinding
-std::pair<unsigned short, unsigned short> findSpecifiedObject(const Map& map, unsigned short startX, unsigned short startY, char object) {
-    unsigned int width = map.getWidth();
-    unsigned int height = map.getHeight();
-
-    // Perform BFS to calculate distances from the starting position
-    std::vector<std::vector<int>> distance = performBFS(map, startX, startY);
-
-    // Find the object based on the calculated distances
-    unsigned short nearestX = 0;
-    unsigned short nearestY = 0;
-    int nearestDistance = -1;
-
-    for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            if (map.getCell(x, y) == object && (nearestDistance == -1 || distance[y][x] < nearestDistance)) {
-                nearestX = x;
-                nearestY = y;
-                nearestDistance = distance[y][x];
+    // Check if the unit is a base
+    if (unit.getName() == "Base") {
+        // Check if the base is not making a unit
+        if (unit.getCurrentCreation() == nullptr) {
+            // Generate a random number to decide whether to make a unit
+            int makeUnit = dis(gen);
+            if (makeUnit == 1) {
+                std::vector<std::string> unitTypes = {"Worker", "Swordsman", "Knight", "Ram", "Catapult", "Pikeman", "Archer"};
+                std::uniform_int_distribution<> disUnit(0, unitTypes.size() - 1);
+                std::string unitType = unitTypes[disUnit(gen)];
+                // Write the order to make a unit
+                orders << unit.getId() << " B " << unitType[0] << std::endl;
+
+                // Make a unit
+                unit.createUnit(Unit(false, newUnitId, unitType));
             }
         }
-    }
-
-    return {nearestX, nearestY};
-}
-
-// Function to read the status file
-Player readStatusFile(std::ifstream& statusFileStream) {
-    Player player(0, "Player 1", 0); // Create a player object with default values
-
-    if (statusFileStream.is_open()) {
-        // Read the first line containing the amount of gold
-        std::string line;
-        if (std::getline(statusFileStream, line)) {
-            std::istringstream iss(line);
-            unsigned int gold;
-            iss >> gold;
-            player.setGold(gold);
+    } else if (unit.getName() == "Worker") {
+        // Find the nearest mine using pathfinding
+        unsigned short x = unit.getPositionX();
+        unsigned short y = unit.getPositionY();
+        // The nearest reachable mine comes from the cached mine fields, a worker that cannot reach any mine stays in place
+        std::optional<std::pair<unsigned short, unsigned short>> mine = mines.findNearest(x, y);
+        if (!mine) {
+            return orders.str();
+        }
+        auto [mineX, mineY] = *mine;
+
+        // Step towards the mine as far as the worker's speed allows, avoiding cells held by enemy units
+        // and cells where the enemy units in range could destroy the worker
+        auto [stepX, stepY] = findStepTowards(bfs, x, y, unit.getSpeed(), mineX, mineY,
+            [&](unsigned short cellX, unsigned short cellY) {
+                return influence.getThreat(true, cellX, cellY, unit) >= unit.getHealth() ||
+                       !enemyIndex.withinRange(enemiesOf(PLAYER_ID), cellX, cellY, 0).empty();
+            });
+        if (stepX != x || stepY != y) {
+            try {
+                // Move the worker towards the mine
+                unit.moveAction(stepX, stepY, enemyUnits, map);
+
+                // Write the order to move the worker towards the mine
+                orders << unit.getId() << " M " << stepX << " " << stepY << std::endl;
+            } catch (const std::runtime_error&) {
+                // The cell is held by a destroyed enemy unit, stay in place
+            }
+        }
+    } else {
+        unsigned short x = unit.getPositionX();
+        unsigned short y = unit.getPositionY();
+
+        // Attack the weakest enemy unit within range (enemy units are parsed with owner 1)
+        const Unit* target = nullptr;
+        for (const SpatialIndex::Entry& entry : enemyIndex.withinRange(enemiesOf(PLAYER_ID), x, y, unit.getAttackRange())) {
+            if (!target || entry.unit->getHealth() < target->getHealth() ||
+                (entry.unit->getHealth() == target->getHealth() && entry.id < target->getId())) {
+                target = entry.unit;
+            }
         }
 
-        // Read the player and enemy details
-        std::string prefix = "P";
-        std::string unitType, dummy;
-        int id, x, y, hp;
-
-        while (std::getline(statusFileStream, line)) {
-            if (line.substr(0, prefix.size()) == prefix) {
-                std::istringstream iss(line);
-                iss >> dummy >> unitType >> id >> x >> y >> hp;
-
-                // Map the abbreviated unit type to the full name
-                if (unitTypeMap.find(unitType[0]) == unitTypeMap.end()) {
-                    throw std::runtime_error("Invalid unit type: " + unitType);
+        if (target) {
+            // Write the order to attack the enemy unit. The damage is dealt by the mediator.
+            orders << unit.getId() << " A " << target->getId() << std::endl;
+        } else {
+            // Move towards the closest enemy unit, avoiding cells held by other enemy units
+            // and cells where the enemy units in range could destroy this unit
+            std::vector<SpatialIndex::Entry> nearest = enemyIndex.kNearest(enemiesOf(PLAYER_ID), x, y, 1);
+            if (!nearest.empty()) {
+                auto [stepX, stepY] = findStepTowards(bfs, x, y, unit.getSpeed(), nearest[0].x, nearest[0].y,
+                    [&](unsigned short cellX, unsigned short cellY) {
+                        return influence.getThreat(true, cellX, cellY, unit) >= unit.getHealth() ||
+                               !enemyIndex.withinRange(enemiesOf(PLAYER_ID), cellX, cellY, 0).empty();
+                    });
+                if (stepX != x || stepY != y) {
+                    try {
+                        // Move the unit
+                        unit.moveAction(stepX, stepY, enemyUnits, map);
+
+                        // Write the order to move towards the enemy unit
+                        orders << unit.getId() << " M " << stepX << " " << stepY << std::endl;
+                    } catch (const std::runtime_error&) {
+                        // The cell is held by a destroyed enemy unit, stay in place
+                    }
                 }
-                std::string fullName = unitTypeMap.at(unitType[0]);
-
-                Unit unit(0, id, fullName);
-                unit.setPosition(x, y);
-                unit.takeDamage(unit.getHealth() - hp);
-                player.addUnitToPlayerUnits(unit);
             }
         }
     }
 
-    return player;
+    return orders.str();
 }
 
-Player getEnemyUnits(std::ifstream& statusFileStream) {
-    Player player(1, "Player 2", 0); // Create a player object with default values
-
-    if (statusFileStream.is_open()) {
-        // Read the first line containing the amount of gold
-        std::string line;
-        if (std::getline(statusFileStream, line)) {
-            std::istringstream iss(line);
+void performTurn(std::ifstream& mapFile, std::ifstream& statusFile, std::ofstream& ordersFile, unsigned int playerId,
+                 const CancellationToken& token = CancellationToken()) {
+    TraceSpan span("performTurn", "bot", "player", playerId + 1);
+
+    // Read the map and the armies from shared memory when the mediator provides them,
+    // otherwise from the map file and the status file in a single pass
+    Player player(0, "Player 1", 0);
+    Player enemy(1, "Player 2", 0);
+    std::optional<SharedStateView> shared = openSharedState();
+    Map map = [&]() {
+        TraceSpan span("loadTurn", "bot");
+        if (shared) {
+            return loadSharedTurn(*shared, playerId, player, enemy, Map::Topology::Deferred);
         }
-        // Read the player and enemy details
-        std::string prefix = "E";
-        std::string unitType, dummy;
-        int id, x, y, hp;
-
-        while (std::getline(statusFileStream, line)) {
-            if (line.substr(0, prefix.size()) == prefix) {
-                std::istringstream iss(line);
-                iss >> dummy >> unitType >> id >> x >> y >> hp;
-
-                // Map the abbreviated unit type to the full name
-                if (unitTypeMap.find(unitType[0]) == unitTypeMap.end()) {
-                    throw std::runtime_error("Invalid unit type: " + unitType);
-                }
-                std::string fullName = unitTypeMap.at(unitType[0]);
+        Map parsed(mapFile, Map::Topology::Deferred);
+        readStatus(statusFile, playerId, player, enemy);
+        return parsed;
+    }();
+
+    std::vector<Unit> units = player.getPlayerUnits();
+    const std::vector<Unit> enemyUnits = enemy.getPlayerUnits();
+
+    // Index the enemy units once so targeting queries only look at nearby units
+    SpatialIndex enemyIndex(map.getWidth(), map.getHeight());
+    enemyIndex.rebuild({&enemyUnits});
+    InfluenceMap influence(map.getWidth(), map.getHeight());
+    influence.rebuild({&enemyUnits});
+
+    // The topology labels and the mine fields only depend on the map, so they are computed on the
+    // first turn and mapped from the cache afterwards
+    MapCache cache(map);
+    loadTopology(map, cache);
+    MineFields mines{cache};
 
-                Unit unit(1, id, fullName);
-                unit.setPosition(x, y);
-                unit.takeDamage(unit.getHealth() - hp);
-                player.addUnitToPlayerUnits(unit);
-            }
-        }
+    unsigned short highestId = 0;
+    for (const Unit& unit : units) {
+        highestId = std::max(highestId, unit.getId());
+    }
+    for (const Unit& unit : enemyUnits) {
+        highestId = std::max(highestId, unit.getId());
     }
-    return player;
-}
-
-void performTurn(std::ifstream& mapFile, std::ifstream& statusFile, std::ofstream& ordersFile) {
-    // Read the map file and create a Map object
-    Map map(mapFile);
-
-    // Read the status file and create a Player object
-    Player player = readStatusFile(statusFile);
-    // Seek the status file back to the beginning
-    statusFile.clear();
-    statusFile.seekg(0, std::ios::beg);
-    // Read the status file and create an Enemy object
-    Player enemy = getEnemyUnits(statusFile);
-
 
-    unsigned short highestId = 0;
-    for (auto& playerUnit : player.getPlayerUnits()) {
-        for (auto& enemyUnit : enemy.getPlayerUnits()) {
-            if (highestId < playerUnit.getId()) {
-                highestId = playerUnit.getId();
-            }
-            if (highestId < enemyUnit.getId()) {
-                highestId = enemyUnit.getId();
-            }
+    // Units are merged by ID, so bases receive the IDs of new units in ID order
+    std::vector<size_t> byId(units.size());
+    std::iota(byId.begin(), byId.end(), 0);
+    std::sort(byId.begin(), byId.end(), [&](size_t a, size_t b) { return units[a].getId() < units[b].getId(); });
+    std::vector<unsigned short> newUnitIds(units.size(), 0);
+    for (size_t index : byId) {
+        if (units[index].getName() == "Base") {
+            newUnitIds[index] = ++highestId;
         }
-
     }
 
-    // Generate random numbers for making decisions
+    // Every unit gets its own generator seeded from the turn seed and its ID,
+    // so the decisions do not depend on the number of threads
     std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 1);
-
-    // Process each unit of the player
-    for (auto& unit : player.getPlayerUnits()) {
-        // Check if the unit is a base
-        if (unit.getName() == "Base") {
-            // Check if the base is not making a unit
-            if (unit.getCurrentCreation() == nullptr) {
-                // Generate a random number to decide whether to make a unit
-                int makeUnit = dis(gen);
-                if (makeUnit == 1) {
-                    std::vector<std::string> unitTypes = {"Worker", "Swordsman", "Knight", "Ram", "Catapult", "Pikeman", "Archer"};
-                    std::uniform_int_distribution<> disUnit(0, unitTypes.size() - 1);
-                    std::string unitType = unitTypes[disUnit(gen)];
-                    // Write the order to make a unit
-                    ordersFile << unit.getId() << " B " << unitType[0] << std::endl;
-
-                    // Make a unit
-                    unit.createUnit(Unit(false, highestId+1, unitType));
-                    highestId++;
-                }
+    unsigned int turnSeed = rd();
+
+    ThreadPool pool;
+    std::vector<std::string> unitOrders(units.size());
+    // Units left once the turn is cancelled give no orders, the others' orders are still submitted
+    std::atomic<size_t> decided(0);
+
+    // Units fighting a local skirmish take the orders of a tactical search. The searches of
+    // different skirmishes run in parallel, each with an empty table of its own: the searches
+    // stop at a node limit, so entries left by other searches would change their cutoffs and
+    // make the orders depend on the scheduling and the number of threads. Every worker keeps
+    // one table and clears it before each skirmish.
+    std::vector<char> searched(units.size(), false);
+    std::vector<Skirmish> skirmishes = findSkirmishes(units, enemyIndex, enemiesOf(PLAYER_ID), maxSkirmishUnits);
+    if (!skirmishes.empty()) {
+        std::vector<std::unique_ptr<TranspositionTable>> tables(pool.size());
+        std::vector<TacticalResult> results(skirmishes.size());
+        pool.parallelFor(skirmishes.size(), [&](size_t index, unsigned int worker) {
+            if (!tables[worker]) {
+                tables[worker] = std::make_unique<TranspositionTable>(transpositionBuckets);
+            } else {
+                tables[worker]->clear();
             }
-        } else if (unit.getName() == "Worker") {
-            // Find the nearest mine using pathfinding
-            auto [mineX, mineY] = findSpecifiedObject(map, unit.getPositionX(), unit.getPositionY(), '6');
-
-            // Write the order to move the worker towards the mine
-            ordersFile << unit.getId() << " M " << mineX << " " << mineY << std::endl;
-
-            // Move the worker towards the mine
-            unit.moveAction(mineX, mineY, enemy.getPlayerUnits(), map);
-        } else {
-            // Find the nearest enemy base using pathfinding
-            auto [baseX, baseY] = findSpecifiedObject(map, unit.getPositionX(), unit.getPositionY(), '2');
-
-            // Use the pathfinding algorithm to find the shortest path to the enemy base
-            std::vector<std::vector<int>> path = performBFS(map, unit.getPositionX(), unit.getPositionY());
-
-            // Move the unit along the path and attack any enemy units encountered
-            for (const auto& cell : path) {
-                // Check if there are enemy units at the current position
-                for (const Unit& enemyUnit : player.getPlayerUnits()) {
-                    if (!enemyUnit.getOwner() && enemyUnit.getPositionX() == cell[0] && enemyUnit.getPositionY() == cell[1]) {
-                        // Write the order to attack the enemy unit
-                        ordersFile << unit.getId() << " A " << enemyUnit.getId() << std::endl;
-
-                        // Attack the enemy unit
-                        unit.attackAction(enemyUnit.getId(), enemy.getPlayerUnits());
-                    }
-                }
+            results[index] = TacticalSearch(map, *tables[worker]).search(skirmishes[index], token);
+        });
 
-                // Write the order to move to the next position
-                ordersFile << unit.getId() << " M " << cell[0] << " " << cell[1] << std::endl;
-
-                // Move the unit to the next position
-                unit.moveAction(cell[0], cell[1], player.getPlayerUnits(), map);
+        std::unordered_map<unsigned short, size_t> indexOf;
+        for (size_t index = 0; index < units.size(); ++index) {
+            indexOf[units[index].getId()] = index;
+        }
+        size_t nodes = 0;
+        TranspositionStatistics statistics;
+        for (const TacticalResult& result : results) {
+            for (unsigned short id : result.unitIds) {
+                searched[indexOf[id]] = true;
+                ++decided;
             }
+            for (const Order& order : result.orders) {
+                unitOrders[indexOf[order.unitId]] += formatOrder(order) + "\n";
+            }
+            nodes += result.nodes;
+            statistics.add(result.statistics);
         }
+        std::cout << "Tactical search of " << skirmishes.size() << " skirmishes: " << nodes << " positions, "
+                  << statistics.getHitRate() * 100 << "% table hits" << std::endl;
     }
-}
-
-void performTurnWithTimeout(std::ifstream& mapFile, std::ifstream& statusFile, std::ofstream& ordersFile, int timeoutInSeconds) {
-    bool isTimeout = false;
-    bool isTurnCompleted = false;
-
-    // Create a flag to track if the turn thread has finished
-    std::atomic<bool> turnFinished(false);
 
-
-    // Create a thread to perform the turn
-    std::thread turnThread([&]() {
-        // Call the performTurn function
-        performTurn(mapFile, statusFile, ordersFile);
-        isTurnCompleted = true;
-        turnFinished.store(true);
-    });
-
-    // Create a thread to monitor the timeout
-    std::thread timeoutThread([&]() {
-        // Sleep for the specified timeout duration
-        std::this_thread::sleep_for(std::chrono::seconds(timeoutInSeconds));
-
-        // If the timeout expires and the turn is not completed, set the flag
-        if (!isTurnCompleted) {
-            isTimeout = true;
+    // Decide the orders of every other unit in parallel, with one search workspace per worker
+    std::vector<std::unique_ptr<BitBFS>> scratch(pool.size());
+    pool.parallelFor(units.size(), [&](size_t index, unsigned int worker) {
+        if (token.isCancelled() || searched[index]) {
+            return;
         }
-
-        // Notify the turn thread to finish early
-        turnFinished.store(true);
+        TraceSpan unitSpan("decideUnitOrders", "bot", "unit", units[index].getId());
+        if (!scratch[worker]) {
+            scratch[worker] = std::make_unique<BitBFS>(map);
+        }
+        std::seed_seq seed = {turnSeed, static_cast<unsigned int>(units[index].getId())};
+        std::mt19937 gen(seed);
+        unitOrders[index] = decideUnitOrders(units[index], map, enemyUnits, enemyIndex, influence, mines, *scratch[worker], gen,
+                                              newUnitIds[index]);
+        ++decided;
     });
 
-    // Wait for the turn thread to complete or the timeout to expire
-    turnThread.join();
-
-    // Check if the turn thread finished before the timeout
-    if (!isTimeout && !turnFinished.load()) {
-        std::cout << "Turn completed early!" << std::endl;
-        return;  // Finish the function early
+    // Write the orders in unit ID order
+    std::string orders;
+    for (size_t index : byId) {
+        orders += unitOrders[index];
+    }
+    if (shared) {
+        submitSharedOrders(orders);
+    } else {
+        ordersFile << orders;
     }
+    if (decided < units.size()) {
+        std::cout << "Turn cancelled, orders of " << decided << " of " << units.size() << " units submitted" << std::endl;
+    }
+}
 
-    // Join the timeout thread
-    timeoutThread.join();
+// Perform a turn that is cancelled at the deadline. A turn finishing early returns at once,
+// and a cancelled turn still submits the orders it has decided.
+void performTurnWithDeadline(std::ifstream& mapFile, std::ifstream& statusFile, std::ofstream& ordersFile, unsigned int playerId, int timeoutInSeconds) {
+    CancellationSource source;
+    DeadlineTimer timer(source, deadlineAfter(timeoutInSeconds * turnTimeFraction));
+    performTurn(mapFile, statusFile, ordersFile, playerId, source.getToken());
+    timer.stop();
 
-    // Check if the timeout occurred
-    if (isTimeout) {
-        throw std::runtime_error("Timeout occurred!");
+    if (timer.hasExpired()) {
+        std::cout << "The time limit has been reached!" << std::endl;
     }
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 4 || argc > 5) {
-        std::cerr << "Invalid amount of arguments. Usage: ./defensive.o <map file> <status file> <orders file> [time limit]" << std::endl;
+    if (argc < 5 || argc > 6) {
+        std::cerr << "Invalid amount of arguments. Usage: ./defensive.o <map file> <status file> <orders file> <player id> [time limit]" << std::endl;
         return 1;
     }
 
     std::string mapFile = argv[1];
     std::string statusFile = argv[2];
     std::string ordersFile = argv[3];
+    // The ID of the player the bot plays, the status file gives the owner ID of every unit
+    unsigned int playerId = std::stoi(argv[4]);
     unsigned int timeLimit = 5;
 
-    if (argc == 5) {
-        timeLimit = std::stoi(argv[4]);
+    if (playerId >= maxPlayers) {
+        std::cerr << "Invalid player ID: " << argv[4] << std::endl;
+        return 1;
+    }
+    if (argc == 6) {
+        timeLimit = std::stoi(argv[5]);
     }
 
+    // Every turn of the player is traced on the same lane, whichever process plays it
+    Tracer::get().setProcess(traceBotLane + playerId, "Player " + std::to_string(playerId + 1) + " (" + argv[0] + ")");
+
     // Open files
     std::ifstream mapFileStream(mapFile);
     std::ifstream statusFileStream(statusFile);
@@ -311,10 +311,14 @@ int main(int argc, char* argv[]) {
     }
 
     try {
-        // Call the performTurnWithTimeout function with the specified time limit
-        performTurnWithTimeout(mapFileStream, statusFileStream, ordersFileStream, timeLimit);
+        // Call the performTurnWithDeadline function with the specified time limit, a limit of 0 means no limit
+        if (timeLimit == 0) {
+            performTurn(mapFileStream, statusFileStream, ordersFileStream, playerId);
+        } else {
+            performTurnWithDeadline(mapFileStream, statusFileStream, ordersFileStream, playerId, timeLimit);
+        }
 
-        // The performTurn function completed within the specified time limit
+        // The performTurn function has submitted its orders
         std::cout << "Defensive Player has finished their turn!" << std::endl;
     } catch (const std::runtime_error& e) {
         // Handle the timeout error
@@ -0,0 +1,69 @@
+#include "economy.hpp"
+#include <algorithm>
+
+MineMap::MineMap(const Map& map)
+    : width(map.getWidth()), height(map.getHeight()), wordsPerRow((map.getWidth() + 63) / 64),
+      bits(wordsPerRow * map.getHeight(), 0) {
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            if (map.getCell(x, y) == '6') {
+                bits[y * wordsPerRow + x / 64] |= std::uint64_t(1) << (x % 64);
+                mineIndices[y * width + x] = mines.size();
+                mines.push_back({static_cast<unsigned short>(x), static_cast<unsigned short>(y)});
+            }
+        }
+    }
+}
+
+int MineMap::getMineIndex(unsigned short x, unsigned short y) const {
+    if (!isMine(x, y)) {
+        return -1;
+    }
+    return mineIndices.at(y * width + x);
+}
+
+const std::vector<std::pair<unsigned short, unsigned short>>& MineMap::getMines() const {
+    return mines;
+}
+
+Economy::Economy(const Map& map, unsigned int workerGold)
+    : mineMap(map), workerGold(workerGold), occupancy(mineMap.getMines().size(), 0), income{} {
+}
+
+void Economy::step(const std::vector<Player*>& players) {
+    std::fill(occupancy.begin(), occupancy.end(), 0);
+    std::fill(std::begin(income), std::end(income), 0);
+
+    // Count the workers on every mine. Only cells that pass the bitmap test are looked up.
+    for (Player* player : players) {
+        for (const Unit& unit : player->getPlayerUnits()) {
+            if (!earnsGold(unit)) {
+                continue;
+            }
+            ++occupancy[mineMap.getMineIndex(unit.getPositionX(), unit.getPositionY())];
+            income[player->getID()] += workerGold;
+        }
+    }
+
+    // Credit every player once
+    for (Player* player : players) {
+        player->setGold(player->getGold() + income[player->getID()]);
+    }
+}
+
+unsigned int Economy::computeIncome(const std::vector<Unit>& units) const {
+    unsigned int workers = std::count_if(units.begin(), units.end(), [this](const Unit& unit) { return earnsGold(unit); });
+    return workers * workerGold;
+}
+
+const MineMap& Economy::getMineMap() const {
+    return mineMap;
+}
+
+std::uint16_t Economy::getOccupancy(unsigned int mineIndex) const {
+    return mineIndex < occupancy.size() ? occupancy[mineIndex] : 0;
+}
+
+unsigned int Economy::getIncome(OwnerId owner) const {
+    return income[owner];
+}
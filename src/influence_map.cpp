@@ -0,0 +1,221 @@
+#include "influence_map.hpp"
+#include "combat.hpp"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+// The number of unit types in the damage matrix
+constexpr unsigned int typeCount = 8;
+
+// The damage of each attacker type to every target type, as one row per attacker
+using DamageRow = std::array<std::uint32_t, typeCount>;
+
+const std::array<DamageRow, typeCount>& damageRows() {
+    static const std::array<DamageRow, typeCount> rows = []() {
+        std::array<DamageRow, typeCount> result = {};
+        for (unsigned int attacker = 0; attacker < typeCount; ++attacker) {
+            for (unsigned int target = 0; target < typeCount; ++target) {
+                result[attacker][target] = CombatStage::damage(attacker, target);
+            }
+        }
+        // Bases cannot attack
+        result[CombatStage::typeIndex('B')].fill(0);
+        return result;
+    }();
+    return rows;
+}
+
+}  // namespace
+
+InfluenceMap::InfluenceMap(unsigned int width, unsigned int height) : width(width), height(height) {
+    for (bool owner : {false, true}) {
+        threat[owner].assign(typeCount * width * height, 0);
+        influence[owner].assign(width * height, 0);
+    }
+}
+
+void InfluenceMap::rebuild(const std::vector<const std::vector<Unit>*>& armies) {
+    for (bool owner : {false, true}) {
+        std::fill(threat[owner].begin(), threat[owner].end(), 0);
+        std::fill(influence[owner].begin(), influence[owner].end(), 0);
+    }
+    for (const std::vector<Unit>* army : armies) {
+        for (const Unit& unit : *army) {
+            if (unit.getHealth() > 0) {
+                addUnit(unit);
+            }
+        }
+    }
+}
+
+void InfluenceMap::addUnit(const Unit& unit) {
+    applyStencil(unit, unit.getPositionX(), unit.getPositionY(), 1);
+}
+
+void InfluenceMap::removeUnit(const Unit& unit) {
+    applyStencil(unit, unit.getPositionX(), unit.getPositionY(), -1);
+}
+
+void InfluenceMap::moveUnit(const Unit& unit, unsigned short fromX, unsigned short fromY) {
+    if (fromX == unit.getPositionX() && fromY == unit.getPositionY()) {
+        return;
+    }
+    applyStencil(unit, fromX, fromY, -1);
+    applyStencil(unit, unit.getPositionX(), unit.getPositionY(), 1);
+}
+
+std::uint32_t InfluenceMap::getThreat(bool owner, unsigned short x, unsigned short y, std::uint8_t targetType) const {
+    if (x >= width || y >= height || targetType >= typeCount) {
+        return 0;
+    }
+    return threat[owner][(y * width + x) * typeCount + targetType];
+}
+
+std::uint32_t InfluenceMap::getThreat(bool owner, unsigned short x, unsigned short y, const Unit& target) const {
+    return getThreat(owner, x, y, CombatStage::typeIndex(target.getInitial()));
+}
+
+std::uint16_t InfluenceMap::getInfluence(bool owner, unsigned short x, unsigned short y) const {
+    if (x >= width || y >= height) {
+        return 0;
+    }
+    return influence[owner][y * width + x];
+}
+
+void InfluenceMap::applyStencil(const Unit& unit, unsigned short x, unsigned short y, int sign) {
+    std::uint8_t attackerType = CombatStage::typeIndex(unit.getInitial());
+    if (attackerType >= typeCount || unit.getAttackRange() == 0) {
+        return;
+    }
+
+    // Subtraction relies on unsigned wrap-around, so removing a stencil exactly undoes adding it
+    DamageRow damage = damageRows()[attackerType];
+    for (std::uint32_t& amount : damage) {
+        amount *= static_cast<std::uint32_t>(sign);
+    }
+    std::uint16_t count = static_cast<std::uint16_t>(sign);
+
+    // Walk the rows of the diamond, clipped to the map
+    int radius = unit.getAttackRange();
+    bool owner = unit.getOwner() != 0;
+    for (int dy = -radius; dy <= radius; ++dy) {
+        int cellY = y + dy;
+        if (cellY < 0 || cellY >= static_cast<int>(height)) {
+            continue;
+        }
+        int halfWidth = radius - std::abs(dy);
+        int startX = std::max(0, x - halfWidth);
+        int endX = std::min(static_cast<int>(width) - 1, x + halfWidth);
+        if (startX > endX) {
+            continue;
+        }
+
+        std::uint32_t* cells = &threat[owner][(cellY * width + startX) * typeCount];
+        for (int cellX = startX; cellX <= endX; ++cellX, cells += typeCount) {
+            for (unsigned int type = 0; type < typeCount; ++type) {
+                cells[type] += damage[type];
+            }
+        }
+        std::uint16_t* row = &influence[owner][cellY * width];
+        for (int cellX = startX; cellX <= endX; ++cellX) {
+            row[cellX] += count;
+        }
+    }
+}
+
+bool InfluenceOverlay::Stencil::covers(unsigned short cellX, unsigned short cellY) const {
+    return std::abs(static_cast<int>(cellX) - x) + std::abs(static_cast<int>(cellY) - y) <= range;
+}
+
+InfluenceOverlay::InfluenceOverlay(unsigned int width, unsigned int height, const std::vector<const std::vector<Unit>*>& armies)
+    : width(width), height(height) {
+    auto shared = std::make_shared<InfluenceMap>(width, height);
+    shared->rebuild(armies);
+    base = std::move(shared);
+}
+
+std::optional<InfluenceOverlay::Stencil> InfluenceOverlay::stencilOf(const Unit& unit, unsigned short x, unsigned short y) {
+    // Units adding nothing to the maps have no stencil, as in InfluenceMap::applyStencil
+    std::uint8_t type = CombatStage::typeIndex(unit.getInitial());
+    if (type >= typeCount || unit.getAttackRange() == 0) {
+        return std::nullopt;
+    }
+    return Stencil{unit.getOwner() != 0, type, static_cast<unsigned short>(unit.getAttackRange()), x, y};
+}
+
+InfluenceOverlay::Change& InfluenceOverlay::findChange(const Unit& unit, unsigned short x, unsigned short y) {
+    for (Change& change : changes) {
+        if (change.unitId == unit.getId()) {
+            return change;
+        }
+    }
+    // A unit seen for the first time is still where the shared maps have it
+    std::optional<Stencil> stencil = stencilOf(unit, x, y);
+    changes.push_back({unit.getId(), stencil, stencil});
+    return changes.back();
+}
+
+void InfluenceOverlay::dropIfUnchanged(Change& change) {
+    bool same = change.shared.has_value() == change.current.has_value() &&
+                (!change.shared || (change.shared->x == change.current->x && change.shared->y == change.current->y));
+    if (same) {
+        change = changes.back();
+        changes.pop_back();
+    }
+}
+
+void InfluenceOverlay::addUnit(const Unit& unit) {
+    // Spawned units are not in the shared maps
+    changes.push_back({unit.getId(), std::nullopt, stencilOf(unit, unit.getPositionX(), unit.getPositionY())});
+    dropIfUnchanged(changes.back());
+}
+
+void InfluenceOverlay::removeUnit(const Unit& unit) {
+    Change& change = findChange(unit, unit.getPositionX(), unit.getPositionY());
+    change.current.reset();
+    dropIfUnchanged(change);
+}
+
+void InfluenceOverlay::moveUnit(const Unit& unit, unsigned short fromX, unsigned short fromY) {
+    if (fromX == unit.getPositionX() && fromY == unit.getPositionY()) {
+        return;
+    }
+    Change& change = findChange(unit, fromX, fromY);
+    change.current = stencilOf(unit, unit.getPositionX(), unit.getPositionY());
+    dropIfUnchanged(change);
+}
+
+std::uint32_t InfluenceOverlay::getThreat(bool owner, unsigned short x, unsigned short y, const Unit& target) const {
+    std::uint8_t targetType = CombatStage::typeIndex(target.getInitial());
+    if (x >= width || y >= height || targetType >= typeCount) {
+        return 0;
+    }
+    // Unsigned wrap-around cancels the subtractions against the shared value, as in applyStencil
+    std::uint32_t threat = base->getThreat(owner, x, y, targetType);
+    for (const Change& change : changes) {
+        if (change.shared && change.shared->owner == owner && change.shared->covers(x, y)) {
+            threat -= damageRows()[change.shared->type][targetType];
+        }
+        if (change.current && change.current->owner == owner && change.current->covers(x, y)) {
+            threat += damageRows()[change.current->type][targetType];
+        }
+    }
+    return threat;
+}
+
+std::uint16_t InfluenceOverlay::getInfluence(bool owner, unsigned short x, unsigned short y) const {
+    if (x >= width || y >= height) {
+        return 0;
+    }
+    std::uint16_t count = base->getInfluence(owner, x, y);
+    for (const Change& change : changes) {
+        count -= change.shared && change.shared->owner == owner && change.shared->covers(x, y);
+        count += change.current && change.current->owner == owner && change.current->covers(x, y);
+    }
+    return count;
+}
+
+size_t InfluenceOverlay::getChangeCount() const {
+    return changes.size();
+}
@@ -1,10 +1,63 @@
 #include "map.hpp"
+#include <algorithm>
+
+namespace {
+
+// Disjoint sets of cells. The root of a set is its lowest cell index, so the sets can be
+// numbered in row order of their first cell.
+class UnionFind {
+private:
+    std::vector<std::uint32_t> parent;
+
+public:
+    explicit UnionFind(size_t size) : parent(size) {
+        for (size_t index = 0; index < size; ++index) {
+            parent[index] = static_cast<std::uint32_t>(index);
+        }
+    }
+
+    std::uint32_t find(std::uint32_t index) {
+        // Path halving: every visited cell is pointed at its grandparent
+        while (parent[index] != index) {
+            parent[index] = parent[parent[index]];
+            index = parent[index];
+        }
+        return index;
+    }
+
+    void unite(std::uint32_t a, std::uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a < b) {
+            parent[b] = a;
+        } else if (b < a) {
+            parent[a] = b;
+        }
+    }
+};
+
+// Number the sets of the passable cells in row order, obstacles get Map::noLabel
+std::uint32_t numberSets(UnionFind& sets, const std::vector<char>& passable, std::int32_t* labels) {
+    std::uint32_t count = 0;
+    for (size_t index = 0; index < passable.size(); ++index) {
+        if (!passable[index]) {
+            labels[index] = static_cast<std::int32_t>(Map::noLabel);
+            continue;
+        }
+        std::uint32_t root = sets.find(static_cast<std::uint32_t>(index));
+        // The root comes first in row order, so it has been numbered already unless it is this cell
+        labels[index] = root == index ? static_cast<std::int32_t>(count++) : labels[root];
+    }
+    return count;
+}
+
+}  // namespace
 
 Map::Map(const std::string& filename) {
     loadMapFromFile(filename);
 }
 
-Map::Map(std::ifstream& file) {
+Map::Map(std::istream& file, Topology topology) {
     if (!file) {
         throw std::runtime_error("Failed to open map file");
     }
@@ -23,6 +76,29 @@ Map::Map(std::ifstream& file) {
     }
 
     validateMapData();
+    packPassableCells();
+    if (topology == Topology::Labelled) {
+        labelTopology();
+    }
+}
+
+Map::Map(unsigned int width, unsigned int height, const char* cells, Topology topology) {
+    grid.reserve(height);
+    for (unsigned int y = 0; y < height; ++y) {
+        const char* row = cells + static_cast<size_t>(y) * width;
+        for (unsigned int x = 0; x < width; ++x) {
+            if (!isValidCellCharacter(row[x])) {
+                throw std::runtime_error(std::string("Invalid character: ") + row[x]);
+            }
+        }
+        grid.emplace_back(row, row + width);
+    }
+
+    validateMapData();
+    packPassableCells();
+    if (topology == Topology::Labelled) {
+        labelTopology();
+    }
 }
 
 unsigned int Map::getWidth() const {
@@ -53,6 +129,30 @@ std::pair<unsigned int, unsigned int> Map::getBasePosition(char baseCell) const
     throw std::runtime_error("No base position found in the map.");
 }
 
+char Map::baseMarker(OwnerId owner) {
+    return owner < 2 ? static_cast<char>('1' + owner) : static_cast<char>('a' + owner);
+}
+
+unsigned int Map::getBaseCount() const {
+    // Note which markers appear in a single pass over the grid
+    bool present[maxPlayers] = {};
+    for (const auto& row : grid) {
+        for (char cell : row) {
+            if (cell == '1' || cell == '2') {
+                present[cell - '1'] = true;
+            } else if (cell >= baseMarker(2) && cell <= baseMarker(maxPlayers - 1)) {
+                present[cell - 'a'] = true;
+            }
+        }
+    }
+
+    unsigned int count = 0;
+    while (count < maxPlayers && present[count]) {
+        ++count;
+    }
+    return count;
+}
+
 void Map::loadMapFromFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file) {
@@ -73,6 +173,220 @@ void Map::loadMapFromFile(const std::string& filename) {
     }
 
     validateMapData();
+    packPassableCells();
+    labelTopology();
+}
+
+std::uint64_t Map::computeHash() const {
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](unsigned char byte) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    };
+    for (unsigned int dimension : {getWidth(), getHeight()}) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            mix(static_cast<unsigned char>(dimension >> shift));
+        }
+    }
+    for (const auto& row : grid) {
+        for (char cell : row) {
+            mix(static_cast<unsigned char>(cell));
+        }
+    }
+    return hash;
+}
+
+std::uint32_t Map::getComponent(unsigned int x, unsigned int y) const {
+    if (x >= getWidth() || y >= getHeight()) {
+        throw std::out_of_range("Invalid cell coordinates.");
+    }
+    if (!labels) {
+        throw std::runtime_error("The topology of the map has not been labelled.");
+    }
+    return static_cast<std::uint32_t>(labels.get()[static_cast<size_t>(y) * getWidth() + x]);
+}
+
+std::uint32_t Map::getComponentCount() const {
+    return componentCount;
+}
+
+bool Map::isReachable(unsigned int fromX, unsigned int fromY, unsigned int toX, unsigned int toY) const {
+    std::uint32_t component = getComponent(fromX, fromY);
+    return component != noLabel && component == getComponent(toX, toY);
+}
+
+std::uint32_t Map::getRegion(unsigned int x, unsigned int y) const {
+    if (x >= getWidth() || y >= getHeight()) {
+        throw std::out_of_range("Invalid cell coordinates.");
+    }
+    if (!labels) {
+        throw std::runtime_error("The topology of the map has not been labelled.");
+    }
+    size_t cells = static_cast<size_t>(getWidth()) * getHeight();
+    return static_cast<std::uint32_t>(labels.get()[cells + static_cast<size_t>(y) * getWidth() + x]);
+}
+
+std::uint32_t Map::getRegionCount() const {
+    return regionLinks.size();
+}
+
+const std::vector<RegionLink>& Map::getRegionLinks(std::uint32_t region) const {
+    if (region >= regionLinks.size()) {
+        throw std::out_of_range("Invalid region.");
+    }
+    return regionLinks[region];
+}
+
+bool Map::isChokepoint(unsigned int x, unsigned int y) const {
+    if (x >= getWidth() || y >= getHeight()) {
+        throw std::out_of_range("Invalid cell coordinates.");
+    }
+    if (chokepoints.empty()) {
+        throw std::runtime_error("The topology of the map has not been labelled.");
+    }
+    return chokepoints[static_cast<size_t>(y) * getWidth() + x];
+}
+
+const BitGrid& Map::getPassableBits() const {
+    return passableBits;
+}
+
+bool Map::hasTopology() const {
+    return labels != nullptr;
+}
+
+void Map::packPassableCells() {
+    passableBits = BitGrid(getWidth(), getHeight());
+    for (unsigned int y = 0; y < getHeight(); ++y) {
+        for (unsigned int x = 0; x < getWidth(); ++x) {
+            if (grid[y][x] != '9') {
+                passableBits.set(x, y);
+            }
+        }
+    }
+}
+
+void Map::labelTopology() {
+    auto computed = std::make_shared<std::vector<std::int32_t>>(computeTopologyLabels());
+    setTopologyLabels(std::shared_ptr<const std::int32_t>(computed, computed->data()));
+}
+
+std::vector<std::int32_t> Map::computeTopologyLabels() const {
+    unsigned int width = getWidth();
+    unsigned int height = getHeight();
+    size_t cells = static_cast<size_t>(width) * height;
+    if (cells > noLabel) {
+        throw std::runtime_error("The map has too many cells to label.");
+    }
+
+    std::vector<char> passable(cells);
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            passable[static_cast<size_t>(y) * width + x] = grid[y][x] != '9';
+        }
+    }
+
+    // Join every passable cell with its passable neighbours to the left and above. Regions
+    // only join neighbours within the same sector.
+    UnionFind componentSets(cells);
+    UnionFind regionSets(cells);
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            std::uint32_t index = y * width + x;
+            if (!passable[index]) {
+                continue;
+            }
+            if (x > 0 && passable[index - 1]) {
+                componentSets.unite(index, index - 1);
+                if (x % regionSize != 0) {
+                    regionSets.unite(index, index - 1);
+                }
+            }
+            if (y > 0 && passable[index - width]) {
+                componentSets.unite(index, index - width);
+                if (y % regionSize != 0) {
+                    regionSets.unite(index, index - width);
+                }
+            }
+        }
+    }
+    std::vector<std::int32_t> planes(cells * 2);
+    numberSets(componentSets, passable, planes.data());
+    numberSets(regionSets, passable, planes.data() + cells);
+    return planes;
+}
+
+void Map::setTopologyLabels(std::shared_ptr<const std::int32_t> topologyLabels) {
+    unsigned int width = getWidth();
+    unsigned int height = getHeight();
+    size_t cells = static_cast<size_t>(width) * height;
+    labels = std::move(topologyLabels);
+    const std::uint32_t* components = reinterpret_cast<const std::uint32_t*>(labels.get());
+    const std::uint32_t* regions = components + cells;
+
+    // Labels are numbered from 0 in row order, so the counts are one past the largest labels.
+    // Obstacles are labelled noLabel, which wraps around to 0.
+    componentCount = 0;
+    std::uint32_t regionCount = 0;
+    for (size_t index = 0; index < cells; ++index) {
+        componentCount = std::max(componentCount, components[index] + 1);
+        regionCount = std::max(regionCount, regions[index] + 1);
+    }
+    regionLinks.assign(regionCount, {});
+
+    // Every run of passable cell pairs across a sector border between the same two regions
+    // is an entrance. The middle pair of the run stands for it in the links of both regions.
+    chokepoints.assign(cells, false);
+    auto addEntrance = [&](unsigned int firstX, unsigned int firstY, unsigned int stepX, unsigned int stepY,
+                           unsigned int acrossX, unsigned int acrossY, unsigned int length) {
+        unsigned int middleX = firstX + stepX * (length / 2);
+        unsigned int middleY = firstY + stepY * (length / 2);
+        std::uint32_t from = regions[static_cast<size_t>(middleY) * width + middleX];
+        std::uint32_t to = regions[static_cast<size_t>(middleY + acrossY) * width + middleX + acrossX];
+        regionLinks[from].push_back({to, middleX, middleY, middleX + acrossX, middleY + acrossY, length});
+        regionLinks[to].push_back({from, middleX + acrossX, middleY + acrossY, middleX, middleY, length});
+        if (length <= maxChokepointWidth) {
+            for (unsigned int step = 0; step < length; ++step) {
+                size_t index = static_cast<size_t>(firstY + stepY * step) * width + firstX + stepX * step;
+                chokepoints[index] = true;
+                chokepoints[index + static_cast<size_t>(acrossY) * width + acrossX] = true;
+            }
+        }
+    };
+
+    // Walk along a sector border, cutting runs where a pair is blocked or the regions change
+    auto scanBorder = [&](unsigned int startX, unsigned int startY, unsigned int stepX, unsigned int stepY,
+                          unsigned int acrossX, unsigned int acrossY, unsigned int length) {
+        unsigned int runLength = 0;
+        std::uint32_t runFrom = noLabel;
+        std::uint32_t runTo = noLabel;
+        for (unsigned int step = 0; step <= length; ++step) {
+            std::uint32_t from = noLabel;
+            std::uint32_t to = noLabel;
+            if (step < length) {
+                size_t index = static_cast<size_t>(startY + stepY * step) * width + startX + stepX * step;
+                from = regions[index];
+                to = regions[index + static_cast<size_t>(acrossY) * width + acrossX];
+            }
+            bool open = from != noLabel && to != noLabel;
+            if (runLength > 0 && (!open || from != runFrom || to != runTo)) {
+                addEntrance(startX + stepX * (step - runLength), startY + stepY * (step - runLength), stepX, stepY, acrossX, acrossY, runLength);
+                runLength = 0;
+            }
+            if (open) {
+                runFrom = from;
+                runTo = to;
+                ++runLength;
+            }
+        }
+    };
+
+    for (unsigned int x = regionSize; x < width; x += regionSize) {
+        scanBorder(x - 1, 0, 0, 1, 1, 0, height);
+    }
+    for (unsigned int y = regionSize; y < height; y += regionSize) {
+        scanBorder(0, y - 1, 1, 0, 0, 1, width);
+    }
 }
 
 void Map::validateMapData() const {
@@ -94,7 +408,7 @@ void Map::validateMapData() const {
 
 bool Map::isValidCellCharacter(char c) const {
     // Define the valid cell characters
-    std::string validCharacters = "01269";
+    std::string validCharacters = "01269cdefghijklmnop";
 
     // Check if the character is in the valid characters set
     return validCharacters.find(c) != std::string::npos;
@@ -0,0 +1,250 @@
+#include "map_cache.hpp"
+#include "trace.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(MapCacheHeader) == 40, "MapCacheHeader is part of the binary layout.");
+static_assert(sizeof(MapCacheHeader) % alignof(std::int32_t) == 0, "The values must be aligned in the mapping.");
+
+namespace {
+
+// Map a cache file if its header matches the map, the artifact and the file size
+std::optional<CachedArray> mapFile(const std::string& path, std::uint64_t mapHash, const Map& map, unsigned int planeCount) {
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return std::nullopt;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(MapCacheHeader)) {
+        close(descriptor);
+        return std::nullopt;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (address == MAP_FAILED) {
+        return std::nullopt;
+    }
+
+    const MapCacheHeader& header = *static_cast<const MapCacheHeader*>(address);
+    std::uint64_t valueCount = std::uint64_t(planeCount) * map.getWidth() * map.getHeight();
+    if (header.magic != mapCacheMagic || header.version != mapCacheVersion || header.mapHash != mapHash ||
+        header.width != map.getWidth() || header.height != map.getHeight() || header.planeCount != planeCount ||
+        header.valueCount != valueCount || size != sizeof(MapCacheHeader) + valueCount * sizeof(std::int32_t)) {
+        munmap(address, size);
+        return std::nullopt;
+    }
+    return CachedArray(address, size, sizeof(MapCacheHeader), valueCount);
+}
+
+// Write a cache file under a temporary name and rename it into place. Failures are ignored,
+// the artifact is computed again on the next use.
+void storeFile(const std::string& directory, const std::string& path, const MapCacheHeader& header, const std::vector<std::int32_t>& values) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        return;
+    }
+
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(std::int32_t));
+        if (!file.flush()) {
+            file.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+}  // namespace
+
+CachedArray::CachedArray(std::vector<std::int32_t> values)
+    : owned(std::move(values)), mapping(nullptr), mappingSize(0), values(owned.data()), count(owned.size()) {
+}
+
+CachedArray::CachedArray(void* mapping, size_t mappingSize, size_t offset, size_t count)
+    : mapping(mapping), mappingSize(mappingSize),
+      values(reinterpret_cast<const std::int32_t*>(static_cast<const char*>(mapping) + offset)), count(count) {
+}
+
+CachedArray::CachedArray(CachedArray&& other) noexcept
+    : owned(std::move(other.owned)), mapping(other.mapping), mappingSize(other.mappingSize),
+      values(other.mapping ? other.values : owned.data()), count(other.count) {
+    other.mapping = nullptr;
+    other.values = nullptr;
+    other.count = 0;
+}
+
+CachedArray& CachedArray::operator=(CachedArray&& other) noexcept {
+    if (this != &other) {
+        if (mapping) {
+            munmap(mapping, mappingSize);
+        }
+        owned = std::move(other.owned);
+        mapping = other.mapping;
+        mappingSize = other.mappingSize;
+        values = other.mapping ? other.values : owned.data();
+        count = other.count;
+        other.mapping = nullptr;
+        other.values = nullptr;
+        other.count = 0;
+    }
+    return *this;
+}
+
+CachedArray::~CachedArray() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+}
+
+const std::int32_t* CachedArray::data() const {
+    return values;
+}
+
+size_t CachedArray::size() const {
+    return count;
+}
+
+bool CachedArray::isMapped() const {
+    return mapping != nullptr;
+}
+
+MapCache::MapCache(const Map& map, std::string directory) : map(map), directory(std::move(directory)), mapHash(map.computeHash()) {
+}
+
+std::string MapCache::getDefaultDirectory() {
+    const char* directory = std::getenv(mapCacheVariable);
+    return directory && *directory ? directory : defaultMapCacheDirectory;
+}
+
+std::string MapCache::getPath(const std::string& artifact) const {
+    std::ostringstream path;
+    path << directory << '/' << std::hex << std::setw(16) << std::setfill('0') << mapHash << '_' << artifact << ".bin";
+    return path.str();
+}
+
+CachedArray MapCache::load(const std::string& artifact, unsigned int planeCount, const std::function<std::vector<std::int32_t>()>& compute) const {
+    TraceSpan span("MapCache::load", "bot");
+    std::string path = getPath(artifact);
+    if (std::optional<CachedArray> cached = mapFile(path, mapHash, map, planeCount)) {
+        return std::move(*cached);
+    }
+
+    std::vector<std::int32_t> values = compute();
+    std::uint64_t valueCount = std::uint64_t(planeCount) * map.getWidth() * map.getHeight();
+    if (values.size() != valueCount) {
+        throw std::runtime_error("The artifact " + artifact + " has " + std::to_string(values.size()) + " values, expected " +
+                                 std::to_string(valueCount) + ".");
+    }
+
+    MapCacheHeader header = {mapCacheMagic, mapCacheVersion, mapHash, map.getWidth(), map.getHeight(), planeCount, 0, valueCount};
+    storeFile(directory, path, header, values);
+    return CachedArray(std::move(values));
+}
+
+const Map& MapCache::getMap() const {
+    return map;
+}
+
+bool loadTopology(Map& map, const MapCache& cache) {
+    TraceSpan span("loadTopology", "bot");
+    if (&cache.getMap() != &map) {
+        throw std::runtime_error("The cache belongs to another map.");
+    }
+    // The map keeps the labels where they are, in the mapping of the cache file when there is one
+    auto labels = std::make_shared<CachedArray>(cache.load("topology", 2, [&]() { return map.computeTopologyLabels(); }));
+    map.setTopologyLabels(std::shared_ptr<const std::int32_t>(labels, labels->data()));
+    return labels->isMapped();
+}
+
+MineFields::MineFields(const MapCache& cache)
+    : width(cache.getMap().getWidth()), cellCount(static_cast<size_t>(cache.getMap().getWidth()) * cache.getMap().getHeight()),
+      planes(cache.load("mines", 2, [&]() { return compute(cache.getMap()); })) {
+}
+
+std::vector<std::int32_t> MineFields::compute(const Map& map) {
+    unsigned int width = map.getWidth();
+    unsigned int height = map.getHeight();
+    size_t cells = static_cast<size_t>(width) * height;
+    std::vector<std::int32_t> planes(2 * cells, -1);
+    std::int32_t* distance = planes.data();
+    std::int32_t* nearest = planes.data() + cells;
+
+    // The mines are queued in row order, and a cell reached from several mines at the same
+    // level keeps the first of them. The queue holds one level after the other, so the
+    // nearest mine of a cell is settled before the cell is expanded.
+    std::vector<std::uint32_t> queue;
+    queue.reserve(cells);
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            if (map.getCell(x, y) == '6') {
+                size_t index = static_cast<size_t>(y) * width + x;
+                distance[index] = 0;
+                nearest[index] = static_cast<std::int32_t>(index);
+                queue.push_back(static_cast<std::uint32_t>(index));
+            }
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        size_t index = queue[head];
+        unsigned int x = index % width;
+        unsigned int y = index / width;
+        const int neighbors[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        for (const auto& offset : neighbors) {
+            unsigned int nx = x + offset[0];
+            unsigned int ny = y + offset[1];
+            if (nx >= width || ny >= height || map.getCell(nx, ny) == '9') {
+                continue;
+            }
+            size_t neighbor = static_cast<size_t>(ny) * width + nx;
+            if (distance[neighbor] == -1) {
+                distance[neighbor] = distance[index] + 1;
+                nearest[neighbor] = nearest[index];
+                queue.push_back(static_cast<std::uint32_t>(neighbor));
+            } else if (distance[neighbor] == distance[index] + 1 && nearest[index] < nearest[neighbor]) {
+                nearest[neighbor] = nearest[index];
+            }
+        }
+    }
+
+    return planes;
+}
+
+int MineFields::getDistance(unsigned short x, unsigned short y) const {
+    return planes.data()[static_cast<size_t>(y) * width + x];
+}
+
+std::vector<int> MineFields::getDistanceField() const {
+    return std::vector<int>(planes.data(), planes.data() + cellCount);
+}
+
+std::optional<std::pair<unsigned short, unsigned short>> MineFields::findNearest(unsigned short x, unsigned short y) const {
+    std::int32_t mine = planes.data()[cellCount + static_cast<size_t>(y) * width + x];
+    if (mine < 0) {
+        return std::nullopt;
+    }
+    return std::make_pair(static_cast<unsigned short>(mine % width), static_cast<unsigned short>(mine / width));
+}
+
+bool MineFields::isCached() const {
+    return planes.isMapped();
+}
@@ -0,0 +1,459 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <queue>
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include "player.hpp"
+#include "pathfinding.hpp"
+#include "status.hpp"
+#include "simulator.hpp"
+#include "deadline.hpp"
+#include "map_cache.hpp"
+#include "trace.hpp"
+
+// Abstract per-turn order sets: what the base produces and how the army behaves
+const std::vector<char> productionChoices = {0, 'W', 'S', 'K', 'R', 'C', 'P', 'A'};
+const int stanceCount = 2;  // 0: advance on the enemy base, 1: hold near the own base
+const int actionCount = productionChoices.size() * stanceCount;
+
+// Search parameters
+const double explorationConstant = 1.41421356;
+const int rolloutTurns = 8;
+const double searchTimeFraction = 0.9;
+const unsigned long untimedIterations = 10000;  // The iterations of a search without a time limit
+
+// Distance fields used to steer the units of both sides
+struct DistanceFields {
+    unsigned int width = 0;
+    std::vector<int> toBase[2];     // Distance to the base of each side
+    std::vector<int> toMine;        // Distance to the nearest mine
+
+    int at(const std::vector<int>& field, unsigned short x, unsigned short y) const {
+        return field[static_cast<size_t>(y) * width + x];
+    }
+};
+
+// Calculate the distance from the nearest of several sources to every cell
+std::vector<int> multiSourceDistances(const Map& map, const std::vector<std::pair<unsigned short, unsigned short>>& sources) {
+    unsigned int width = map.getWidth();
+    unsigned int height = map.getHeight();
+    std::vector<int> distance(static_cast<size_t>(width) * height, -1);
+    std::queue<std::pair<unsigned short, unsigned short>> q;
+
+    for (const auto& [x, y] : sources) {
+        distance[static_cast<size_t>(y) * width + x] = 0;
+        q.push({x, y});
+    }
+
+    while (!q.empty()) {
+        auto [x, y] = q.front();
+        q.pop();
+        int current = distance[static_cast<size_t>(y) * width + x];
+        const int neighbors[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        for (const auto& offset : neighbors) {
+            unsigned short nx = x + offset[0];
+            unsigned short ny = y + offset[1];
+            if (nx < width && ny < height && map.getCell(nx, ny) != '9' && distance[static_cast<size_t>(ny) * width + nx] == -1) {
+                distance[static_cast<size_t>(ny) * width + nx] = current + 1;
+                q.push({nx, ny});
+            }
+        }
+    }
+
+    return distance;
+}
+
+// Load the distance field of a set of sources from the map cache, keyed by their positions.
+// The bases do not move, so every turn of a match after the first maps the same file.
+std::vector<int> cachedDistances(const MapCache& cache, std::vector<std::pair<unsigned short, unsigned short>> sources) {
+    std::sort(sources.begin(), sources.end());
+    std::string artifact = "distance";
+    for (const auto& [x, y] : sources) {
+        artifact += "_" + std::to_string(x) + "_" + std::to_string(y);
+    }
+    CachedArray field = cache.load(artifact, 1, [&]() {
+        std::vector<int> distance = multiSourceDistances(cache.getMap(), sources);
+        return std::vector<std::int32_t>(distance.begin(), distance.end());
+    });
+    return std::vector<int>(field.data(), field.data() + field.size());
+}
+
+DistanceFields buildDistanceFields(const Simulator& state, const MapCache& cache) {
+    const Map& map = state.getMap();
+    DistanceFields fields;
+    fields.width = map.getWidth();
+
+    for (bool side : {false, true}) {
+        std::vector<std::pair<unsigned short, unsigned short>> bases;
+        for (const Unit& unit : state.getUnits(side)) {
+            if (unit.getName() == "Base") {
+                bases.push_back({unit.getPositionX(), unit.getPositionY()});
+            }
+        }
+        fields.toBase[side] = cachedDistances(cache, bases);
+    }
+
+    fields.toMine = MineFields(cache).getDistanceField();
+
+    return fields;
+}
+
+// Move a unit to the cell within its speed that is closest according to the field. Cautious
+// units skip cells where the enemy units in range could destroy them.
+void stepToward(Simulator& state, bool side, unsigned short unitId, const std::vector<int>& field,
+                const DistanceFields& fields, std::vector<Order>* orders, bool cautious = false) {
+    const Unit* unit = state.findUnit(side, unitId);
+    const Map& map = state.getMap();
+    int x = unit->getPositionX();
+    int y = unit->getPositionY();
+    int speed = unit->getSpeed();
+    int best = fields.at(field, x, y);
+    if (best <= 0) {
+        return;  // Already there or unreachable
+    }
+
+    Order order;
+    order.unitId = unitId;
+    order.action = 'M';
+    bool found = false;
+    for (int dy = -speed; dy <= speed; ++dy) {
+        for (int dx = -(speed - std::abs(dy)); dx <= speed - std::abs(dy); ++dx) {
+            int nx = x + dx;
+            int ny = y + dy;
+            if (nx < 0 || ny < 0 || nx >= static_cast<int>(map.getWidth()) || ny >= static_cast<int>(map.getHeight())) {
+                continue;
+            }
+            if (cautious && state.getInfluenceMap().getThreat(!side, nx, ny, *unit) >= unit->getHealth()) {
+                continue;
+            }
+            int distance = fields.at(field, nx, ny);
+            if (distance >= 0 && distance < best) {
+                best = distance;
+                order.x = nx;
+                order.y = ny;
+                found = true;
+            }
+        }
+    }
+
+    if (found && state.applyOrder(side, order) && orders) {
+        orders->push_back(order);
+    }
+}
+
+// Attack the weakest enemy unit within range, if there is one
+bool attackInRange(Simulator& state, bool side, unsigned short unitId, std::vector<Order>* orders) {
+    const Unit* unit = state.findUnit(side, unitId);
+    const Unit* target = nullptr;
+    for (const Unit& enemyUnit : state.getUnits(!side)) {
+        if (enemyUnit.getHealth() > 0 && unit->calculateDistance(enemyUnit.getPositionX(), enemyUnit.getPositionY()) <= unit->getAttackRange() &&
+            (!target || enemyUnit.getHealth() < target->getHealth())) {
+            target = &enemyUnit;
+        }
+    }
+    if (!target) {
+        return false;
+    }
+
+    Order order;
+    order.unitId = unitId;
+    order.action = 'A';
+    order.targetId = target->getId();
+    if (!state.applyOrder(side, order)) {
+        return false;
+    }
+    if (orders) {
+        orders->push_back(order);
+    }
+    return true;
+}
+
+// Expand an abstract action into concrete orders, apply them and end the side's turn
+void playAction(Simulator& state, bool side, int action, const DistanceFields& fields, std::vector<Order>* orders = nullptr) {
+    char production = productionChoices[action / stanceCount];
+    int stance = action % stanceCount;
+
+    std::vector<std::pair<unsigned short, std::string>> units;
+    for (const Unit& unit : state.getUnits(side)) {
+        units.push_back({unit.getId(), unit.getName()});
+    }
+
+    for (const auto& [unitId, name] : units) {
+        if (name == "Base") {
+            if (production) {
+                Order order;
+                order.unitId = unitId;
+                order.action = 'B';
+                order.unitType = production;
+                if (state.applyOrder(side, order) && orders) {
+                    orders->push_back(order);
+                }
+            }
+        } else if (name == "Worker") {
+            stepToward(state, side, unitId, fields.toMine, fields, orders, true);
+        } else {
+            // Attack first, as attacking needs speed left, then move and try again
+            bool attacked = attackInRange(state, side, unitId, orders);
+            const Unit* unit = state.findUnit(side, unitId);
+            if (stance == 0) {
+                stepToward(state, side, unitId, fields.toBase[!side], fields, orders);
+            } else if (fields.at(fields.toBase[side], unit->getPositionX(), unit->getPositionY()) > 2) {
+                stepToward(state, side, unitId, fields.toBase[side], fields, orders, true);
+            }
+            if (!attacked) {
+                attackInRange(state, side, unitId, orders);
+            }
+        }
+    }
+
+    state.endTurn(side);
+}
+
+// Estimate the value of a state for side 0, between 0 (lost) and 1 (won)
+double evaluate(const Simulator& state) {
+    if (state.isBaseDestroyed(true)) {
+        return 1.0;
+    }
+    if (state.isBaseDestroyed(false)) {
+        return 0.0;
+    }
+
+    double material[2] = {0.0, 0.0};
+    for (bool side : {false, true}) {
+        material[side] = state.getGold(side);
+        for (const Unit& unit : state.getUnits(side)) {
+            static std::unordered_map<std::string, unsigned short> maxHealth;
+            auto it = maxHealth.find(unit.getName());
+            if (it == maxHealth.end()) {
+                it = maxHealth.emplace(unit.getName(), Unit(side, 0, unit.getName()).getHealth()).first;
+            }
+            double value = unit.getName() == "Base" ? 2000.0 : unit.getCost();
+            material[side] += value * unit.getHealth() / it->second;
+        }
+    }
+
+    return 0.5 + 0.5 * std::tanh((material[0] - material[1]) / 2000.0);
+}
+
+// Node of the search tree. The action of a node was taken by its side.
+struct Node {
+    int parent;
+    int action;
+    bool side;
+    unsigned int visits = 0;
+    double value = 0.0;  // Sum of the results from the perspective of the node's side
+    std::vector<int> children;
+    std::vector<int> untried;
+};
+
+// Monte Carlo tree search with UCT over the abstract actions
+class MCTS {
+private:
+    const Simulator& root;
+    const DistanceFields& fields;
+    std::mt19937 gen;
+    std::vector<Node> nodes;
+    unsigned long iterations = 0;
+
+public:
+    MCTS(const Simulator& root, const DistanceFields& fields, unsigned int seed) : root(root), fields(fields), gen(seed) {
+        // The root stands for the enemy's last move, so side 0 moves first
+        nodes.push_back(createNode(-1, -1, true));
+    }
+
+    unsigned long getIterations() const {
+        return iterations;
+    }
+
+    // Search until the token is cancelled or the iterations run out and return the most visited action
+    int search(const CancellationToken& token, unsigned long maxIterations = std::numeric_limits<unsigned long>::max()) {
+        TraceSpan span("MCTS::search", "bot");
+        while (!token.isCancelled() && iterations < maxIterations) {
+            iterate();
+        }
+
+        int best = 0;
+        for (int child : nodes[0].children) {
+            if (nodes[child].visits > nodes[best].visits || best == 0) {
+                best = child;
+            }
+        }
+        return best == 0 ? 0 : nodes[best].action;
+    }
+
+private:
+    Node createNode(int parent, int action, bool side) {
+        Node node;
+        node.parent = parent;
+        node.action = action;
+        node.side = side;
+        node.untried.resize(actionCount);
+        for (int i = 0; i < actionCount; ++i) {
+            node.untried[i] = i;
+        }
+        return node;
+    }
+
+    bool isTerminal(const Simulator& state) const {
+        return state.isBaseDestroyed(false) || state.isBaseDestroyed(true);
+    }
+
+    int selectChild(int node) const {
+        double logVisits = std::log(static_cast<double>(nodes[node].visits));
+        int best = -1;
+        double bestScore = -1.0;
+        for (int child : nodes[node].children) {
+            const Node& c = nodes[child];
+            double score = c.value / c.visits + explorationConstant * std::sqrt(logVisits / c.visits);
+            if (score > bestScore) {
+                bestScore = score;
+                best = child;
+            }
+        }
+        return best;
+    }
+
+    void iterate() {
+        Simulator state = root;
+        int node = 0;
+
+        // Selection
+        while (nodes[node].untried.empty() && !nodes[node].children.empty() && !isTerminal(state)) {
+            node = selectChild(node);
+            playAction(state, nodes[node].side, nodes[node].action, fields);
+        }
+
+        // Expansion
+        if (!nodes[node].untried.empty() && !isTerminal(state)) {
+            std::vector<int>& untried = nodes[node].untried;
+            size_t pick = std::uniform_int_distribution<size_t>(0, untried.size() - 1)(gen);
+            int action = untried[pick];
+            untried[pick] = untried.back();
+            untried.pop_back();
+
+            bool side = !nodes[node].side;
+            nodes.push_back(createNode(node, action, side));
+            int child = nodes.size() - 1;
+            nodes[node].children.push_back(child);
+            node = child;
+            playAction(state, side, action, fields);
+        }
+
+        // Rollout with random actions for both sides
+        bool side = !nodes[node].side;
+        std::uniform_int_distribution<int> randomAction(0, actionCount - 1);
+        for (int ply = 0; ply < rolloutTurns * 2 && !isTerminal(state); ++ply) {
+            playAction(state, side, randomAction(gen), fields);
+            side = !side;
+        }
+
+        // Backpropagation
+        double result = evaluate(state);
+        for (; node != -1; node = nodes[node].parent) {
+            nodes[node].visits++;
+            nodes[node].value += nodes[node].side ? 1.0 - result : result;
+        }
+        ++iterations;
+    }
+};
+
+void performTurn(std::ifstream& mapFile, std::ifstream& statusFile, std::ofstream& ordersFile, unsigned int playerId, unsigned int timeLimit) {
+    TraceSpan span("performTurn", "bot", "player", playerId + 1);
+
+    // The search is cancelled once its share of the time limit has passed. A limit of 0 means
+    // no limit, and the search stops after a fixed number of iterations instead.
+    auto start = std::chrono::steady_clock::now();
+    CancellationSource source;
+    std::optional<DeadlineTimer> timer;
+    if (timeLimit > 0) {
+        timer.emplace(source, deadlineAfter(timeLimit * searchTimeFraction));
+    }
+
+    // Read the map file and the status file into the Player and Enemy objects in a single pass
+    Player player(0, "Player 1", 0);
+    Player enemy(1, "Player 2", 0);
+    // The search never asks which cells can reach each other, so the topology is not labelled
+    Map map = [&]() {
+        TraceSpan span("loadTurn", "bot");
+        Map parsed(mapFile, Map::Topology::Deferred);
+        readStatus(statusFile, playerId, player, enemy);
+        return parsed;
+    }();
+
+    // With two players, player 0 takes the first turn of every round and the enemy ends it
+    Simulator root(map, player.getPlayerUnits(), enemy.getPlayerUnits(), player.getGold(), enemy.getGold(), playerId == 0);
+    // The distance fields only depend on the map and the bases, so they are mapped from the cache after the first turn
+    DistanceFields fields = buildDistanceFields(root, MapCache(root.getMap()));
+
+    std::random_device rd;
+    MCTS mcts(root, fields, rd());
+    int action = timeLimit > 0 ? mcts.search(source.getToken()) : mcts.search(CancellationToken(), untimedIterations);
+
+    // Turn the best action into orders
+    std::vector<Order> orders;
+    Simulator state = root;
+    playAction(state, false, action, fields, &orders);
+    for (const Order& order : orders) {
+        ordersFile << formatOrder(order) << std::endl;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "MCTS: " << mcts.getIterations() << " iterations in " << elapsed.count() << " s ("
+              << mcts.getIterations() / elapsed.count() << " iterations/s)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 5 || argc > 6) {
+        std::cerr << "Invalid amount of arguments. Usage: ./mcts <map file> <status file> <orders file> <player id> [time limit]" << std::endl;
+        return 1;
+    }
+
+    std::string mapFile = argv[1];
+    std::string statusFile = argv[2];
+    std::string ordersFile = argv[3];
+    // The ID of the player the bot plays, the status file gives the owner ID of every unit
+    unsigned int playerId = std::stoi(argv[4]);
+    unsigned int timeLimit = 5;
+
+    if (playerId >= maxPlayers) {
+        std::cerr << "Invalid player ID: " << argv[4] << std::endl;
+        return 1;
+    }
+    if (argc == 6) {
+        timeLimit = std::stoi(argv[5]);
+    }
+
+    // Every turn of the player is traced on the same lane, whichever process plays it
+    Tracer::get().setProcess(traceBotLane + playerId, "Player " + std::to_string(playerId + 1) + " (" + argv[0] + ")");
+
+    // Open files
+    std::ifstream mapFileStream(mapFile);
+    std::ifstream statusFileStream(statusFile);
+    std::ofstream ordersFileStream(ordersFile);
+
+    if (!mapFileStream || !statusFileStream || !ordersFileStream) {
+        std::cerr << "Failed to open one or more files." << std::endl;
+        return 1;
+    }
+
+    try {
+        // Search until the time limit runs out, or for a fixed number of iterations with a limit of 0,
+        // and write the best orders found
+        performTurn(mapFileStream, statusFileStream, ordersFileStream, playerId, timeLimit);
+
+        std::cout << "MCTS player has finished their turn!" << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+    }
+
+    // Close your input and output files as needed
+    mapFileStream.close();
+    statusFileStream.close();
+    ordersFileStream.close();
+
+    return 0;
+}
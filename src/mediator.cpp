@@ -1,250 +1,559 @@
 #include <iostream>
+#include <algorithm>
 #include <cstdlib>
 #include <filesystem>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <unistd.h>
 #include "player.hpp"
+#include "spatial_index.hpp"
+#include "combat.hpp"
+#include "scheduler.hpp"
+#include "economy.hpp"
+#include "status.hpp"
+#include "status_writer.hpp"
+#include "shared_state.hpp"
+#include "replay.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
 
 namespace fs = std::filesystem;
 
-void initializeStatus(const fs::path& statusFilePath, Player& player1, Player& player2) {
-    // Delete the file if it exists
-    if (fs::exists(statusFilePath)) {
-        fs::remove(statusFilePath);
+unsigned short getHighestID(const std::vector<Player*>& players) {
+    unsigned short highestID = 0;
+    for (Player* player : players) {
+        for (auto& unit : player->getPlayerUnits()) {
+            unsigned short newID = unit.getId();
+            if (newID > highestID) {
+                highestID = newID;
+            }
+        }
     }
+    return highestID;
+}
 
-    // Create a new status file
-    std::ofstream statusFile(statusFilePath);
-
-    // Set the first line to player1's gold
-    statusFile << player1.getGold() << std::endl;
-
-    // Write player1's unit information to the second line
-    const std::vector<Unit>& player1Units = player1.getPlayerUnits();
-    if (!player1Units.empty()) {
-        const Unit& unit = player1Units[0];
-        statusFile << "P B " << unit.getId() << " "
-                   << unit.getPositionX() << " " << unit.getPositionY() << " "
-                   << unit.getHealth() << " 0" << std::endl;
+// Collect the unit lists of every player, to index or stage them
+std::vector<std::vector<Unit>*> getArmies(const std::vector<Player*>& players) {
+    std::vector<std::vector<Unit>*> armies;
+    for (Player* player : players) {
+        armies.push_back(&player->getPlayerUnits());
     }
+    return armies;
+}
 
-    // Write player2's unit information to the third line
-    const std::vector<Unit>& player2Units = player2.getPlayerUnits();
-    if (!player2Units.empty()) {
-        const Unit& unit = player2Units[0];
-        statusFile << "E B " << unit.getId() << " "
-                   << unit.getPositionX() << " " << unit.getPositionY() << " "
-                   << unit.getHealth() << " 0" << std::endl;
+// Apply the events that came due, each to the player owning the unit it concerns
+void applyScheduledEvents(const std::vector<ScheduledEvent>& events, const std::vector<Player*>& players, TurnScheduler& scheduler) {
+    for (const ScheduledEvent& event : events) {
+        Player& player = *players.at(event.owner);
+        Unit* unit = player.findUnitByID(event.unitId);
+        if (event.type == ScheduledEvent::Type::Reset) {
+            // Give the unit its speed and attack back
+            if (unit) {
+                unit->reset();
+            }
+        } else if (event.type == ScheduledEvent::Type::BuildComplete) {
+            // Deploy the finished unit on its base
+            std::optional<Unit> deployed = scheduler.completeBuild(event, unit);
+            if (deployed) {
+                player.addUnitToPlayerUnits(*deployed);
+                std::cout << player.getName() << " deployed unit " << deployed->getId() << std::endl;
+            }
+        }
     }
-
-    // Close the status file
-    statusFile.close();
 }
 
-void switchStatus(std::fstream& statusFile, Player& player) {
-    // Read the file line by line and update the contents
-    std::ostringstream updatedContents;
-    std::string line;
-    bool firstLine = true;
-    while (std::getline(statusFile, line)) {
-        if (!line.empty()) {
-            if (firstLine) {
-                updatedContents << player.getGold() << '\n';
-                firstLine = false;
-            } else {
-                char firstChar = line[0];
-                if (firstChar == 'P')
-                    firstChar = 'E';
-                else if (firstChar == 'E')
-                    firstChar = 'P';
-                line[0] = firstChar;
-                updatedContents << line << '\n';
-            }
-        }
-    }
-    
-    // Move the write position to the beginning of the file and write the updated contents
-    statusFile.clear(); // Clear the end-of-file flag
-    statusFile.seekp(0);
-    statusFile << updatedContents.str();
-    statusFile.flush(); // Flush the changes to the file
-    statusFile.seekg(0); // Move the read position back to the beginning of the file
-}
+// Collect the orders of the turn from the orders ring, or from the orders file if the bot did not commit any
+std::vector<Order> collectOrders(SharedOrderRing& ring, std::ifstream& ordersFile) {
+    TraceSpan span("collectOrders", "mediator");
+    std::vector<Order> orders;
+    if (ring.drain(orders)) {
+        return orders;
+    }
+    orders.clear();
 
-unsigned short getHighestID(Player& player, Player& enemy) {
-    unsigned short highestID = 0;
-    for (auto& unit : player.getPlayerUnits()) {
-        unsigned short newID = unit.getId();
-        if (newID > highestID) {
-            highestID = newID;
+    // The orders file has been rewritten by the player, read it from the start
+    ordersFile.clear();
+    ordersFile.seekg(0);
+    std::string line;
+    Order order;
+    while (std::getline(ordersFile, line)) {
+        // Lines in an invalid order format are skipped
+        if (parseOrder(line, order)) {
+            orders.push_back(order);
         }
     }
-    for (auto& unit : enemy.getPlayerUnits()) {
-        unsigned short newID = unit.getId();
-        if (newID > highestID) {
-            highestID = newID;
+    return orders;
+}
+
+// Apply a single order of a player. Moves are checked against the enemy units in the occupancy
+// index and attacks against the units in the attack index. Invalid orders are reported and skipped.
+void applyOrder(const Order& order, Player& player, const Map& map, TurnScheduler& scheduler, CombatStage& combat,
+                const SpatialIndex& occupancy, const SpatialIndex& index, unsigned short& highestId,
+                std::uint64_t now, std::unordered_map<unsigned short, std::uint32_t>& damageDealt) {
+    try {
+        if (order.action == 'B') {
+            // Build unit action
+            if (unitTypeMap.find(order.unitType) != unitTypeMap.end()) {
+                const std::string& unitType = unitTypeMap.at(order.unitType);
+                if (highestId == std::numeric_limits<unsigned short>::max()) {
+                    throw std::runtime_error("No unit IDs are left.");
+                }
+                Unit newUnit(player.getID(), highestId + 1, unitType);
+                if (newUnit.getCost() > player.getGold()) {
+                    throw std::runtime_error("Not enough gold to build a " + unitType + ".");
+                }
+                scheduler.enqueueBuild(player.getUnitByID(order.unitId), newUnit, now);
+                player.setGold(player.getGold() - newUnit.getCost());
+                ++highestId;
+            }
+        } else if (order.action == 'M') {
+            // Move unit action
+            Unit& unit = player.getUnitByID(order.unitId);
+            unit.moveAction(order.x, order.y, occupancy, map);
+            scheduler.scheduleReset(unit, now);
+        } else if (order.action == 'A') {
+            // Attack unit action
+            Unit& unit = player.getUnitByID(order.unitId);
+            damageDealt[unit.getId()] += combat.addAttack(unit, order.targetId, index);
+            scheduler.scheduleReset(unit, now);
         }
+    } catch (const std::runtime_error& error) {
+        std::cerr << player.getName() << ": rejected order \"" << formatOrder(order) << "\": " << error.what() << std::endl;
     }
-    return highestID;
 }
 
-void analyzeTurn(std::ifstream& ordersFile, std::fstream& statusFile, Player& player, Player& enemy, Map& map) {
-    std::string line;
-    bool skipFirstLine = true; // Flag to skip the first line
+void analyzeTurn(const std::vector<Order>& orders, Player& player, const std::vector<Player*>& players, Map& map,
+                 TurnScheduler& scheduler, std::uint64_t now, unsigned short& highestId,
+                 std::unordered_map<unsigned short, std::uint32_t>& damageDealt) {
+    TraceSpan span("analyzeTurn", "mediator", "player", player.getID() + 1);
+    // Index the units of every player and stage them for combat. Enemy units do not move during
+    // the turn, so the same index checks moves. Attacks are validated as they are read and their
+    // damage is dealt at once after all orders have been applied.
+    std::vector<std::vector<Unit>*> armies = getArmies(players);
+    SpatialIndex index(map.getWidth(), map.getHeight());
+    index.rebuild({armies.begin(), armies.end()});
+    CombatStage combat;
+    combat.load(armies);
 
-    while (std::getline(ordersFile, line)) {
-        if (skipFirstLine) {
-            skipFirstLine = false;
-            continue; // Skip the first line
-        }
+    for (const Order& order : orders) {
+        applyOrder(order, player, map, scheduler, combat, index, index, highestId, now, damageDealt);
+    }
 
-        std::istringstream iss(line);
-        int unitId;
-        std::string action;
+    // Deal the damage of all attacks
+    for (unsigned short killedId : combat.resolve()) {
+        std::cout << player.getName() << " destroyed unit " << killedId << std::endl;
+    }
 
-        if (!(iss >> unitId >> action)) {
-            // Invalid order format, skip the line
-            continue;
-        }
+    // Sweep the destroyed units out of every army
+    for (Player* army : players) {
+        army->removeDestroyedUnits();
+    }
 
-        // Handle different actions
-        if (action == "B") {
-            char unitTypeAbbreviation;
-            if (iss >> unitTypeAbbreviation) {
-                // Build unit action
-                std::string unitType;
-                if (unitTypeMap.find(unitTypeAbbreviation) != unitTypeMap.end()) {
-                    unitType = unitTypeMap.at(unitTypeAbbreviation);
-                    Unit newUnit(player.getID(), getHighestID(player, enemy) + 1, unitType);
-                    player.getPlayerUnits()[0].createUnit(newUnit);
-                    player.addUnitToPlayerUnits(newUnit);
-                }
-            }
-        } else if (action == "M") {
-            unsigned short x, y;
-            if (iss >> x >> y) {
-                // Move unit action
-                player.getUnitByID(unitId).moveAction(x, y, enemy.getPlayerUnits(), map);
-            }
-        } else if (action == "A") {
-            int targetId;
-            if (iss >> targetId) {
-                // Attack unit action
-                player.getUnitByID(unitId).attackAction(targetId, enemy.getPlayerUnits());
+    // Start the next player's turn with the events scheduled for it
+    applyScheduledEvents(scheduler.advance(now + 1), players, scheduler);
+}
+
+// Send back the units that moved onto a cell also held by another player. The snapshot
+// holds the units of each player as they were before the moves, in the same order.
+void bounceContestedMoves(const std::vector<Player*>& players, const std::vector<std::vector<Unit>>& snapshot, const Map& map) {
+    std::unordered_map<unsigned int, OwnerSet> holders;
+    for (Player* player : players) {
+        for (const Unit& unit : player->getPlayerUnits()) {
+            holders[unit.getPositionY() * map.getWidth() + unit.getPositionX()] |= OwnerSet::of(player->getID());
+        }
+    }
+    for (Player* player : players) {
+        std::vector<Unit>& units = player->getPlayerUnits();
+        for (size_t i = 0; i < units.size(); ++i) {
+            const Unit& start = snapshot[player->getID()][i];
+            bool moved = units[i].getPositionX() != start.getPositionX() || units[i].getPositionY() != start.getPositionY();
+            if (moved && holders[units[i].getPositionY() * map.getWidth() + units[i].getPositionX()].hasSeveral()) {
+                std::cerr << player->getName() << ": unit " << units[i].getId() << " bounced off a contested cell" << std::endl;
+                units[i].setPosition(start.getPositionX(), start.getPositionY());
             }
         }
+    }
+}
 
-        // Update status file
-        for (Unit& unit : player.getPlayerUnits()){
-            if (unit.getName() == "Base") {
-                if (unit.getCurrentCreation() != nullptr) {
-                    statusFile << "P " << unit.getInitial() << " " << unit.getId() << " " << unit.getPositionX() << " " << unit.getPositionY() << " " << unit.getHealth() << " " << unit.getCurrentCreation()->getInitial() << std::endl;
-                }
-                else {
-                    statusFile << "P " << unit.getInitial() << " " << unit.getId() << " " << unit.getPositionX() << " " << unit.getPositionY() << " " << unit.getHealth() << " 0" << std::endl;
-                }
-            }
-            else {
-                statusFile << "P " << unit.getInitial() << " " << unit.getId() << " " << unit.getPositionX() << " " << unit.getPositionY() << " " << unit.getHealth() << std::endl;
-            }
+// Resolve the orders all players gave on the same snapshot. Builds are applied first, then
+// moves, then attacks, by player ID within each phase. A move may not enter a cell an enemy
+// unit held in the snapshot, and units of several players that end up on the same cell are
+// sent back to where they started. Attacks are validated after the moves and their damage
+// is dealt at once, so two units attacking each other both strike.
+void analyzeSimultaneousTurn(const std::vector<std::vector<Order>>& orders, const std::vector<Player*>& players, Map& map,
+                             TurnScheduler& scheduler, unsigned int turn, unsigned short& highestId,
+                             std::unordered_map<unsigned short, std::uint32_t>& damageDealt) {
+    TraceSpan span("analyzeSimultaneousTurn", "mediator");
+    std::vector<std::vector<Unit>> snapshot;
+    for (Player* player : players) {
+        snapshot.push_back(player->getPlayerUnits());
+    }
+    std::vector<const std::vector<Unit>*> snapshotArmies;
+    for (const std::vector<Unit>& units : snapshot) {
+        snapshotArmies.push_back(&units);
+    }
+    SpatialIndex occupancy(map.getWidth(), map.getHeight());
+    occupancy.rebuild(snapshotArmies);
+    SpatialIndex index(map.getWidth(), map.getHeight());
+    CombatStage combat;
+    combat.load(getArmies(players));
+
+    for (char phase : {'B', 'M', 'A'}) {
+        if (phase == 'A') {
+            std::vector<std::vector<Unit>*> armies = getArmies(players);
+            index.rebuild({armies.begin(), armies.end()});
         }
-        for (Unit& unit : enemy.getPlayerUnits()){
-            if (unit.getName() == "Base") {
-                if (unit.getCurrentCreation() != nullptr) {
-                    statusFile << "E " << unit.getInitial() << " " << unit.getId() << " " << unit.getPositionX() << " " << unit.getPositionY() << " " << unit.getHealth() << " " << unit.getCurrentCreation()->getInitial() << std::endl;
-                }
-                else {
-                    statusFile << "E " << unit.getInitial() << " " << unit.getId() << " " << unit.getPositionX() << " " << unit.getPositionY() << " " << unit.getHealth() << " 0" << std::endl;
+        for (Player* player : players) {
+            for (const Order& order : orders[player->getID()]) {
+                if (order.action == phase) {
+                    applyOrder(order, *player, map, scheduler, combat, occupancy, index, highestId,
+                               scheduler.turnTime(turn, player->getID()), damageDealt);
                 }
             }
-            else {
-                statusFile << "E " << unit.getInitial() << " " << unit.getId() << " " << unit.getPositionX() << " " << unit.getPositionY() << " " << unit.getHealth() << std::endl;
-            }
+        }
+        if (phase == 'M') {
+            bounceContestedMoves(players, snapshot, map);
+        }
+    }
+
+    for (unsigned short killedId : combat.resolve()) {
+        std::cout << "Unit " << killedId << " destroyed" << std::endl;
+    }
+    for (Player* player : players) {
+        player->removeDestroyedUnits();
+    }
+
+    // Every player starts the next turn with the events scheduled for it
+    applyScheduledEvents(scheduler.advance(scheduler.turnTime(turn + 1, players.size() - 1)), players, scheduler);
+}
+
+// Run a bot, reporting a failed turn
+bool runBot(const std::string& command, const Player& player) {
+    TraceSpan span("runBot", "mediator", "player", player.getID() + 1);
+    int result = system(command.c_str());
+    if (result != 0) {
+        std::cerr << player.getName() << "'s turn failed with exit code: " << result << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Record a row per living unit after a player's turn, with the orders and damage of that turn
+void recordTelemetry(TelemetryWriter& telemetry, std::uint64_t now, const std::vector<Order>& orders,
+                     const std::unordered_map<unsigned short, std::uint32_t>& damageDealt, const std::vector<Player*>& players) {
+    TraceSpan span("recordTelemetry", "mediator");
+    std::unordered_map<unsigned short, std::string> ordered;
+    for (const Order& order : orders) {
+        ordered[order.unitId] += order.action;
+    }
+    TelemetryRow row;
+    row.time = now;
+    for (Player* player : players) {
+        for (const Unit& unit : player->getPlayerUnits()) {
+            row.owner = player->getID();
+            row.unitId = unit.getId();
+            row.type = unit.getName();
+            row.x = unit.getPositionX();
+            row.y = unit.getPositionY();
+            row.health = unit.getHealth();
+            auto damage = damageDealt.find(unit.getId());
+            row.damage = damage != damageDealt.end() ? damage->second : 0;
+            auto unitOrders = ordered.find(unit.getId());
+            row.orders = unitOrders != ordered.end() ? unitOrders->second : "";
+            telemetry.addRow(row);
         }
     }
 }
 
+int main(int argc, char* argv[]) {
+    // The --simultaneous and --bot flags may appear anywhere, the other arguments are positional.
+    // Every --bot adds a player after the two positional bots.
+    std::vector<std::string> args;
+    std::vector<fs::path> extraBots;
+    bool simultaneous = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--simultaneous") {
+            simultaneous = true;
+        } else if (std::string(argv[i]) == "--bot" && i + 1 < argc) {
+            extraBots.emplace_back(argv[++i]);
+        } else {
+            args.emplace_back(argv[i]);
+        }
+    }
+    if (args.size() > 8 || 2 + extraBots.size() > maxPlayers) {
+        std::cerr << "Invalid amount of arguments. Usage: ./Skirmish [--simultaneous] [--bot <bot>]... [map file] [player 1 bot] [player 2 bot] [turns] [time limit] [starting status file] [replay file] [telemetry file]" << std::endl;
+        return 1;
+    }
+
+    // Every process of the match traces under the match ID of the mediator, see trace.hpp
+    setenv(traceMatchVariable, getTraceMatch().c_str(), 0);
+    Tracer::get().setProcess(traceMediatorLane, "Mediator");
 
-int main() {
     // Data files paths
-    const fs::path mapFile = "data/map.txt";
+    const fs::path mapFile = args.size() > 0 ? args[0] : "data/map.txt";
     const fs::path statusFile = "data/status.txt";
-    const fs::path ordersFile = "data/orders.txt";
     // Player AI files
-    const fs::path player1File = "build/defensive";
-    const fs::path player2File = "build/offensive";
-    // Time limit in seconds
-    const unsigned short timeLimit = 1;
+    std::vector<fs::path> botFiles = {args.size() > 1 ? args[1] : "build/defensive", args.size() > 2 ? args[2] : "build/offensive"};
+    botFiles.insert(botFiles.end(), extraBots.begin(), extraBots.end());
+    const unsigned int playerCount = botFiles.size();
+    // Bots playing at the same time cannot share an orders file
+    std::vector<fs::path> ordersFiles;
+    for (unsigned int id = 0; id < playerCount; ++id) {
+        ordersFiles.push_back(simultaneous ? "data/orders_" + std::to_string(id + 1) + ".txt" : "data/orders.txt");
+    }
     // Other
-    const unsigned short numberOfTurnsPerPlayer = 10;
+    const unsigned short numberOfTurnsPerPlayer = args.size() > 3 ? std::stoi(args[3]) : 10;
+    // Time limit in seconds, 0 lets the bots take as long as they need
+    const int timeLimit = args.size() > 4 ? std::stoi(args[4]) : 1;
+    // Starting armies, only the bases on the map when not given or "-"
+    const fs::path startingStatusFile = args.size() > 5 && args[5] != "-" ? args[5] : "";
+    // Replay and per-unit telemetry of the match, not recorded when not given or "-"
+    const fs::path replayFile = args.size() > 6 && args[6] != "-" ? args[6] : "";
+    const fs::path telemetryFile = args.size() > 7 && args[7] != "-" ? args[7] : "";
+
+    // The orders files of simultaneous turns are created on demand
+    if (simultaneous) {
+        for (const fs::path& ordersFile : ordersFiles) {
+            std::ofstream(ordersFile, std::ios::app);
+        }
+    }
 
     // Check file existence
-    if (!fs::exists(mapFile) || !fs::exists(ordersFile) ||
-        !fs::exists(player1File) || !fs::exists(player2File)) {
+    bool missing = !fs::exists(mapFile) || (!startingStatusFile.empty() && !fs::exists(startingStatusFile));
+    for (unsigned int id = 0; id < playerCount; ++id) {
+        missing = missing || !fs::exists(ordersFiles[id]) || !fs::exists(botFiles[id]);
+    }
+    if (missing) {
         std::cerr << "One or more required files do not exist." << std::endl;
         return 1;
     }
 
-    std::string player1Command = player1File.string() + " " + mapFile.string() + " " + statusFile.string() + " " + ordersFile.string();
-    std::string player2Command = player2File.string() + " " + mapFile.string() + " " + statusFile.string() + " " + ordersFile.string();
-
-    // Append the optional time limit argument if provided
-    if (timeLimit > 0) {
-        player1Command += " " + std::to_string(timeLimit);
-        player2Command += " " + std::to_string(timeLimit);
+    // Every bot is told its player ID, the status does not depend on who reads it.
+    // A negative time limit leaves the bots to their own default.
+    std::vector<std::string> commands;
+    for (unsigned int id = 0; id < playerCount; ++id) {
+        commands.push_back(botFiles[id].string() + " " + mapFile.string() + " " + statusFile.string() + " " + ordersFiles[id].string() + " " + std::to_string(id));
+        if (timeLimit >= 0) {
+            commands[id] += " " + std::to_string(timeLimit);
+        }
     }
 
-    // Initialize map and base positions
+    // Initialize map and check it has a base for every player
     Map map(mapFile.string());
-    std::pair<unsigned int, unsigned int>player1Base = map.getBasePosition('1');
-    std::pair<unsigned int, unsigned int>player2Base = map.getBasePosition('2');
+    if (startingStatusFile.empty() && map.getBaseCount() < playerCount) {
+        std::cerr << "The map has bases for " << map.getBaseCount() << " players, but " << playerCount << " bots were given." << std::endl;
+        return 1;
+    }
 
     // Initialize players
-    Player player1(0, "Player 1", 2500);
-    player1.addUnitToPlayerUnits(Unit(player1.getID(), player1.getID(), "Base"));
-    player1.getPlayerUnits()[0].setPosition(player1Base.first, player1Base.second);
-    Player player2(1, "Player 2", 2500);
-    player2.addUnitToPlayerUnits(Unit(player2.getID(), player2.getID(), "Base"));
-    player2.getPlayerUnits()[0].setPosition(player2Base.first, player2Base.second);
-
-    // Initialize status file
-    initializeStatus(statusFile, player1, player2);
-
-    // Orders file stream
-    std::ifstream ordersFileStream(ordersFile);
-    if (!ordersFileStream) {
-        std::cerr << "Failed to open the orders file." << std::endl;
-        return 1;    
-    }
-
-    // Status file stream
-    std::fstream statusFileStream(statusFile, std::ios::in | std::ios::out);
-    if (!statusFileStream) {
-        std::cerr << "Failed to open the status file." << std::endl;
-        return 1;
+    std::vector<Player> playerList;
+    playerList.reserve(playerCount);
+    std::vector<Player*> players;
+    for (unsigned int id = 0; id < playerCount; ++id) {
+        playerList.emplace_back(id, "Player " + std::to_string(id + 1), 2500);
+        players.push_back(&playerList.back());
+    }
+    if (startingStatusFile.empty()) {
+        for (Player* player : players) {
+            std::pair<unsigned int, unsigned int> base = map.getBasePosition(Map::baseMarker(player->getID()));
+            player->addUnitToPlayerUnits(Unit(player->getID(), player->getID(), "Base"));
+            player->getPlayerUnits()[0].setPosition(base.first, base.second);
+        }
+    } else {
+        // A single gold value on the first line is given to every player
+        std::ifstream startingStatus(startingStatusFile);
+        readStatus(startingStatus, players);
+    }
+
+    // Production and unit resets are driven by the scheduler
+    TurnScheduler scheduler(5, playerCount);
+    Economy economy(map);
+    // Units are numbered by a counter kept for the whole match, so the ID of a destroyed unit is never given again
+    unsigned short highestId = getHighestID(players);
+
+    // Status snapshots are serialized in memory and written to disk in the background
+    StatusWriter statusWriter(statusFile);
+    serializeStatus(statusWriter.getBackBuffer(), players, scheduler);
+    statusWriter.publish();
+
+    // Orders file streams
+    std::vector<std::ifstream> ordersFileStreams;
+    for (const fs::path& ordersFile : ordersFiles) {
+        ordersFileStreams.emplace_back(ordersFile);
+        if (!ordersFileStreams.back()) {
+            std::cerr << "Failed to open the orders file." << std::endl;
+            return 1;
+        }
+    }
+
+    // The bots find the game state and their orders ring in shared memory through the environment.
+    // Every player has its own ring, named in the environment of its command.
+    const std::string segmentSuffix = std::to_string(getpid());
+    SharedStatePublisher sharedState("/skirmish_state_" + segmentSuffix, map);
+    std::vector<SharedOrderRing> orderRings;
+    orderRings.reserve(playerCount);
+    for (unsigned int id = 0; id < playerCount; ++id) {
+        orderRings.push_back(SharedOrderRing::create("/skirmish_orders_" + segmentSuffix + "_" + std::to_string(id + 1)));
+        commands[id] = std::string(sharedOrdersVariable) + "=" + orderRings[id].getName() + " " + commands[id];
+    }
+    setenv(sharedStateVariable, sharedState.getName().c_str(), 1);
+    auto currentBuild = [&scheduler](const Unit& base) {
+        const Unit* creation = scheduler.getCurrentBuild(base.getId());
+        return creation ? creation->getInitial() : '0';
+    };
+
+    // A player's turn starts once its status is in shared memory. The status file is still being
+    // written meanwhile, and is only waited for right before a bot is launched, since a bot that
+    // cannot open the shared state reads the file instead.
+    auto startTurn = [&](OwnerId playerId, std::uint64_t now) {
+        TraceSpan span("startTurn", "mediator", "player", playerId + 1);
+        sharedState.publish(players, playerId, now, currentBuild);
+        for (SharedOrderRing& orderRing : orderRings) {
+            orderRing.beginTurn(now);
+        }
+    };
+    auto waitForStatusFile = [&]() {
+        TraceSpan span("waitForStatusFile", "mediator");
+        statusWriter.flush();
+    };
+
+    // No part of the match is seeded, so the replay records no seeds
+    std::unique_ptr<ReplayWriter> replay;
+    if (!replayFile.empty()) {
+        replay = std::make_unique<ReplayWriter>(replayFile.string(), map, std::vector<std::uint64_t>());
+    }
+    std::unique_ptr<TelemetryWriter> telemetry;
+    if (!telemetryFile.empty()) {
+        telemetry = std::make_unique<TelemetryWriter>(telemetryFile.string());
     }
+    std::unordered_map<unsigned short, std::uint32_t> damageDealt;
+
+    // Reported while the snapshot of the turn is being written
+    auto reportIncome = [&]() {
+        std::cout << "Income:";
+        for (Player* player : players) {
+            std::cout << (player->getID() > 0 ? ", " : " ") << player->getName() << " " << economy.getIncome(player->getID());
+        }
+        std::cout << std::endl;
+    };
 
     std::cout << "==== SIMULATION START ====" << std::endl;
     for (int turn = 0; turn < numberOfTurnsPerPlayer; turn++) {
         std::cout << "=== Turn " << (turn + 1) << " ===" << std::endl;
+        TraceSpan turnSpan("turn", "mediator", "turn", turn + 1);
 
-        // Player 1's turn
-        int player1Result = system(player1Command.c_str());
-        if (player1Result != 0) {
-            std::cerr << "Player 1's turn failed with exit code: " << player1Result << std::endl;
-            return 1;
+        if (simultaneous) {
+            // Every bot is given the same snapshot and all of them think at the same time
+            startTurn(0, scheduler.turnTime(turn, 0));
+            waitForStatusFile();
+            std::vector<char> succeeded(playerCount, false);
+            std::vector<std::thread> threads;
+            for (unsigned int id = 1; id < playerCount; ++id) {
+                threads.emplace_back([&, id]() { succeeded[id] = runBot(commands[id], *players[id]); });
+            }
+            succeeded[0] = runBot(commands[0], *players[0]);
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            if (std::find(succeeded.begin(), succeeded.end(), false) != succeeded.end()) {
+                return 1;
+            }
+            std::vector<std::vector<Order>> orders;
+            for (unsigned int id = 0; id < playerCount; ++id) {
+                orders.push_back(collectOrders(orderRings[id], ordersFileStreams[id]));
+            }
+            damageDealt.clear();
+            analyzeSimultaneousTurn(orders, players, map, scheduler, turn, highestId, damageDealt);
+            {
+                TraceSpan span("economy", "mediator");
+                economy.step(players);
+            }
+            {
+                TraceSpan span("serializeStatus", "mediator");
+                serializeStatus(statusWriter.getBackBuffer(), players, scheduler);
+                statusWriter.publish();
+            }
+
+            // Every order set leads to the same state. The status file is written meanwhile.
+            if (replay) {
+                TraceSpan span("replay", "mediator");
+                for (Player* player : players) {
+                    replay->addTurn(scheduler.turnTime(turn, player->getID()), player->getID(), orders[player->getID()], players);
+                }
+            }
+            if (telemetry) {
+                std::vector<Order> allOrders;
+                for (const std::vector<Order>& playerOrders : orders) {
+                    allOrders.insert(allOrders.end(), playerOrders.begin(), playerOrders.end());
+                }
+                recordTelemetry(*telemetry, scheduler.turnTime(turn, playerCount - 1), allOrders, damageDealt, players);
+            }
+            reportIncome();
+            continue;
         }
-        analyzeTurn(ordersFileStream, statusFileStream, player1, player2, map);
-        switchStatus(statusFileStream, player2);
 
-        // Player 2's turn
-        int player2Result = system(player2Command.c_str());
-        if (player2Result != 0) {
-            std::cerr << "Player 2's turn failed with exit code: " << player2Result << std::endl;
-            return 1;
+        for (Player* player : players) {
+            TraceSpan playerSpan("playerTurn", "mediator", "player", player->getID() + 1);
+            std::uint64_t now = scheduler.turnTime(turn, player->getID());
+            startTurn(player->getID(), now);
+            waitForStatusFile();
+            if (!runBot(commands[player->getID()], *player)) {
+                return 1;
+            }
+            std::vector<Order> orders = collectOrders(orderRings[player->getID()], ordersFileStreams[player->getID()]);
+            damageDealt.clear();
+            analyzeTurn(orders, *player, players, map, scheduler, now, highestId, damageDealt);
+
+            // Workers on mines earn gold at the end of every turn
+            if (player == players.back()) {
+                TraceSpan span("economy", "mediator");
+                economy.step(players);
+            }
+            {
+                TraceSpan span("serializeStatus", "mediator", "player", player->getID() + 1);
+                serializeStatus(statusWriter.getBackBuffer(), players, scheduler);
+                statusWriter.publish();
+            }
+
+            // Recorded while the status file is being written
+            if (replay) {
+                TraceSpan span("replay", "mediator");
+                replay->addTurn(now, player->getID(), orders, players);
+            }
+            if (telemetry) {
+                recordTelemetry(*telemetry, now, orders, damageDealt, players);
+            }
+            if (player == players.back()) {
+                reportIncome();
+            }
         }
-        analyzeTurn(ordersFileStream, statusFileStream, player2, player2, map);
-        switchStatus(statusFileStream, player1);
+    }
+    statusWriter.flush();
+    if (replay) {
+        replay->close();
+    }
+    if (telemetry) {
+        telemetry->close();
     }
     std::cout << "==== SIMULATION FINISHED ====" << std::endl;
 
+    // The bots have written their traces on exit, merge them with the mediator's into one timeline
+    if (Tracer::get().isEnabled()) {
+        Tracer::get().flush();
+        try {
+            std::cout << "Trace written to " << mergeTraces(getTraceDirectory(), getTraceMatch()) << std::endl;
+        } catch (const std::runtime_error& error) {
+            std::cerr << error.what() << std::endl;
+        }
+    }
+
+    // Report how many destroyed units have been swept, to confirm the unit lists track the living armies
+    for (Player* player : players) {
+        const Player::CompactionStats& stats = player->getCompactionStats();
+        std::cout << player->getName() << ": " << player->getPlayerUnits().size() << " units, " << stats.removedUnits
+                  << " removed in " << stats.sweeps << " sweeps, peak " << stats.peakUnits << " units" << std::endl;
+    }
+
     return 0;
 }
@@ -0,0 +1,293 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <map>
+#include "map.hpp"
+#include "unit.hpp"
+#include "spatial_index.hpp"
+#include "combat.hpp"
+#include "cpu.hpp"
+#include <random>
+
+// Results are written here so that the compiler cannot drop the measured calls
+volatile unsigned long long sink = 0;
+
+struct Summary {
+    std::string name;
+    double medianNs;        // Median time of one operation
+    double p99Ns;           // 99th percentile time of one operation
+    double opsPerSecond;    // Throughput at the median
+};
+
+// Time one operation in batches: calibrate the batch size, warm up, then take the samples
+Summary measure(const std::string& name, const std::function<void()>& operation, int samples, int warmUp) {
+    using Clock = std::chrono::steady_clock;
+    auto timeBatch = [&](size_t batchSize) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < batchSize; ++i) {
+            operation();
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    };
+
+    // Grow the batch until it lasts long enough for the clock to resolve it
+    size_t batchSize = 1;
+    while (batchSize < (size_t(1) << 24) && timeBatch(batchSize) < 20000.0) {
+        batchSize *= 2;
+    }
+
+    for (int i = 0; i < warmUp; ++i) {
+        timeBatch(batchSize);
+    }
+
+    std::vector<double> perOperation(samples);
+    for (int i = 0; i < samples; ++i) {
+        perOperation[i] = timeBatch(batchSize) / batchSize;
+    }
+    std::sort(perOperation.begin(), perOperation.end());
+
+    double median = perOperation[perOperation.size() / 2];
+    double p99 = perOperation[std::min(perOperation.size() - 1, perOperation.size() * 99 / 100)];
+    return {name, median, p99, 1e9 / median};
+}
+
+// Read the median times of a previous run, one "name nanoseconds" pair per line
+std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        double medianNs;
+        if (fields >> name >> medianNs) {
+            baseline[name] = medianNs;
+        }
+    }
+    return baseline;
+}
+
+void writeBaseline(const std::string& path, const std::vector<Summary>& results) {
+    std::ofstream file(path);
+    file << "# Median nanoseconds per operation, written by micro_bench --update" << std::endl;
+    for (const Summary& result : results) {
+        file << result.name << " " << result.medianNs << std::endl;
+    }
+}
+
+Map buildMap(unsigned int size) {
+    std::stringstream stream;
+    for (unsigned int y = 0; y < size; ++y) {
+        std::string row(size, '0');
+        if (y % 8 == 4) {
+            row[size / 2] = '9';
+        }
+        if (y == 1) {
+            row[1] = '1';
+        }
+        if (y == size - 2) {
+            row[size - 2] = '2';
+        }
+        stream << row << '\n';
+    }
+    return Map(stream);
+}
+
+// Resolve the same attacks with the portable damage kernel and, when the CPU supports it, the
+// AVX2 one, and check that both leave the same health and destroy the same units
+bool combatKernelsMatch() {
+    const std::vector<std::string> fighters = {"Worker", "Swordsman", "Archer", "Knight", "Pikeman", "Catapult", "Ram"};
+    const unsigned short side = 20;
+    std::vector<std::string> outcomes;
+    bool forced = portableKernels();
+    for (bool portable : {true, false}) {
+        if (!portable && !cpuHasAVX2()) {
+            break;
+        }
+        portableKernels() = portable;
+
+        // A block of wounded units of alternating owners, every unit attacking a random neighbour
+        std::mt19937 gen(7);
+        std::vector<Unit> armies[2];
+        for (unsigned short y = 0; y < side; ++y) {
+            for (unsigned short x = 0; x < side; ++x) {
+                std::vector<Unit>& army = armies[(x + y) % 2];
+                army.emplace_back((x + y) % 2, y * side + x, fighters[gen() % fighters.size()]);
+                army.back().setPosition(x, y);
+                army.back().takeDamage(gen() % army.back().getHealth());
+            }
+        }
+        SpatialIndex index(side, side);
+        index.rebuild({&armies[0], &armies[1]});
+        CombatStage combat;
+        combat.load({&armies[0], &armies[1]});
+        for (std::vector<Unit>& army : armies) {
+            for (Unit& unit : army) {
+                int direction = gen() % 4;
+                int x = unit.getPositionX() + (direction == 0) - (direction == 1);
+                int y = unit.getPositionY() + (direction == 2) - (direction == 3);
+                if (x < 0 || y < 0 || x >= side || y >= side) {
+                    continue;
+                }
+                try {
+                    combat.addAttack(unit, y * side + x, index);
+                } catch (const std::runtime_error&) {
+                    // Out of range for this unit type
+                }
+            }
+        }
+
+        std::string outcome;
+        for (unsigned short killedId : combat.resolve()) {
+            outcome += "k" + std::to_string(killedId);
+        }
+        for (const std::vector<Unit>& army : armies) {
+            for (const Unit& unit : army) {
+                outcome += " " + std::to_string(unit.getHealth());
+            }
+        }
+        outcomes.push_back(outcome);
+    }
+    portableKernels() = forced;
+    return std::all_of(outcomes.begin(), outcomes.end(), [&](const std::string& outcome) { return outcome == outcomes[0]; });
+}
+
+int main(int argc, char* argv[]) {
+    std::string baselinePath = "data/micro_bench_baseline.txt";
+    double threshold = 25.0;
+    bool update = false;
+    int samples = 200;
+
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--update") {
+            update = true;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() > 3) {
+        std::cerr << "Invalid amount of arguments. Usage: ./micro_bench [baseline file] [threshold percent] [samples] [--update]" << std::endl;
+        return 1;
+    }
+    if (positional.size() > 0) {
+        baselinePath = positional[0];
+    }
+    if (positional.size() > 1) {
+        threshold = std::stod(positional[1]);
+    }
+    if (positional.size() > 2) {
+        samples = std::max(1, std::stoi(positional[2]));
+    }
+
+    const Map map = buildMap(128);
+    const std::vector<std::string> unitTypes = {"Base", "Worker", "Swordsman", "Archer", "Knight", "Pikeman", "Catapult", "Ram"};
+
+    // Every attacker and target pair, in both directions
+    std::vector<Unit> roster;
+    for (size_t i = 0; i < unitTypes.size(); ++i) {
+        roster.emplace_back(i % 2, static_cast<unsigned short>(i), unitTypes[i]);
+    }
+
+    // An archer next to an enemy knight among a few more units of both players
+    std::vector<Unit> army;
+    for (unsigned short i = 0; i < 16; ++i) {
+        army.emplace_back(i % 2, i, unitTypes[1 + i % (unitTypes.size() - 1)]);
+        army.back().setPosition(20 + i, 30 + i % 4);
+    }
+    Unit archer(0, 100, "Archer");
+    archer.setPosition(10, 10);
+    Unit knight(1, 101, "Knight");
+    knight.setPosition(12, 10);
+    army.push_back(knight);
+    SpatialIndex index(map.getWidth(), map.getHeight());
+    index.rebuild({&army});
+
+    Unit walker(0, 200, "Knight");
+    walker.setPosition(40, 40);
+
+    size_t step = 0;
+    std::vector<Summary> results;
+    results.push_back(measure("Unit::calculateDamage", [&]() {
+        ++step;
+        sink += roster[step & 7].calculateDamage(roster[(step >> 3) & 7]);
+    }, samples, 20));
+    results.push_back(measure("Unit::calculateDistance", [&]() {
+        ++step;
+        sink += archer.calculateDistance(step & 127, (step >> 7) & 127);
+    }, samples, 20));
+    results.push_back(measure("Unit::moveAction", [&]() {
+        // Walk back and forth between two cells, restoring the speed each time
+        ++step;
+        walker.reset();
+        walker.moveAction(40 + (step & 1), 40, army, map);
+        sink += walker.getPositionX();
+    }, samples, 20));
+    results.push_back(measure("Unit::attackAction", [&]() {
+        archer.reset();
+        archer.attackAction(101, army);
+        sink += army.back().getHealth();
+    }, samples, 20));
+    results.push_back(measure("Unit::attackAction(SpatialIndex)", [&]() {
+        archer.reset();
+        archer.attackAction(101, index);
+        sink += army.back().getHealth();
+    }, samples, 20));
+    results.push_back(measure("Map::getCell", [&]() {
+        ++step;
+        sink += map.getCell(step & 127, (step >> 7) & 127);
+    }, samples, 20));
+    results.push_back(measure("Map::getBasePosition", [&]() {
+        sink += map.getBasePosition('2').first;
+    }, samples, 5));
+
+    bool kernels = combatKernelsMatch();
+    std::cout << "Combat damage kernels (AVX2: " << (cpuHasAVX2() ? "yes" : "no") << "): " << (kernels ? "match" : "DIFFER") << std::endl;
+    if (!kernels) {
+        return 1;
+    }
+
+    std::map<std::string, double> baseline = update ? std::map<std::string, double>() : readBaseline(baselinePath);
+    bool regressed = false;
+    std::cout << "Primitive                         median ns     p99 ns       ops/s   baseline" << std::endl;
+    for (const Summary& result : results) {
+        std::cout << result.name << std::string(result.name.size() < 32 ? 32 - result.name.size() : 1, ' ');
+        std::cout.precision(2);
+        std::cout << std::fixed << std::setw(11) << result.medianNs << std::setw(11) << result.p99Ns << std::setw(12);
+        std::cout.precision(0);
+        std::cout << result.opsPerSecond;
+
+        auto it = baseline.find(result.name);
+        if (it == baseline.end()) {
+            std::cout << "          -" << std::endl;
+            continue;
+        }
+        double change = (result.medianNs / it->second - 1.0) * 100.0;
+        std::cout.precision(1);
+        std::cout << std::showpos << std::setw(10) << change << "%" << std::noshowpos;
+        if (change > threshold) {
+            std::cout << "  REGRESSION";
+            regressed = true;
+        }
+        std::cout << std::endl;
+    }
+
+    if (update) {
+        writeBaseline(baselinePath, results);
+        std::cout << "Baseline written to " << baselinePath << std::endl;
+    } else if (baseline.empty()) {
+        std::cout << "No baseline found in " << baselinePath << ", run with --update to record one." << std::endl;
+    } else if (regressed) {
+        std::cerr << "One or more primitives are more than " << threshold << "% slower than the baseline." << std::endl;
+        return 1;
+    }
+    return 0;
+}
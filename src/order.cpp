@@ -0,0 +1,39 @@
+#include "order.hpp"
+#include <sstream>
+
+std::string formatOrder(const Order& order) {
+    std::string line = std::to_string(order.unitId) + " " + order.action + " ";
+    switch (order.action) {
+        case 'B':
+            line += order.unitType;
+            break;
+        case 'M':
+            line += std::to_string(order.x) + " " + std::to_string(order.y);
+            break;
+        case 'A':
+            line += std::to_string(order.targetId);
+            break;
+    }
+    return line;
+}
+
+bool parseOrder(const std::string& line, Order& order) {
+    std::istringstream iss(line);
+    std::string action;
+    if (!(iss >> order.unitId >> action) || action.size() != 1) {
+        return false;
+    }
+    order.action = action[0];
+
+    // Read the arguments of the action
+    switch (order.action) {
+        case 'B':
+            return static_cast<bool>(iss >> order.unitType);
+        case 'M':
+            return static_cast<bool>(iss >> order.x >> order.y);
+        case 'A':
+            return static_cast<bool>(iss >> order.targetId);
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,416 @@
+#include "pathfinding.hpp"
+#include "cpu.hpp"
+#include "trace.hpp"
+#include <queue>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PATHFINDING_HAS_AVX2_KERNEL 1
+#endif
+
+// Function to perform pathfinding using Breadth-First Search (BFS)
+std::vector<std::vector<int>> performBFS(const Map& map, unsigned short startX, unsigned short startY) {
+    TraceSpan span("performBFS", "pathfinding");
+    unsigned int width = map.getWidth();
+    unsigned int height = map.getHeight();
+    std::vector<std::vector<int>> distance(height, std::vector<int>(width, -1));  // Initialize distances to -1 (unreachable)
+    std::queue<std::pair<unsigned short, unsigned short>> q;
+
+    // Starting position has distance 0
+    distance[startY][startX] = 0;
+    q.push({startX, startY});
+
+    while (!q.empty()) {
+        auto [x, y] = q.front();
+        q.pop();
+
+        // Check neighboring cells (up, down, left, right)
+        std::vector<std::pair<int, int>> neighbors = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        for (const auto& [dx, dy] : neighbors) {
+            unsigned short nx = x + dx;
+            unsigned short ny = y + dy;
+
+            // Check if the neighboring cell is within the map boundaries and reachable
+            if (nx < width && ny < height && map.getCell(nx, ny) != '9') {
+                if (distance[ny][nx] == -1) {
+                    // Update the distance and enqueue the neighboring cell
+                    distance[ny][nx] = distance[y][x] + 1;
+                    q.push({nx, ny});
+                }
+            }
+        }
+    }
+
+    return distance;
+}
+
+namespace {
+
+// Expands the frontier by one step for the words [low, high] of row y and stores the newly
+// reached cells. Returns true if at least one new cell has been reached.
+bool expandRowPortable(const BitGrid& frontier, const BitGrid& passable, BitGrid& visited, BitGrid& next,
+                       unsigned int y, unsigned int low, unsigned int high) {
+    const std::uint64_t* f = frontier.row(y);
+    const std::uint64_t* up = frontier.row(y - 1);
+    const std::uint64_t* down = frontier.row(y + 1);
+    const std::uint64_t* p = passable.row(y);
+    std::uint64_t* v = visited.row(y);
+    std::uint64_t* n = next.row(y);
+
+    std::uint64_t any = 0;
+    for (unsigned int w = low; w <= high; ++w) {
+        std::uint64_t left = (f[w] << 1) | (f[w - 1] >> 63);
+        std::uint64_t right = (f[w] >> 1) | (f[w + 1] << 63);
+        std::uint64_t reached = (left | right | up[w] | down[w]) & p[w] & ~v[w];
+        v[w] |= reached;
+        n[w] = reached;
+        any |= reached;
+    }
+    return any != 0;
+}
+
+#ifdef PATHFINDING_HAS_AVX2_KERNEL
+// Same as expandRowPortable, four words at a time. The range must start at 4k + 1 and end at 4k + 4.
+__attribute__((target("avx2")))
+bool expandRowAVX2(const BitGrid& frontier, const BitGrid& passable, BitGrid& visited, BitGrid& next,
+                   unsigned int y, unsigned int low, unsigned int high) {
+    const std::uint64_t* f = frontier.row(y);
+    const std::uint64_t* up = frontier.row(y - 1);
+    const std::uint64_t* down = frontier.row(y + 1);
+    const std::uint64_t* p = passable.row(y);
+    std::uint64_t* v = visited.row(y);
+    std::uint64_t* n = next.row(y);
+
+    __m256i any = _mm256_setzero_si256();
+    for (unsigned int w = low; w <= high; w += 4) {
+        __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(f + w));
+        __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(f + w - 1));
+        __m256i following = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(f + w + 1));
+        __m256i left = _mm256_or_si256(_mm256_slli_epi64(cur, 1), _mm256_srli_epi64(prev, 63));
+        __m256i right = _mm256_or_si256(_mm256_srli_epi64(cur, 1), _mm256_slli_epi64(following, 63));
+        __m256i vertical = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + w)),
+                                           _mm256_loadu_si256(reinterpret_cast<const __m256i*>(down + w)));
+        __m256i candidates = _mm256_or_si256(_mm256_or_si256(left, right), vertical);
+        __m256i seen = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + w));
+        __m256i open = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + w));
+        __m256i reached = _mm256_andnot_si256(seen, _mm256_and_si256(candidates, open));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(v + w), _mm256_or_si256(seen, reached));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(n + w), reached);
+        any = _mm256_or_si256(any, reached);
+    }
+    return !_mm256_testz_si256(any, any);
+}
+#endif
+
+// Words [low, high] of a row that hold frontier cells
+struct RowSpan {
+    unsigned int y;
+    unsigned int low;
+    unsigned int high;
+};
+
+// The number of frontier cells from which a search first expands whole words
+constexpr size_t minWideFrontier = 64;
+// A level that expands more than this many words per reached cell goes back to the queue
+constexpr size_t sparseWordsPerCell = 2;
+
+}  // namespace
+
+BitBFS::BitBFS(const Map& map)
+    : map(map), passable(map.getPassableBits()), visited(map.getWidth(), map.getHeight()),
+      frontier(map.getWidth(), map.getHeight()), next(map.getWidth(), map.getHeight()),
+      distance(static_cast<size_t>(map.getWidth()) * map.getHeight(), -1) {
+}
+
+const Map& BitBFS::getMap() const {
+    return map;
+}
+
+void BitBFS::search(unsigned short startX, unsigned short startY) {
+    TraceSpan span("BitBFS::search", "pathfinding");
+    run(startX, startY, -1, nullptr);
+}
+
+void BitBFS::searchUntil(unsigned short startX, unsigned short startY, unsigned short goalX, unsigned short goalY) {
+    TraceSpan span("BitBFS::searchUntil", "pathfinding");
+    run(startX, startY, static_cast<long>(goalY) * map.getWidth() + goalX, nullptr);
+}
+
+void BitBFS::searchUntil(unsigned short startX, unsigned short startY, const BitGrid& goals) {
+    TraceSpan span("BitBFS::searchUntil", "pathfinding");
+    run(startX, startY, -1, &goals);
+}
+
+// Function to perform pathfinding using a hybrid of a queue-based and a bit-parallel BFS
+void BitBFS::run(unsigned short startX, unsigned short startY, long goal, const BitGrid* goals) {
+    unsigned int width = map.getWidth();
+    unsigned int height = map.getHeight();
+
+    // Only the visited bits are reset, distances are only read for visited cells
+    std::fill(visited.bits.begin(), visited.bits.end(), 0);
+
+    // Starting position has distance 0
+    std::uint32_t start = static_cast<std::uint32_t>(startY) * width + startX;
+    distance[start] = 0;
+    visited.set(startX, startY);
+    if (static_cast<long>(start) == goal || (goals && goals->test(startX, startY))) {
+        return;
+    }
+
+    bool (*expandRow)(const BitGrid&, const BitGrid&, BitGrid&, BitGrid&, unsigned int, unsigned int, unsigned int) = expandRowPortable;
+#ifdef PATHFINDING_HAS_AVX2_KERNEL
+    if (useAVX2()) {
+        expandRow = expandRowAVX2;
+    }
+#endif
+
+    const unsigned int noSpan = ~0u;
+    std::vector<unsigned int> candidateLow;
+    std::vector<unsigned int> candidateHigh;
+    std::vector<unsigned int> candidateRows;
+    std::vector<RowSpan> active;
+    std::vector<RowSpan> reachedRows;
+    size_t wideFrontier = minWideFrontier;
+    bool reachedGoal = false;
+    int level = 0;
+
+    cells.assign(1, start);
+    while (!cells.empty() && !reachedGoal) {
+        // Expand a narrow frontier cell by cell
+        while (!cells.empty() && cells.size() < wideFrontier && !reachedGoal) {
+            ++level;
+            nextCells.clear();
+            for (std::uint32_t index : cells) {
+                unsigned int x = index % width;
+                unsigned int y = index / width;
+                auto visit = [&](unsigned int nx, unsigned int ny) {
+                    if (passable.test(nx, ny) && !visited.test(nx, ny)) {
+                        std::uint32_t reached = ny * width + nx;
+                        visited.set(nx, ny);
+                        distance[reached] = level;
+                        nextCells.push_back(reached);
+                        reachedGoal |= static_cast<long>(reached) == goal || (goals && goals->test(nx, ny));
+                    }
+                };
+                if (x > 0) {
+                    visit(x - 1, y);
+                }
+                if (x + 1 < width) {
+                    visit(x + 1, y);
+                }
+                if (y > 0) {
+                    visit(x, y - 1);
+                }
+                if (y + 1 < height) {
+                    visit(x, y + 1);
+                }
+            }
+            cells.swap(nextCells);
+        }
+        if (cells.empty() || reachedGoal) {
+            break;
+        }
+
+        // The frontier has grown wide, move it into the bit grid
+        if (candidateLow.empty()) {
+            candidateLow.assign(height, noSpan);
+            candidateHigh.assign(height, 0);
+        }
+        for (std::uint32_t index : cells) {
+            unsigned int y = index / width;
+            unsigned int word = 1 + index % width / 64;
+            frontier.set(index % width, y);
+            if (candidateLow[y] == noSpan) {
+                candidateRows.push_back(y);
+            }
+            candidateLow[y] = std::min(candidateLow[y], word);
+            candidateHigh[y] = std::max(candidateHigh[y], word);
+        }
+        active.clear();
+        for (unsigned int y : candidateRows) {
+            active.push_back({y, candidateLow[y], candidateHigh[y]});
+            candidateLow[y] = noSpan;
+            candidateHigh[y] = 0;
+        }
+        candidateRows.clear();
+        cells.clear();
+
+        // Only the rows and words next to the current frontier are expanded. Words are
+        // processed in aligned groups of four to suit the vector kernel.
+        while (!active.empty()) {
+            ++level;
+
+            // Collect the words that may receive new cells from the frontier
+            for (const RowSpan& span : active) {
+                unsigned int low = (std::max(span.low, 2u) - 2) / 4 * 4 + 1;
+                unsigned int high = std::min(span.high / 4 * 4 + 4, frontier.words);
+                for (unsigned int y = span.y > 0 ? span.y - 1 : 0; y <= std::min(span.y + 1, height - 1); ++y) {
+                    if (candidateLow[y] == noSpan) {
+                        candidateRows.push_back(y);
+                    }
+                    candidateLow[y] = std::min(candidateLow[y], low);
+                    candidateHigh[y] = std::max(candidateHigh[y], high);
+                }
+            }
+
+            reachedRows.clear();
+            size_t expandedWords = 0;
+            size_t reachedCount = 0;
+            for (unsigned int y : candidateRows) {
+                unsigned int low = candidateLow[y];
+                unsigned int high = candidateHigh[y];
+                candidateLow[y] = noSpan;
+                candidateHigh[y] = 0;
+                expandedWords += high - low + 1;
+
+                if (!expandRow(frontier, passable, visited, next, y, low, high)) {
+                    continue;
+                }
+
+                // Assign the current level to every newly reached cell of the row
+                RowSpan reached = {y, noSpan, 0};
+                const std::uint64_t* row = next.row(y);
+                const std::uint64_t* goalRow = goals ? goals->row(y) : nullptr;
+                int* distanceRow = distance.data() + static_cast<size_t>(y) * width;
+                for (unsigned int w = low; w <= high; ++w) {
+                    std::uint64_t bits = row[w];
+                    if (!bits) {
+                        continue;
+                    }
+                    reached.low = std::min(reached.low, w);
+                    reached.high = w;
+                    reachedCount += __builtin_popcountll(bits);
+                    reachedGoal |= goalRow && (bits & goalRow[w]);
+                    while (bits) {
+                        unsigned int x = (w - 1) * 64 + __builtin_ctzll(bits);
+                        distanceRow[x] = level;
+                        bits &= bits - 1;
+                    }
+                }
+                reachedRows.push_back(reached);
+            }
+            candidateRows.clear();
+            reachedGoal |= goal >= 0 && visited.test(goal % width, goal / width);
+
+            // Clear the old frontier so it can hold the next level
+            for (const RowSpan& span : active) {
+                std::uint64_t* row = frontier.row(span.y);
+                std::fill(row + span.low, row + span.high + 1, 0);
+            }
+            std::swap(frontier, next);
+            active.swap(reachedRows);
+
+            // Hand a frontier that has thinned out back to the queue, leaving the bit grid
+            // clear. A frontier that keeps thinning out must grow wider to come back.
+            if (reachedGoal || reachedCount * sparseWordsPerCell < expandedWords) {
+                for (const RowSpan& span : active) {
+                    std::uint64_t* row = frontier.row(span.y);
+                    for (unsigned int w = span.low; w <= span.high; ++w) {
+                        for (std::uint64_t bits = row[w]; bits; bits &= bits - 1) {
+                            cells.push_back(span.y * width + (w - 1) * 64 + __builtin_ctzll(bits));
+                        }
+                        row[w] = 0;
+                    }
+                }
+                active.clear();
+                wideFrontier *= 2;
+            }
+        }
+    }
+}
+
+std::vector<std::vector<int>> performBitBFS(const Map& map, unsigned short startX, unsigned short startY) {
+    BitBFS bfs(map);
+    bfs.search(startX, startY);
+    std::vector<std::vector<int>> distance(map.getHeight(), std::vector<int>(map.getWidth()));
+    for (unsigned int y = 0; y < map.getHeight(); ++y) {
+        for (unsigned int x = 0; x < map.getWidth(); ++x) {
+            distance[y][x] = bfs.getDistance(x, y);
+        }
+    }
+    return distance;
+}
+
+// Function to find the nearest object using pathfinding
+std::optional<std::pair<unsigned short, unsigned short>> findSpecifiedObject(const Map& map, unsigned short startX, unsigned short startY,
+                                                                             char object) {
+    BitBFS bfs(map);
+    return findSpecifiedObject(bfs, startX, startY, object);
+}
+
+std::optional<std::pair<unsigned short, unsigned short>> findSpecifiedObject(BitBFS& bfs, unsigned short startX, unsigned short startY,
+                                                                             char object) {
+    TraceSpan span("findSpecifiedObject", "pathfinding");
+    const Map& map = bfs.getMap();
+    unsigned int width = map.getWidth();
+    unsigned int height = map.getHeight();
+
+    // Only objects in the component of the starting position can be reached, so the map
+    // is only searched if there is one
+    std::vector<std::pair<unsigned short, unsigned short>> candidates;
+    BitGrid goals(width, height);
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            if (map.getCell(x, y) == object && map.isReachable(startX, startY, x, y)) {
+                candidates.push_back({x, y});
+                goals.set(x, y);
+            }
+        }
+    }
+    if (candidates.empty()) {
+        return std::nullopt;
+    }
+
+    // Perform BFS until the level of the nearest candidate has been reached
+    bfs.searchUntil(startX, startY, goals);
+
+    // Take the nearest candidate, the first in row order among those at the same distance
+    std::optional<std::pair<unsigned short, unsigned short>> nearest;
+    int nearestDistance = 0;
+    for (const auto& [x, y] : candidates) {
+        int distance = bfs.getDistance(x, y);
+        if (distance >= 0 && (!nearest || distance < nearestDistance)) {
+            nearest = std::make_pair(x, y);
+            nearestDistance = distance;
+        }
+    }
+
+    return nearest;
+}
+
+std::pair<unsigned short, unsigned short> findStepTowards(BitBFS& bfs, unsigned short fromX, unsigned short fromY, unsigned short radius,
+                                                          unsigned short targetX, unsigned short targetY,
+                                                          const std::function<bool(unsigned short, unsigned short)>& isBlocked) {
+    TraceSpan span("findStepTowards", "pathfinding");
+    const Map& map = bfs.getMap();
+    std::pair<unsigned short, unsigned short> best = {fromX, fromY};
+    if (!map.isReachable(fromX, fromY, targetX, targetY)) {
+        return best;  // The target cannot be reached, no need to flood the map to find out
+    }
+
+    // Cells of the diamond only matter if they are nearer to the target than the current
+    // position, so the search stops at its level
+    bfs.searchUntil(targetX, targetY, fromX, fromY);
+    int bestDistance = bfs.getDistance(fromX, fromY);
+
+    // Check every cell of the diamond around the current position
+    int r = radius;
+    for (int dy = -r; dy <= r; ++dy) {
+        for (int dx = -(r - std::abs(dy)); dx <= r - std::abs(dy); ++dx) {
+            int x = fromX + dx;
+            int y = fromY + dy;
+            if (x < 0 || y < 0 || x >= static_cast<int>(map.getWidth()) || y >= static_cast<int>(map.getHeight())) {
+                continue;
+            }
+            int cellDistance = bfs.getDistance(x, y);
+            if (cellDistance > 0 && cellDistance < bestDistance && !(isBlocked && isBlocked(x, y))) {
+                best = {static_cast<unsigned short>(x), static_cast<unsigned short>(y)};
+                bestDistance = cellDistance;
+            }
+        }
+    }
+
+    return best;
+}
@@ -1,13 +1,14 @@
 #include "player.hpp"
+#include <algorithm>
 
-Player::Player(bool id, const std::string& name, unsigned int gold) : playerId(id), playerName(name), playerGold(gold) {
+Player::Player(OwnerId id, const std::string& name, unsigned int gold) : playerId(id), playerName(name), playerGold(gold) {
 }
 
 unsigned int Player::getGold() const {
     return playerGold;
 }
 
-bool Player::getID() const {
+OwnerId Player::getID() const {
     return playerId;
 }
 
@@ -15,17 +16,53 @@ std::string Player::getName() const {
     return playerName;
 }
 
-std::vector<Unit> Player::getPlayerUnits() {
+std::vector<Unit>& Player::getPlayerUnits() {
     return playerUnits;
 }
 
-Unit Player::getUnitByID(unsigned short id) {
-    for (auto &unit : playerUnits) {
-        if (unit.getId() == id) {
-            return unit;
+Unit& Player::getUnitByID(unsigned short id) {
+    Unit* unit = findUnitByID(id);
+    if (!unit) {
+        throw std::runtime_error("Unit with ID " + std::to_string(id) + " not found.");
+    }
+    return *unit;
+}
+
+Unit* Player::findUnitByID(unsigned short id) {
+    auto it = unitIndices.find(id);
+    return it == unitIndices.end() ? nullptr : &playerUnits[it->second];
+}
+
+size_t Player::removeDestroyedUnits() {
+    size_t scanned = playerUnits.size();
+    size_t removed = 0;
+    size_t index = 0;
+    while (index < playerUnits.size()) {
+        if (playerUnits[index].getHealth() > 0) {
+            ++index;
+            continue;
         }
+
+        // Move the last unit into the slot of the destroyed one
+        unitIndices.erase(playerUnits[index].getId());
+        if (index + 1 != playerUnits.size()) {
+            playerUnits[index] = std::move(playerUnits.back());
+            unitIndices[playerUnits[index].getId()] = index;
+        }
+        playerUnits.pop_back();
+        ++removed;
     }
-    return playerUnits[0];
+
+    ++compactionStats.sweeps;
+    compactionStats.removedUnits += removed;
+    compactionStats.lastRemoved = removed;
+    compactionStats.lastScanned = scanned;
+    compactionStats.peakUnits = std::max(compactionStats.peakUnits, playerUnits.size());
+    return removed;
+}
+
+const Player::CompactionStats& Player::getCompactionStats() const {
+    return compactionStats;
 }
 
 void Player::setGold(unsigned int amount) {
@@ -33,5 +70,6 @@ void Player::setGold(unsigned int amount) {
 }
 
 void Player::addUnitToPlayerUnits(const Unit& unit) {
+    unitIndices[unit.getId()] = playerUnits.size();
     playerUnits.push_back(unit);
 }
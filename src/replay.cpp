@@ -0,0 +1,455 @@
+#include "replay.hpp"
+#include <algorithm>
+
+namespace {
+
+const char replayMagic[4] = {'S', 'K', 'R', 'P'};
+const char indexMagic[4] = {'S', 'K', 'R', 'I'};
+// The footer holds the offset of the seek index, the number of records and the index magic
+const std::streamoff footerSize = 8 + 8 + 4;
+
+enum DeltaFlags : std::uint8_t {
+    ChangedX = 1,
+    ChangedY = 2,
+    ChangedHealth = 4,
+    NewUnit = 8
+};
+
+void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// Signed differences are zigzag encoded so that small negative values stay short
+void putSigned(std::string& out, std::int64_t value) {
+    putVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+void putFixed64(std::string& out, std::uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        out += static_cast<char>(value >> shift);
+    }
+}
+
+std::uint8_t getByte(std::istream& in) {
+    int byte = in.rdbuf()->sbumpc();
+    if (byte == std::char_traits<char>::eof()) {
+        throw std::runtime_error("Unexpected end of the replay file.");
+    }
+    return static_cast<std::uint8_t>(byte);
+}
+
+std::uint64_t getVarint(std::istream& in) {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        std::uint8_t byte = getByte(in);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Invalid varint in the replay file.");
+}
+
+std::int64_t getSigned(std::istream& in) {
+    std::uint64_t value = getVarint(in);
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+std::uint64_t getFixed64(std::istream& in) {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 8) {
+        value |= static_cast<std::uint64_t>(getByte(in)) << shift;
+    }
+    return value;
+}
+
+void putOrders(std::string& out, const std::vector<Order>& orders) {
+    putVarint(out, orders.size());
+    for (const Order& order : orders) {
+        putVarint(out, order.unitId);
+        out += order.action;
+        switch (order.action) {
+            case 'B':
+                out += order.unitType;
+                break;
+            case 'M':
+                putVarint(out, order.x);
+                putVarint(out, order.y);
+                break;
+            case 'A':
+                putVarint(out, order.targetId);
+                break;
+        }
+    }
+}
+
+void getOrders(std::istream& in, std::vector<Order>& orders) {
+    orders.resize(getVarint(in));
+    for (Order& order : orders) {
+        order = Order();
+        order.unitId = getVarint(in);
+        order.action = static_cast<char>(getByte(in));
+        switch (order.action) {
+            case 'B':
+                order.unitType = static_cast<char>(getByte(in));
+                break;
+            case 'M':
+                order.x = getVarint(in);
+                order.y = getVarint(in);
+                break;
+            case 'A':
+                order.targetId = getVarint(in);
+                break;
+        }
+    }
+}
+
+}  // namespace
+
+bool ReplayUnit::operator==(const ReplayUnit& other) const {
+    return id == other.id && owner == other.owner && initial == other.initial && x == other.x && y == other.y && health == other.health;
+}
+
+ReplayWriter::ReplayWriter(const std::string& path, const Map& map, const std::vector<std::uint64_t>& seeds, unsigned int keyframeInterval)
+    : file(path, std::ios::binary | std::ios::trunc), keyframeInterval(std::max(1u, keyframeInterval)), closed(false) {
+    if (!file) {
+        throw std::runtime_error("Failed to create the replay file " + path + ".");
+    }
+
+    std::string header(replayMagic, sizeof(replayMagic));
+    putVarint(header, replayVersion);
+    putFixed64(header, map.computeHash());
+    putVarint(header, map.getWidth());
+    putVarint(header, map.getHeight());
+    putVarint(header, seeds.size());
+    for (std::uint64_t seed : seeds) {
+        putVarint(header, seed);
+    }
+    putVarint(header, this->keyframeInterval);
+    file.write(header.data(), header.size());
+}
+
+ReplayWriter::~ReplayWriter() {
+    try {
+        close();
+    } catch (const std::runtime_error&) {
+        // Nothing more can be done about a replay that cannot be finished
+    }
+}
+
+void ReplayWriter::addTurn(std::uint64_t time, unsigned int playerId, const std::vector<Order>& orders, const std::vector<Player*>& players) {
+    // Gather the state after the turn in ID order
+    std::vector<ReplayUnit> units;
+    std::vector<std::uint32_t> gold(players.size(), 0);
+    for (Player* player : players) {
+        gold.at(player->getID()) = player->getGold();
+        for (const Unit& unit : player->getPlayerUnits()) {
+            units.push_back({unit.getId(), static_cast<std::uint8_t>(player->getID()), unit.getInitial(),
+                             unit.getPositionX(), unit.getPositionY(), unit.getHealth()});
+        }
+    }
+    std::sort(units.begin(), units.end(), [](const ReplayUnit& a, const ReplayUnit& b) { return a.id < b.id; });
+
+    bool keyframe = offsets.size() % keyframeInterval == 0;
+    record.clear();
+    record += keyframe ? 'K' : 'D';
+    putVarint(record, time);
+    record += static_cast<char>(playerId);
+    // The gold of every player, as differences with the previous record in delta records
+    previousGold.resize(gold.size(), 0);
+    putVarint(record, gold.size());
+    for (size_t id = 0; id < gold.size(); ++id) {
+        if (keyframe) {
+            putVarint(record, gold[id]);
+        } else {
+            putSigned(record, static_cast<std::int64_t>(gold[id]) - previousGold[id]);
+        }
+    }
+    putOrders(record, orders);
+
+    if (keyframe) {
+        // The complete state, with IDs as gaps from the previous ID
+        putVarint(record, units.size());
+        std::uint16_t lastId = 0;
+        for (const ReplayUnit& unit : units) {
+            putVarint(record, unit.id - lastId);
+            lastId = unit.id;
+            record += static_cast<char>(unit.owner);
+            record += unit.initial;
+            putVarint(record, unit.x);
+            putVarint(record, unit.y);
+            putVarint(record, unit.health);
+        }
+    } else {
+        // Walk both sorted lists to find the removed, new and changed units
+        std::vector<std::uint16_t> removed;
+        std::vector<std::pair<const ReplayUnit*, const ReplayUnit*>> changed;
+        size_t before = 0;
+        for (const ReplayUnit& unit : units) {
+            while (before < previousUnits.size() && previousUnits[before].id < unit.id) {
+                removed.push_back(previousUnits[before++].id);
+            }
+            if (before < previousUnits.size() && previousUnits[before].id == unit.id) {
+                if (!(previousUnits[before] == unit)) {
+                    changed.push_back({&previousUnits[before], &unit});
+                }
+                ++before;
+            } else {
+                changed.push_back({nullptr, &unit});
+            }
+        }
+        for (; before < previousUnits.size(); ++before) {
+            removed.push_back(previousUnits[before].id);
+        }
+
+        putVarint(record, removed.size());
+        std::uint16_t lastId = 0;
+        for (std::uint16_t id : removed) {
+            putVarint(record, id - lastId);
+            lastId = id;
+        }
+
+        putVarint(record, changed.size());
+        lastId = 0;
+        for (const auto& [old, unit] : changed) {
+            putVarint(record, unit->id - lastId);
+            lastId = unit->id;
+            if (!old || old->owner != unit->owner || old->initial != unit->initial) {
+                record += static_cast<char>(NewUnit);
+                record += static_cast<char>(unit->owner);
+                record += unit->initial;
+                putVarint(record, unit->x);
+                putVarint(record, unit->y);
+                putVarint(record, unit->health);
+                continue;
+            }
+            std::uint8_t flags = (old->x != unit->x ? ChangedX : 0) | (old->y != unit->y ? ChangedY : 0) |
+                                 (old->health != unit->health ? ChangedHealth : 0);
+            record += static_cast<char>(flags);
+            if (flags & ChangedX) {
+                putSigned(record, static_cast<std::int64_t>(unit->x) - old->x);
+            }
+            if (flags & ChangedY) {
+                putSigned(record, static_cast<std::int64_t>(unit->y) - old->y);
+            }
+            if (flags & ChangedHealth) {
+                putSigned(record, static_cast<std::int64_t>(unit->health) - old->health);
+            }
+        }
+    }
+
+    offsets.push_back(static_cast<std::uint64_t>(file.tellp()));
+    file.write(record.data(), record.size());
+    previousUnits.swap(units);
+    previousGold.swap(gold);
+}
+
+void ReplayWriter::close() {
+    if (closed) {
+        return;
+    }
+    closed = true;
+
+    // Fixed-size index entries, so the offset of any record is read directly
+    std::string trailer;
+    std::uint64_t indexOffset = static_cast<std::uint64_t>(file.tellp());
+    for (std::uint64_t offset : offsets) {
+        putFixed64(trailer, offset);
+    }
+    putFixed64(trailer, indexOffset);
+    putFixed64(trailer, offsets.size());
+    trailer.append(indexMagic, sizeof(indexMagic));
+    file.write(trailer.data(), trailer.size());
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write the replay file.");
+    }
+}
+
+ReplayReader::ReplayReader(const std::string& path) : file(path, std::ios::binary), nextTurn(0) {
+    if (!file) {
+        throw std::runtime_error("Failed to open the replay file " + path + ".");
+    }
+
+    char magic[4];
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, replayMagic)) {
+        throw std::runtime_error(path + " is not a replay file.");
+    }
+    std::uint64_t version = getVarint(file);
+    if (version != replayVersion) {
+        throw std::runtime_error("Unsupported replay version " + std::to_string(version) + ".");
+    }
+    mapHash = getFixed64(file);
+    width = getVarint(file);
+    height = getVarint(file);
+    seeds.resize(getVarint(file));
+    for (std::uint64_t& seed : seeds) {
+        seed = getVarint(file);
+    }
+    keyframeInterval = getVarint(file);
+    std::streamoff firstRecord = file.tellg();
+
+    // The footer closes the file
+    file.seekg(-footerSize, std::ios::end);
+    indexOffset = getFixed64(file);
+    turnCount = getFixed64(file);
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, indexMagic) || keyframeInterval == 0) {
+        throw std::runtime_error(path + " is not a finished replay file.");
+    }
+    file.seekg(firstRecord);
+}
+
+std::uint64_t ReplayReader::getMapHash() const {
+    return mapHash;
+}
+
+unsigned int ReplayReader::getWidth() const {
+    return width;
+}
+
+unsigned int ReplayReader::getHeight() const {
+    return height;
+}
+
+const std::vector<std::uint64_t>& ReplayReader::getSeeds() const {
+    return seeds;
+}
+
+std::uint64_t ReplayReader::getTurnCount() const {
+    return turnCount;
+}
+
+std::uint64_t ReplayReader::readIndexEntry(std::uint64_t turn) {
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(indexOffset + 8 * turn));
+    return getFixed64(file);
+}
+
+void ReplayReader::seek(std::uint64_t turn) {
+    if (turn > turnCount) {
+        throw std::runtime_error("Turn " + std::to_string(turn) + " is past the end of the replay.");
+    }
+    if (turn == turnCount) {
+        nextTurn = turnCount;
+        return;
+    }
+
+    // Start from the closest keyframe and decode forward up to the turn
+    std::uint64_t keyframe = turn - turn % keyframeInterval;
+    file.seekg(static_cast<std::streamoff>(readIndexEntry(keyframe)));
+    nextTurn = keyframe;
+    while (nextTurn < turn) {
+        decodeRecord(current);
+    }
+}
+
+bool ReplayReader::next(ReplayTurn& turn) {
+    if (nextTurn >= turnCount) {
+        return false;
+    }
+    decodeRecord(current);
+    turn = current;
+    return true;
+}
+
+void ReplayReader::decodeRecord(ReplayTurn& turn) {
+    char kind = static_cast<char>(getByte(file));
+    if (kind != 'K' && kind != 'D') {
+        throw std::runtime_error("Invalid record in the replay file.");
+    }
+    bool keyframe = kind == 'K';
+
+    turn.time = getVarint(file);
+    turn.playerId = getByte(file);
+    std::uint64_t playerCount = getVarint(file);
+    if (playerCount > maxPlayers) {
+        throw std::runtime_error("Invalid record in the replay file.");
+    }
+    turn.gold.resize(playerCount, 0);
+    for (std::uint32_t& gold : turn.gold) {
+        gold = keyframe ? getVarint(file) : gold + getSigned(file);
+    }
+    getOrders(file, turn.orders);
+
+    if (keyframe) {
+        turn.units.resize(getVarint(file));
+        std::uint16_t lastId = 0;
+        for (ReplayUnit& unit : turn.units) {
+            unit.id = lastId + getVarint(file);
+            lastId = unit.id;
+            unit.owner = getByte(file);
+            unit.initial = static_cast<char>(getByte(file));
+            unit.x = getVarint(file);
+            unit.y = getVarint(file);
+            unit.health = getVarint(file);
+        }
+    } else {
+        // Drop the removed units
+        std::vector<std::uint16_t> removed(getVarint(file));
+        std::uint16_t lastId = 0;
+        for (std::uint16_t& id : removed) {
+            id = lastId + getVarint(file);
+            lastId = id;
+        }
+        size_t removedIndex = 0;
+        std::vector<ReplayUnit> units;
+        units.reserve(turn.units.size());
+        for (const ReplayUnit& unit : turn.units) {
+            if (removedIndex < removed.size() && removed[removedIndex] == unit.id) {
+                ++removedIndex;
+            } else {
+                units.push_back(unit);
+            }
+        }
+
+        // Apply the changes and insert the new units, both in ID order
+        size_t changedCount = getVarint(file);
+        std::vector<ReplayUnit> merged;
+        merged.reserve(units.size() + changedCount);
+        size_t existing = 0;
+        lastId = 0;
+        for (size_t i = 0; i < changedCount; ++i) {
+            std::uint16_t id = lastId + getVarint(file);
+            lastId = id;
+            while (existing < units.size() && units[existing].id < id) {
+                merged.push_back(units[existing++]);
+            }
+            std::uint8_t flags = getByte(file);
+            if (flags & NewUnit) {
+                ReplayUnit unit;
+                unit.id = id;
+                unit.owner = getByte(file);
+                unit.initial = static_cast<char>(getByte(file));
+                unit.x = getVarint(file);
+                unit.y = getVarint(file);
+                unit.health = getVarint(file);
+                if (existing < units.size() && units[existing].id == id) {
+                    ++existing;
+                }
+                merged.push_back(unit);
+                continue;
+            }
+            if (existing >= units.size() || units[existing].id != id) {
+                throw std::runtime_error("A replay record changes unit " + std::to_string(id) + ", which does not exist.");
+            }
+            ReplayUnit unit = units[existing++];
+            if (flags & ChangedX) {
+                unit.x += getSigned(file);
+            }
+            if (flags & ChangedY) {
+                unit.y += getSigned(file);
+            }
+            if (flags & ChangedHealth) {
+                unit.health += getSigned(file);
+            }
+            merged.push_back(unit);
+        }
+        merged.insert(merged.end(), units.begin() + existing, units.end());
+        turn.units.swap(merged);
+    }
+    ++nextTurn;
+}
@@ -0,0 +1,177 @@
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include "replay.hpp"
+
+const char unitInitials[] = {'W', 'S', 'K', 'A', 'P', 'C', 'R'};
+
+Map buildMap(unsigned int size) {
+    std::stringstream stream;
+    for (unsigned int y = 0; y < size; ++y) {
+        std::string row(size, '0');
+        if (y == 1) {
+            row[1] = '1';
+        }
+        if (y == size - 2) {
+            row[size - 2] = '2';
+        }
+        stream << row << '\n';
+    }
+    return Map(stream);
+}
+
+// Gather the state of the players as a replay turn, in unit ID order
+ReplayTurn snapshot(std::uint64_t time, unsigned int playerId, const std::vector<Order>& orders, const std::vector<Player*>& players) {
+    ReplayTurn turn;
+    turn.time = time;
+    turn.playerId = playerId;
+    turn.orders = orders;
+    for (Player* player : players) {
+        turn.gold.push_back(player->getGold());
+        for (const Unit& unit : player->getPlayerUnits()) {
+            turn.units.push_back({unit.getId(), static_cast<std::uint8_t>(player->getID()), unit.getInitial(),
+                                  unit.getPositionX(), unit.getPositionY(), unit.getHealth()});
+        }
+    }
+    std::sort(turn.units.begin(), turn.units.end(), [](const ReplayUnit& a, const ReplayUnit& b) { return a.id < b.id; });
+    return turn;
+}
+
+// Check that a decoded turn holds exactly the recorded state
+bool sameTurn(const ReplayTurn& expected, const ReplayTurn& actual) {
+    if (expected.time != actual.time || expected.playerId != actual.playerId || expected.gold != actual.gold ||
+        expected.units != actual.units || expected.orders.size() != actual.orders.size()) {
+        return false;
+    }
+    for (size_t index = 0; index < expected.orders.size(); ++index) {
+        if (formatOrder(expected.orders[index]) != formatOrder(actual.orders[index])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Play random turns: units move, take damage, die and are created, gold rises and falls, and
+// every turn has a few random orders of each kind
+std::vector<ReplayTurn> playTurns(ReplayWriter& writer, std::vector<Player*>& players, unsigned int size, unsigned int turns,
+                                  std::mt19937& gen) {
+    std::uniform_int_distribution<unsigned int> disPosition(0, size - 1);
+    std::uniform_int_distribution<unsigned int> disInitial(0, sizeof(unitInitials) - 1);
+    unsigned short nextId = 1;
+    for (Player* player : players) {
+        for (int count = 0; count < 20; ++count) {
+            Unit unit(player->getID(), nextId++, unitTypeMap.at(unitInitials[disInitial(gen)]));
+            unit.setPosition(disPosition(gen), disPosition(gen));
+            player->addUnitToPlayerUnits(unit);
+        }
+    }
+
+    std::vector<ReplayTurn> expected;
+    std::uint64_t time = 0;
+    for (unsigned int index = 0; index < turns; ++index) {
+        time += 1 + gen() % 2;
+        unsigned int playerId = index % players.size();
+
+        for (Player* player : players) {
+            std::vector<Unit>& units = player->getPlayerUnits();
+            for (Unit& unit : units) {
+                if (gen() % 4 == 0) {
+                    unit.setPosition(disPosition(gen), disPosition(gen));
+                }
+                if (gen() % 8 == 0) {
+                    unit.takeDamage(std::min<unsigned int>(unit.getHealth(), 1 + gen() % 40));
+                }
+            }
+            player->removeDestroyedUnits();
+            // New units get increasing IDs with gaps, as rejected builds leave them
+            if (gen() % 3 == 0) {
+                nextId += gen() % 3;
+                Unit unit(player->getID(), nextId++, unitTypeMap.at(unitInitials[disInitial(gen)]));
+                unit.setPosition(disPosition(gen), disPosition(gen));
+                player->addUnitToPlayerUnits(unit);
+            }
+            unsigned int change = gen() % 200;
+            player->setGold(gen() % 2 ? player->getGold() + change : player->getGold() - std::min(change, player->getGold()));
+        }
+
+        std::vector<Order> orders(gen() % 9);
+        for (Order& order : orders) {
+            order.unitId = gen() % nextId;
+            order.action = "BMA"[gen() % 3];
+            if (order.action == 'B') {
+                order.unitType = unitInitials[disInitial(gen)];
+            } else if (order.action == 'M') {
+                order.x = disPosition(gen);
+                order.y = disPosition(gen);
+            } else {
+                order.targetId = gen() % nextId;
+            }
+        }
+
+        writer.addTurn(time, playerId, orders, players);
+        expected.push_back(snapshot(time, playerId, orders, players));
+    }
+    return expected;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned int turns = 500;
+    unsigned int seeks = 300;
+
+    if (argc > 1) {
+        turns = std::max(1, std::stoi(argv[1]));
+    }
+    if (argc > 2) {
+        seeks = std::stoi(argv[2]);
+    }
+
+    const unsigned int size = 256;
+    const std::string path = (std::filesystem::temp_directory_path() / "replay_bench.rpl").string();
+    Map map = buildMap(size);
+    std::mt19937 gen(42);
+    Player player1(0, "Player 1", 500), player2(1, "Player 2", 500), player3(2, "Player 3", 500);
+    std::vector<Player*> players = {&player1, &player2, &player3};
+
+    std::vector<ReplayTurn> expected;
+    {
+        ReplayWriter writer(path, map, {42, 7});
+        expected = playTurns(writer, players, size, turns, gen);
+        writer.close();
+    }
+
+    // Every turn in order
+    ReplayReader reader(path);
+    bool sequential = reader.getTurnCount() == turns && reader.getWidth() == size && reader.getHeight() == size;
+    ReplayTurn turn;
+    auto start = std::chrono::steady_clock::now();
+    for (const ReplayTurn& recorded : expected) {
+        sequential = sequential && reader.next(turn) && sameTurn(recorded, turn);
+    }
+    sequential = sequential && !reader.next(turn);
+    std::chrono::duration<double> decoding = std::chrono::steady_clock::now() - start;
+
+    // Random turns reached through the seek index
+    bool seeking = true;
+    std::uniform_int_distribution<unsigned int> disTurn(0, turns - 1);
+    start = std::chrono::steady_clock::now();
+    for (unsigned int count = 0; count < seeks; ++count) {
+        unsigned int index = disTurn(gen);
+        reader.seek(index);
+        seeking = seeking && reader.next(turn) && sameTurn(expected[index], turn);
+    }
+    std::chrono::duration<double> seekingTime = std::chrono::steady_clock::now() - start;
+
+    std::uintmax_t bytes = std::filesystem::file_size(path);
+    std::filesystem::remove(path);
+
+    std::cout << "Turns: " << turns << ", seeks: " << seeks << ", " << bytes << " bytes (" << static_cast<double>(bytes) / turns
+              << " bytes/turn)" << std::endl;
+    std::cout << "Decoding " << turns / decoding.count() << " turns/s, seeking " << seeks / seekingTime.count() << " seeks/s" << std::endl;
+    std::cout << "Sequential turns: " << (sequential ? "match" : "DIFFER") << ", seeked turns: " << (seeking ? "match" : "DIFFER")
+              << std::endl;
+
+    return sequential && seeking ? 0 : 1;
+}
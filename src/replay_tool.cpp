@@ -0,0 +1,58 @@
+#include <iostream>
+#include "replay.hpp"
+
+void printTurn(std::uint64_t index, const ReplayTurn& turn, bool details) {
+    std::cout << "Turn " << index << ": time " << turn.time << ", player " << static_cast<int>(turn.playerId) + 1 << ", gold ";
+    for (size_t id = 0; id < turn.gold.size(); ++id) {
+        std::cout << (id > 0 ? "/" : "") << turn.gold[id];
+    }
+    std::cout << ", " << turn.orders.size() << " orders, " << turn.units.size() << " units" << std::endl;
+    if (!details) {
+        return;
+    }
+    for (const Order& order : turn.orders) {
+        std::cout << "  order " << formatOrder(order) << std::endl;
+    }
+    for (const ReplayUnit& unit : turn.units) {
+        std::cout << "  unit " << unit.id << " " << unit.initial << " of player " << static_cast<int>(unit.owner) + 1 << " at "
+                  << unit.x << " " << unit.y << " with " << unit.health << " health" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Invalid amount of arguments. Usage: ./replay <replay file> [turn]" << std::endl;
+        return 1;
+    }
+
+    try {
+        ReplayReader reader(argv[1]);
+        std::cout << "Map " << reader.getWidth() << "x" << reader.getHeight() << ", hash " << std::hex << reader.getMapHash()
+                  << std::dec << ", " << reader.getTurnCount() << " turns, seeds:";
+        for (std::uint64_t seed : reader.getSeeds()) {
+            std::cout << " " << seed;
+        }
+        std::cout << std::endl;
+
+        ReplayTurn turn;
+        if (argc == 3) {
+            // Jump straight to the requested turn
+            std::uint64_t index = std::stoull(argv[2]);
+            reader.seek(index);
+            if (!reader.next(turn)) {
+                std::cerr << "The replay has no turn " << index << "." << std::endl;
+                return 1;
+            }
+            printTurn(index, turn, true);
+        } else {
+            for (std::uint64_t index = 0; reader.next(turn); ++index) {
+                printTurn(index, turn, false);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,322 @@
+#include "scenario.hpp"
+#include "unit.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+// Visit the passable cells reachable from a start cell in breadth-first order
+std::vector<size_t> breadthFirstOrder(const std::vector<std::string>& rows, size_t start, std::vector<std::uint8_t>& visited) {
+    size_t width = rows[0].size();
+    size_t height = rows.size();
+    std::vector<size_t> order = {start};
+    visited[start] = 1;
+
+    for (size_t head = 0; head < order.size(); ++head) {
+        size_t cell = order[head];
+        size_t x = cell % width;
+        size_t y = cell / width;
+        size_t neighbours[4];
+        size_t count = 0;
+        if (x > 0) neighbours[count++] = cell - 1;
+        if (x + 1 < width) neighbours[count++] = cell + 1;
+        if (y > 0) neighbours[count++] = cell - width;
+        if (y + 1 < height) neighbours[count++] = cell + width;
+        for (size_t i = 0; i < count; ++i) {
+            size_t next = neighbours[i];
+            if (!visited[next] && rows[next / width][next % width] != '9') {
+                visited[next] = 1;
+                order.push_back(next);
+            }
+        }
+    }
+    return order;
+}
+
+// Turn every passable cell outside the largest connected region into an obstacle
+void keepLargestRegion(std::vector<std::string>& rows) {
+    size_t width = rows[0].size();
+    size_t height = rows.size();
+    std::vector<std::uint8_t> visited(width * height, 0);
+    std::vector<size_t> largest;
+
+    for (size_t cell = 0; cell < width * height; ++cell) {
+        if (!visited[cell] && rows[cell / width][cell % width] != '9') {
+            std::vector<size_t> region = breadthFirstOrder(rows, cell, visited);
+            if (region.size() > largest.size()) {
+                largest.swap(region);
+            }
+        }
+    }
+
+    std::vector<std::uint8_t> keep(width * height, 0);
+    for (size_t cell : largest) {
+        keep[cell] = 1;
+    }
+    for (size_t cell = 0; cell < width * height; ++cell) {
+        if (!keep[cell]) {
+            rows[cell / width][cell % width] = '9';
+        }
+    }
+}
+
+// Carve a straight horizontal then vertical passage between two cells
+void carveBridge(std::vector<std::string>& rows, int fromX, int fromY, int toX, int toY) {
+    for (int x = std::min(fromX, toX); x <= std::max(fromX, toX); ++x) {
+        rows[fromY][x] = '0';
+    }
+    for (int y = std::min(fromY, toY); y <= std::max(fromY, toY); ++y) {
+        rows[y][toX] = '0';
+    }
+}
+
+}  // namespace
+
+ScenarioKind parseScenarioKind(const std::string& name) {
+    if (name == "open") {
+        return ScenarioKind::Open;
+    }
+    if (name == "maze") {
+        return ScenarioKind::Maze;
+    }
+    if (name == "islands") {
+        return ScenarioKind::Islands;
+    }
+    if (name == "cave") {
+        return ScenarioKind::Cave;
+    }
+    throw std::runtime_error("Unknown scenario kind: " + name);
+}
+
+std::string scenarioKindName(ScenarioKind kind) {
+    switch (kind) {
+        case ScenarioKind::Open:
+            return "open";
+        case ScenarioKind::Maze:
+            return "maze";
+        case ScenarioKind::Islands:
+            return "islands";
+        case ScenarioKind::Cave:
+            return "cave";
+    }
+    return "unknown";
+}
+
+std::vector<std::string> generateOpenRows(unsigned int size, double density, std::mt19937& gen) {
+    std::bernoulli_distribution obstacle(density);
+    std::vector<std::string> rows(size, std::string(size, '0'));
+    for (auto& row : rows) {
+        for (char& cell : row) {
+            if (obstacle(gen)) {
+                cell = '9';
+            }
+        }
+    }
+    rows[0][0] = '0';
+    return rows;
+}
+
+std::vector<std::string> generateMazeRows(unsigned int size, std::mt19937& gen) {
+    std::vector<std::string> rows(size, std::string(size, '9'));
+    std::vector<std::pair<unsigned int, unsigned int>> stack = {{0, 0}};
+    rows[0][0] = '0';
+
+    while (!stack.empty()) {
+        auto [x, y] = stack.back();
+        std::pair<int, int> options[4];
+        size_t count = 0;
+        for (const auto& [dx, dy] : {std::pair<int, int>{-2, 0}, {2, 0}, {0, -2}, {0, 2}}) {
+            int nx = static_cast<int>(x) + dx;
+            int ny = static_cast<int>(y) + dy;
+            if (nx >= 0 && ny >= 0 && nx < static_cast<int>(size) && ny < static_cast<int>(size) && rows[ny][nx] == '9') {
+                options[count++] = {nx, ny};
+            }
+        }
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+        auto [nx, ny] = options[std::uniform_int_distribution<size_t>(0, count - 1)(gen)];
+        rows[(y + ny) / 2][(x + nx) / 2] = '0';
+        rows[ny][nx] = '0';
+        stack.push_back({nx, ny});
+    }
+    return rows;
+}
+
+std::vector<std::string> generateIslandRows(unsigned int size, double density, std::mt19937& gen) {
+    std::vector<std::string> rows(size, std::string(size, '9'));
+    std::uniform_int_distribution<int> position(0, size - 1);
+    std::uniform_int_distribution<int> radius(std::max(2u, size / 16), std::max(3u, size / 6));
+    size_t target = static_cast<size_t>((1.0 - density) * size * size);
+    size_t land = 0;
+    std::vector<std::pair<int, int>> centers;
+
+    // Raise round islands until enough land has been placed
+    for (int attempt = 0; attempt < 10000 && land < target; ++attempt) {
+        int centerX = position(gen);
+        int centerY = position(gen);
+        int r = radius(gen);
+        for (int y = std::max(0, centerY - r); y <= std::min<int>(size - 1, centerY + r); ++y) {
+            for (int x = std::max(0, centerX - r); x <= std::min<int>(size - 1, centerX + r); ++x) {
+                if ((x - centerX) * (x - centerX) + (y - centerY) * (y - centerY) <= r * r && rows[y][x] == '9') {
+                    rows[y][x] = '0';
+                    ++land;
+                }
+            }
+        }
+        centers.push_back({centerX, centerY});
+    }
+
+    // Link every island to the previous one
+    for (size_t i = 1; i < centers.size(); ++i) {
+        carveBridge(rows, centers[i - 1].first, centers[i - 1].second, centers[i].first, centers[i].second);
+    }
+    return rows;
+}
+
+std::vector<std::string> generateCaveRows(unsigned int size, double density, std::mt19937& gen) {
+    std::bernoulli_distribution wall(density);
+    std::vector<std::string> rows(size, std::string(size, '0'));
+    for (auto& row : rows) {
+        for (char& cell : row) {
+            cell = wall(gen) ? '9' : '0';
+        }
+    }
+
+    for (int step = 0; step < 4; ++step) {
+        std::vector<std::string> smoothed = rows;
+        for (unsigned int y = 0; y < size; ++y) {
+            for (unsigned int x = 0; x < size; ++x) {
+                int walls = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        int nx = static_cast<int>(x) + dx;
+                        int ny = static_cast<int>(y) + dy;
+                        if (nx < 0 || ny < 0 || nx >= static_cast<int>(size) || ny >= static_cast<int>(size) || rows[ny][nx] == '9') {
+                            ++walls;
+                        }
+                    }
+                }
+                smoothed[y][x] = walls >= 5 ? '9' : '0';
+            }
+        }
+        rows.swap(smoothed);
+    }
+    return rows;
+}
+
+Scenario generateScenario(const ScenarioOptions& options) {
+    if (options.size < 4) {
+        throw std::runtime_error("Scenario maps must be at least 4 cells wide.");
+    }
+    if (options.playerCount < 2 || options.playerCount > maxPlayers) {
+        throw std::runtime_error("Scenarios are played by 2 to " + std::to_string(maxPlayers) + " players.");
+    }
+
+    std::mt19937 gen(options.seed);
+    Scenario scenario;
+    switch (options.kind) {
+        case ScenarioKind::Open:
+            scenario.rows = generateOpenRows(options.size, options.obstacleDensity < 0 ? 0.05 : options.obstacleDensity, gen);
+            break;
+        case ScenarioKind::Maze:
+            scenario.rows = generateMazeRows(options.size, gen);
+            break;
+        case ScenarioKind::Islands:
+            scenario.rows = generateIslandRows(options.size, options.obstacleDensity < 0 ? 0.5 : options.obstacleDensity, gen);
+            break;
+        case ScenarioKind::Cave:
+            scenario.rows = generateCaveRows(options.size, options.obstacleDensity < 0 ? 0.45 : options.obstacleDensity, gen);
+            break;
+    }
+    std::vector<std::string>& rows = scenario.rows;
+    keepLargestRegion(rows);
+
+    // Place every base on the free passable cell closest to its anchor. The anchors go around
+    // the edge of the map from the top-left corner, so two players get opposite corners.
+    size_t width = options.size;
+    size_t cellCount = width * width;
+    std::vector<size_t> bases(options.playerCount, cellCount);
+    std::vector<std::uint8_t> occupied(cellCount, 0);
+    const double pi = std::acos(-1.0);
+    double center = (options.size - 1) / 2.0;
+    for (OwnerId owner = 0; owner < options.playerCount; ++owner) {
+        double angle = 1.25 * pi + 2 * pi * owner / options.playerCount;
+        long anchorX = std::lround(std::clamp(center + options.size * std::cos(angle), 0.0, options.size - 1.0));
+        long anchorY = std::lround(std::clamp(center + options.size * std::sin(angle), 0.0, options.size - 1.0));
+        long bestDistance = 0;
+        for (size_t cell = 0; cell < cellCount; ++cell) {
+            if (rows[cell / width][cell % width] == '9' || occupied[cell]) {
+                continue;
+            }
+            long distance = std::labs(static_cast<long>(cell % width) - anchorX) + std::labs(static_cast<long>(cell / width) - anchorY);
+            if (bases[owner] == cellCount || distance < bestDistance) {
+                bases[owner] = cell;
+                bestDistance = distance;
+            }
+        }
+        if (bases[owner] == cellCount) {
+            throw std::runtime_error("The generated map has no room for " + std::to_string(options.playerCount) + " bases.");
+        }
+        occupied[bases[owner]] = 1;
+        rows[bases[owner] / width][bases[owner] % width] = Map::baseMarker(owner);
+    }
+
+    // Place the armies on the free cells closest to their base
+    const std::vector<std::string> unitTypes = {"Worker", "Swordsman", "Archer", "Knight", "Pikeman", "Catapult", "Ram"};
+    std::ostringstream status;
+    for (OwnerId owner = 0; owner < options.playerCount; ++owner) {
+        status << (owner > 0 ? " " : "") << options.gold;
+    }
+    status << '\n';
+    unsigned short nextId = 0;
+    for (OwnerId owner = 0; owner < options.playerCount; ++owner) {
+        size_t base = bases[owner];
+        Unit baseUnit(owner, nextId++, "Base");
+        status << static_cast<unsigned int>(owner) << " B " << baseUnit.getId() << " " << base % width << " " << base / width << " "
+               << baseUnit.getHealth() << " 0\n";
+    }
+    for (OwnerId owner = 0; owner < options.playerCount; ++owner) {
+        std::vector<std::uint8_t> visited(cellCount, 0);
+        std::vector<size_t> order = breadthFirstOrder(rows, bases[owner], visited);
+        unsigned int placed = 0;
+        for (size_t cell : order) {
+            if (placed == options.armySize) {
+                break;
+            }
+            if (occupied[cell]) {
+                continue;
+            }
+            occupied[cell] = 1;
+            Unit unit(owner, nextId++, unitTypes[placed % unitTypes.size()]);
+            status << static_cast<unsigned int>(owner) << " " << unit.getInitial() << " " << unit.getId() << " " << cell % width << " "
+                   << cell / width << " " << unit.getHealth() << '\n';
+            ++placed;
+        }
+        if (placed < options.armySize) {
+            throw std::runtime_error("The generated map has no room for the starting armies.");
+        }
+    }
+    scenario.status = status.str();
+    scenario.unitCount = options.playerCount * (1 + options.armySize);
+
+    // Spread the mines over the free cells, all of which can be reached from the bases
+    std::vector<size_t> freeCells;
+    for (size_t cell = 0; cell < cellCount; ++cell) {
+        if (!occupied[cell] && rows[cell / width][cell % width] == '0') {
+            freeCells.push_back(cell);
+        }
+    }
+    if (freeCells.size() < options.mineCount) {
+        throw std::runtime_error("The generated map has no room for the mines.");
+    }
+    for (unsigned int mine = 0; mine < options.mineCount; ++mine) {
+        size_t pick = std::uniform_int_distribution<size_t>(mine, freeCells.size() - 1)(gen);
+        std::swap(freeCells[mine], freeCells[pick]);
+        rows[freeCells[mine] / width][freeCells[mine] % width] = '6';
+    }
+
+    return scenario;
+}
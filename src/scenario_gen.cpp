@@ -0,0 +1,51 @@
+#include <iostream>
+#include <fstream>
+#include "scenario.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 6 || argc > 10) {
+        std::cerr << "Invalid amount of arguments. Usage: ./scenario <open|maze|islands|cave> <size> <seed> <map file> <status file>"
+                  << " [obstacle density] [mines] [army size] [players]" << std::endl;
+        return 1;
+    }
+
+    try {
+        ScenarioOptions options;
+        options.kind = parseScenarioKind(argv[1]);
+        options.size = std::stoi(argv[2]);
+        options.seed = std::stoul(argv[3]);
+        if (argc > 6) {
+            options.obstacleDensity = std::stod(argv[6]);
+        }
+        if (argc > 7) {
+            options.mineCount = std::stoi(argv[7]);
+        }
+        if (argc > 8) {
+            options.armySize = std::stoi(argv[8]);
+        }
+        if (argc > 9) {
+            options.playerCount = std::stoi(argv[9]);
+        }
+
+        Scenario scenario = generateScenario(options);
+
+        std::ofstream mapFile(argv[4]);
+        for (const std::string& row : scenario.rows) {
+            mapFile << row << '\n';
+        }
+        std::ofstream statusFile(argv[5]);
+        statusFile << scenario.status;
+        if (!mapFile || !statusFile) {
+            std::cerr << "Failed to write the scenario files." << std::endl;
+            return 1;
+        }
+
+        std::cout << scenarioKindName(options.kind) << " " << options.size << "x" << options.size << " scenario with "
+                  << scenario.unitCount << " units written to " << argv[4] << " and " << argv[5] << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
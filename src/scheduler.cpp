@@ -0,0 +1,154 @@
+#include "scheduler.hpp"
+#include <algorithm>
+
+TimingWheel::TimingWheel() : now(0), pending(0) {
+}
+
+void TimingWheel::schedule(const ScheduledEvent& event) {
+    ++pending;
+    place(event);
+}
+
+void TimingWheel::place(const ScheduledEvent& event) {
+    if (event.time <= now) {
+        ready.push_back(event);
+        return;
+    }
+
+    // The level is given by the highest bit in which the event time differs from the current time
+    std::uint64_t difference = event.time ^ now;
+    for (unsigned int level = 0; level < levelCount; ++level) {
+        if ((difference >> (slotBits * (level + 1))) == 0) {
+            levels[level][(event.time >> (slotBits * level)) & (slotCount - 1)].push_back(event);
+            return;
+        }
+    }
+    overflow.push_back(event);
+}
+
+std::vector<ScheduledEvent> TimingWheel::advance(std::uint64_t time) {
+    // Nothing is waiting in the wheel, so there are no slots to visit
+    if (pending == ready.size() && now < time) {
+        now = time;
+    }
+
+    while (now < time) {
+        ++now;
+
+        // Find the highest level whose boundary has been crossed and cascade from there down
+        unsigned int crossed = 0;
+        while (crossed + 1 < levelCount && (now & ((std::uint64_t(1) << (slotBits * (crossed + 1))) - 1)) == 0) {
+            ++crossed;
+        }
+        if (crossed + 1 == levelCount && (now & ((std::uint64_t(1) << (slotBits * levelCount)) - 1)) == 0) {
+            std::vector<ScheduledEvent> events;
+            events.swap(overflow);
+            for (const ScheduledEvent& event : events) {
+                place(event);
+            }
+        }
+        for (unsigned int level = crossed; level > 0; --level) {
+            std::vector<ScheduledEvent> events;
+            events.swap(levels[level][(now >> (slotBits * level)) & (slotCount - 1)]);
+            for (const ScheduledEvent& event : events) {
+                place(event);
+            }
+        }
+
+        std::vector<ScheduledEvent>& slot = levels[0][now & (slotCount - 1)];
+        ready.insert(ready.end(), slot.begin(), slot.end());
+        slot.clear();
+    }
+
+    std::vector<ScheduledEvent> due;
+    due.swap(ready);
+    pending -= due.size();
+    return due;
+}
+
+std::uint64_t TimingWheel::getTime() const {
+    return now;
+}
+
+size_t TimingWheel::size() const {
+    return pending - ready.size();
+}
+
+TurnScheduler::TurnScheduler(size_t maxQueueLength, unsigned int playerCount)
+    : maxQueueLength(maxQueueLength), playerCount(std::max(playerCount, 1u)) {
+}
+
+std::uint64_t TurnScheduler::turnTime(unsigned int turn, OwnerId owner) const {
+    return std::uint64_t(turn) * playerCount + owner;
+}
+
+void TurnScheduler::enqueueBuild(const Unit& base, const Unit& unit, std::uint64_t now) {
+    if (base.getName() != "Base") {
+        throw std::runtime_error("Only a base unit can create units.");
+    }
+
+    std::deque<Unit>& queue = buildQueues[base.getId()];
+    if (queue.size() >= maxQueueLength) {
+        throw std::runtime_error("The build queue of base " + std::to_string(base.getId()) + " is full.");
+    }
+
+    queue.push_back(unit);
+    if (queue.size() == 1) {
+        // The base was idle, the build finishes after as many of its owner's turns as its building time
+        wheel.schedule({now + playerCount * std::max<std::uint64_t>(unit.getBuildingTime(), 1), ScheduledEvent::Type::BuildComplete,
+                        base.getOwner(), base.getId()});
+    }
+}
+
+void TurnScheduler::scheduleReset(const Unit& unit, std::uint64_t now) {
+    if (pendingResets.insert(unit.getId()).second) {
+        wheel.schedule({now + playerCount, ScheduledEvent::Type::Reset, unit.getOwner(), unit.getId()});
+    }
+}
+
+std::vector<ScheduledEvent> TurnScheduler::advance(std::uint64_t time) {
+    std::vector<ScheduledEvent> events = wheel.advance(time);
+    for (const ScheduledEvent& event : events) {
+        if (event.type == ScheduledEvent::Type::Reset) {
+            pendingResets.erase(event.unitId);
+        }
+    }
+    return events;
+}
+
+std::optional<Unit> TurnScheduler::completeBuild(const ScheduledEvent& event, const Unit* base) {
+    auto it = buildQueues.find(event.unitId);
+    if (it == buildQueues.end() || it->second.empty()) {
+        return std::nullopt;
+    }
+
+    // A destroyed base loses its whole queue
+    if (!base || base->getHealth() == 0) {
+        buildQueues.erase(it);
+        return std::nullopt;
+    }
+
+    Unit deployed = it->second.front();
+    deployed.deploy(*base);
+    it->second.pop_front();
+
+    // Start the next build right away
+    if (it->second.empty()) {
+        buildQueues.erase(it);
+    } else {
+        const Unit& next = it->second.front();
+        wheel.schedule({event.time + playerCount * std::max<std::uint64_t>(next.getBuildingTime(), 1), ScheduledEvent::Type::BuildComplete,
+                        event.owner, event.unitId});
+    }
+    return deployed;
+}
+
+const Unit* TurnScheduler::getCurrentBuild(unsigned short baseId) const {
+    auto it = buildQueues.find(baseId);
+    return it == buildQueues.end() || it->second.empty() ? nullptr : &it->second.front();
+}
+
+size_t TurnScheduler::getQueueLength(unsigned short baseId) const {
+    auto it = buildQueues.find(baseId);
+    return it == buildQueues.end() ? 0 : it->second.size();
+}
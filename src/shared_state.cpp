@@ -0,0 +1,364 @@
+#include "shared_state.hpp"
+#include "status.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "The seqlock needs a lock-free 32-bit atomic.");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The orders ring needs lock-free 64-bit atomics.");
+static_assert(sizeof(SharedUnit) == 12, "SharedUnit is part of the binary layout.");
+static_assert(std::is_trivially_copyable_v<Order>, "Orders are copied into the ring as they are.");
+
+namespace {
+
+// Sections of the segments start on cache line boundaries
+size_t alignUp(size_t offset) {
+    return (offset + 63) & ~size_t(63);
+}
+
+std::runtime_error systemError(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+
+void checkLayout(std::uint32_t magic, std::uint32_t version, const std::string& name) {
+    if (magic != sharedStateMagic) {
+        throw std::runtime_error("The shared memory segment " + name + " is not a Skirmish segment.");
+    }
+    if (version != sharedStateVersion) {
+        throw std::runtime_error("The shared memory segment " + name + " has layout version " + std::to_string(version) +
+                                 ", expected " + std::to_string(sharedStateVersion) + ".");
+    }
+}
+
+}  // namespace
+
+SharedMemory::SharedMemory(const std::string& name, void* address, size_t size, int descriptor, bool owner)
+    : name(name), address(address), size(size), descriptor(descriptor), owner(owner) {
+}
+
+SharedMemory SharedMemory::create(const std::string& name, size_t size) {
+    shm_unlink(name.c_str());
+    int descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (descriptor < 0) {
+        throw systemError("Failed to create the shared memory segment", name);
+    }
+    if (ftruncate(descriptor, size) != 0) {
+        close(descriptor);
+        shm_unlink(name.c_str());
+        throw systemError("Failed to size the shared memory segment", name);
+    }
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (address == MAP_FAILED) {
+        close(descriptor);
+        shm_unlink(name.c_str());
+        throw systemError("Failed to map the shared memory segment", name);
+    }
+    return SharedMemory(name, address, size, descriptor, true);
+}
+
+SharedMemory SharedMemory::open(const std::string& name, bool writable) {
+    int descriptor = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (descriptor < 0) {
+        throw systemError("Failed to open the shared memory segment", name);
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        close(descriptor);
+        throw systemError("Failed to measure the shared memory segment", name);
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, descriptor, 0);
+    if (address == MAP_FAILED) {
+        close(descriptor);
+        throw systemError("Failed to map the shared memory segment", name);
+    }
+    return SharedMemory(name, address, size, descriptor, false);
+}
+
+SharedMemory::SharedMemory(SharedMemory&& other) noexcept
+    : name(std::move(other.name)), address(other.address), size(other.size), descriptor(other.descriptor), owner(other.owner) {
+    other.address = nullptr;
+    other.descriptor = -1;
+    other.owner = false;
+}
+
+SharedMemory::~SharedMemory() {
+    if (address) {
+        munmap(address, size);
+    }
+    if (descriptor >= 0) {
+        close(descriptor);
+    }
+    if (owner) {
+        shm_unlink(name.c_str());
+    }
+}
+
+void SharedMemory::resize(size_t newSize) {
+    if (!owner) {
+        throw std::runtime_error("Only the creator of the shared memory segment " + name + " can resize it.");
+    }
+    if (ftruncate(descriptor, newSize) != 0) {
+        throw systemError("Failed to resize the shared memory segment", name);
+    }
+    void* newAddress = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (newAddress == MAP_FAILED) {
+        throw systemError("Failed to map the shared memory segment", name);
+    }
+    munmap(address, size);
+    address = newAddress;
+    size = newSize;
+}
+
+void* SharedMemory::getAddress() const {
+    return address;
+}
+
+size_t SharedMemory::getSize() const {
+    return size;
+}
+
+const std::string& SharedMemory::getName() const {
+    return name;
+}
+
+SharedStatePublisher::SharedStatePublisher(const std::string& name, const Map& map, unsigned int unitCapacity)
+    : memory(SharedMemory::create(name, alignUp(alignUp(sizeof(SharedStateHeader)) + size_t(map.getWidth()) * map.getHeight()) +
+                                            size_t(unitCapacity) * sizeof(SharedUnit))) {
+    SharedStateHeader* h = new (memory.getAddress()) SharedStateHeader();
+    h->magic = sharedStateMagic;
+    h->version = sharedStateVersion;
+    h->width = map.getWidth();
+    h->height = map.getHeight();
+    h->unitCapacity = unitCapacity;
+    h->mapOffset = alignUp(sizeof(SharedStateHeader));
+    h->unitsOffset = alignUp(h->mapOffset + size_t(h->width) * h->height);
+
+    char* cells = static_cast<char*>(memory.getAddress()) + h->mapOffset;
+    for (unsigned int y = 0; y < h->height; ++y) {
+        for (unsigned int x = 0; x < h->width; ++x) {
+            cells[size_t(y) * h->width + x] = map.getCell(x, y);
+        }
+    }
+}
+
+SharedStateHeader& SharedStatePublisher::header() const {
+    return *static_cast<SharedStateHeader*>(memory.getAddress());
+}
+
+void SharedStatePublisher::publish(const std::vector<Player*>& players, OwnerId playerId, std::uint64_t turnTime,
+                                   const std::function<char(const Unit&)>& currentBuild) {
+    if (players.size() > maxPlayers) {
+        throw std::runtime_error("Too many players for the shared memory segment.");
+    }
+    size_t unitCount = 0;
+    for (Player* player : players) {
+        unitCount += player->getPlayerUnits().size();
+    }
+    if (unitCount > header().unitCapacity) {
+        // Bots map the segment at startup, so it can be grown between turns
+        size_t capacity = std::max(unitCount, size_t(header().unitCapacity) * 2);
+        memory.resize(header().unitsOffset + capacity * sizeof(SharedUnit));
+        header().unitCapacity = capacity;
+    }
+
+    SharedStateHeader& h = header();
+    std::uint32_t sequence = h.sequence.load(std::memory_order_relaxed);
+    h.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    h.playerId = playerId;
+    h.playerCount = players.size();
+    for (Player* player : players) {
+        h.gold[player->getID()] = player->getGold();
+    }
+    h.turnTime = turnTime;
+    h.unitCount = unitCount;
+    SharedUnit* units = reinterpret_cast<SharedUnit*>(static_cast<char*>(memory.getAddress()) + h.unitsOffset);
+    for (Player* owner : players) {
+        for (const Unit& unit : owner->getPlayerUnits()) {
+            *units++ = {unit.getId(), unit.getPositionX(), unit.getPositionY(), unit.getHealth(),
+                        static_cast<std::uint8_t>(owner->getID()), unit.getInitial(),
+                        unit.getInitial() == 'B' ? currentBuild(unit) : '0', 0};
+        }
+    }
+
+    h.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+const std::string& SharedStatePublisher::getName() const {
+    return memory.getName();
+}
+
+SharedStateView::SharedStateView(const std::string& name) : memory(SharedMemory::open(name, false)) {
+    if (memory.getSize() < sizeof(SharedStateHeader)) {
+        throw std::runtime_error("The shared memory segment " + name + " is too small.");
+    }
+    checkLayout(header().magic, header().version, name);
+    if (header().mapOffset + size_t(header().width) * header().height > memory.getSize()) {
+        throw std::runtime_error("The shared memory segment " + name + " is too small for its map.");
+    }
+}
+
+const SharedStateHeader& SharedStateView::header() const {
+    return *static_cast<const SharedStateHeader*>(memory.getAddress());
+}
+
+unsigned int SharedStateView::getWidth() const {
+    return header().width;
+}
+
+unsigned int SharedStateView::getHeight() const {
+    return header().height;
+}
+
+const char* SharedStateView::getCells() const {
+    return static_cast<const char*>(memory.getAddress()) + header().mapOffset;
+}
+
+SharedSnapshot SharedStateView::snapshot() const {
+    const SharedStateHeader& h = header();
+    SharedSnapshot result;
+    while (true) {
+        std::uint32_t before = h.sequence.load(std::memory_order_acquire);
+        if (before % 2 == 1) {
+            continue;
+        }
+
+        size_t unitCount = h.unitCount;
+        if (h.unitsOffset + unitCount * sizeof(SharedUnit) > memory.getSize()) {
+            throw std::runtime_error("The shared memory segment " + memory.getName() + " grew after it was mapped.");
+        }
+        result.playerId = h.playerId;
+        result.gold.assign(h.gold, h.gold + std::min<std::uint32_t>(h.playerCount, maxPlayers));
+        result.turnTime = h.turnTime;
+        result.units.resize(unitCount);
+        std::memcpy(result.units.data(), static_cast<const char*>(memory.getAddress()) + h.unitsOffset, unitCount * sizeof(SharedUnit));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (h.sequence.load(std::memory_order_relaxed) == before) {
+            return result;
+        }
+    }
+}
+
+void loadSnapshot(const SharedSnapshot& snapshot, unsigned int playerId, Player& player, Player& enemy) {
+    unsigned int enemyGold = 0;
+    for (size_t id = 0; id < snapshot.gold.size(); ++id) {
+        if (id == playerId) {
+            player.setGold(snapshot.gold[id]);
+        } else {
+            enemyGold += snapshot.gold[id];
+        }
+    }
+    enemy.setGold(enemyGold);
+    for (const SharedUnit& unit : snapshot.units) {
+        Player& receiver = unit.owner == playerId ? player : enemy;
+        receiver.addUnitToPlayerUnits(makeStatusUnit(receiver.getID(), unit.initial, unit.id, unit.x, unit.y, unit.health));
+    }
+}
+
+SharedOrderRing::SharedOrderRing(SharedMemory&& memory) : memory(std::move(memory)) {
+}
+
+SharedOrderRing SharedOrderRing::create(const std::string& name, unsigned int capacity) {
+    SharedOrderRing ring(SharedMemory::create(name, alignUp(sizeof(SharedOrderRingHeader)) + size_t(capacity) * sizeof(Order)));
+    SharedOrderRingHeader* h = new (ring.memory.getAddress()) SharedOrderRingHeader();
+    h->magic = sharedStateMagic;
+    h->version = sharedStateVersion;
+    h->capacity = capacity;
+    return ring;
+}
+
+SharedOrderRing SharedOrderRing::open(const std::string& name) {
+    SharedOrderRing ring(SharedMemory::open(name, true));
+    if (ring.memory.getSize() < sizeof(SharedOrderRingHeader)) {
+        throw std::runtime_error("The shared memory segment " + name + " is too small.");
+    }
+    checkLayout(ring.header().magic, ring.header().version, name);
+    if (alignUp(sizeof(SharedOrderRingHeader)) + size_t(ring.header().capacity) * sizeof(Order) > ring.memory.getSize()) {
+        throw std::runtime_error("The shared memory segment " + name + " is too small for its orders.");
+    }
+    return ring;
+}
+
+SharedOrderRingHeader& SharedOrderRing::header() const {
+    return *static_cast<SharedOrderRingHeader*>(memory.getAddress());
+}
+
+Order* SharedOrderRing::slots() const {
+    return reinterpret_cast<Order*>(static_cast<char*>(memory.getAddress()) + alignUp(sizeof(SharedOrderRingHeader)));
+}
+
+void SharedOrderRing::beginTurn(std::uint64_t turnTime) {
+    SharedOrderRingHeader& h = header();
+    h.tail.store(h.head.load(std::memory_order_acquire), std::memory_order_release);
+    h.turnTime.store(turnTime, std::memory_order_release);
+}
+
+void SharedOrderRing::push(const Order& order) {
+    SharedOrderRingHeader& h = header();
+    std::uint64_t head = h.head.load(std::memory_order_relaxed);
+    if (head - h.tail.load(std::memory_order_acquire) >= h.capacity) {
+        throw std::runtime_error("The orders ring is full.");
+    }
+    slots()[head % h.capacity] = order;
+    h.head.store(head + 1, std::memory_order_release);
+}
+
+void SharedOrderRing::commit() {
+    SharedOrderRingHeader& h = header();
+    h.committedTurn.store(h.turnTime.load(std::memory_order_acquire) + 1, std::memory_order_release);
+}
+
+bool SharedOrderRing::drain(std::vector<Order>& orders) {
+    SharedOrderRingHeader& h = header();
+    bool committed = h.committedTurn.load(std::memory_order_acquire) == h.turnTime.load(std::memory_order_relaxed) + 1;
+    std::uint64_t head = h.head.load(std::memory_order_acquire);
+    for (std::uint64_t index = h.tail.load(std::memory_order_relaxed); index < head; ++index) {
+        orders.push_back(slots()[index % h.capacity]);
+    }
+    h.tail.store(head, std::memory_order_release);
+    return committed;
+}
+
+const std::string& SharedOrderRing::getName() const {
+    return memory.getName();
+}
+
+std::optional<SharedStateView> openSharedState() {
+    const char* name = std::getenv(sharedStateVariable);
+    if (!name || !*name) {
+        return std::nullopt;
+    }
+    return std::optional<SharedStateView>(std::in_place, name);
+}
+
+Map loadSharedTurn(const SharedStateView& view, unsigned int playerId, Player& player, Player& enemy, Map::Topology topology) {
+    loadSnapshot(view.snapshot(), playerId, player, enemy);
+    return Map(view.getWidth(), view.getHeight(), view.getCells(), topology);
+}
+
+void submitSharedOrders(const std::string& orders) {
+    const char* name = std::getenv(sharedOrdersVariable);
+    if (!name || !*name) {
+        throw std::runtime_error("No orders ring is named in " + std::string(sharedOrdersVariable) + ".");
+    }
+
+    SharedOrderRing ring = SharedOrderRing::open(name);
+    std::istringstream lines(orders);
+    std::string line;
+    Order order;
+    while (std::getline(lines, line)) {
+        if (parseOrder(line, order)) {
+            ring.push(order);
+        }
+    }
+    ring.commit();
+}
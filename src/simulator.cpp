@@ -0,0 +1,160 @@
+#include "simulator.hpp"
+#include "zobrist.hpp"
+#include <algorithm>
+
+namespace {
+
+// Flipped into the hash at the end of every turn, when the other side gets to move
+const std::uint64_t otherSideToMoveKey = zobristStateKey(0, 1);
+
+}  // namespace
+
+Simulator::Simulator(const Map& map, const std::vector<Unit>& playerUnits, const std::vector<Unit>& enemyUnits,
+                     unsigned int playerGold, unsigned int enemyGold, bool roundEndingSide)
+    : map(&map), units{playerUnits, enemyUnits}, gold{playerGold, enemyGold}, nextUnitId(0), now(0),
+      roundEndingSide(roundEndingSide), influence(map.getWidth(), map.getHeight(), {&units[0], &units[1]}),
+      economy(std::make_shared<Economy>(map)) {
+    hash = zobristHash({&units[0], &units[1]});
+
+    // New units get IDs above every existing one
+    for (const auto& side : units) {
+        for (const Unit& unit : side) {
+            nextUnitId = std::max<unsigned short>(nextUnitId, unit.getId() + 1);
+        }
+    }
+}
+
+const Map& Simulator::getMap() const {
+    return *map;
+}
+
+const std::vector<Unit>& Simulator::getUnits(bool side) const {
+    return units[side];
+}
+
+unsigned int Simulator::getGold(bool side) const {
+    return gold[side];
+}
+
+const InfluenceOverlay& Simulator::getInfluenceMap() const {
+    return influence;
+}
+
+std::uint64_t Simulator::getHash() const {
+    return hash;
+}
+
+const Unit* Simulator::findUnit(bool side, unsigned short id) const {
+    for (const Unit& unit : units[side]) {
+        if (unit.getId() == id) {
+            return &unit;
+        }
+    }
+    return nullptr;
+}
+
+Unit* Simulator::findMutableUnit(bool side, unsigned short id) {
+    return const_cast<Unit*>(static_cast<const Simulator*>(this)->findUnit(side, id));
+}
+
+bool Simulator::applyOrder(bool side, const Order& order) {
+    Unit* unit = findMutableUnit(side, order.unitId);
+    if (!unit || unit->getHealth() == 0) {
+        return false;
+    }
+
+    try {
+        switch (order.action) {
+            case 'B': {
+                // The build is queued on the base if the side can pay for it, the unit is deployed when the scheduler completes it
+                auto type = unitTypeMap.find(order.unitType);
+                if (type == unitTypeMap.end()) {
+                    return false;
+                }
+                Unit newUnit(side, nextUnitId, type->second);
+                if (newUnit.getCost() > gold[side]) {
+                    return false;
+                }
+                scheduler.enqueueBuild(*unit, newUnit, now);
+                gold[side] -= newUnit.getCost();
+                ++nextUnitId;
+                return true;
+            }
+            case 'M': {
+                unsigned short fromX = unit->getPositionX();
+                unsigned short fromY = unit->getPositionY();
+                std::uint64_t key = zobristUnitKey(*unit);
+                unit->moveAction(order.x, order.y, units[!side], *map);
+                scheduler.scheduleReset(*unit, now);
+                influence.moveUnit(*unit, fromX, fromY);
+                hash ^= key ^ zobristUnitKey(*unit);
+                return true;
+            }
+            case 'A': {
+                // Destroyed units stop threatening cells right away, but are only removed at the end of the turn
+                const Unit* target = findUnit(!side, order.targetId);
+                bool wasAlive = target && target->getHealth() > 0;
+                std::uint64_t key = target ? zobristUnitKey(*target) : 0;
+                unit->attackAction(order.targetId, units[!side]);
+                scheduler.scheduleReset(*unit, now);
+                hash ^= key ^ zobristUnitKey(*target);
+                if (wasAlive && target->getHealth() == 0) {
+                    influence.removeUnit(*target);
+                }
+                return true;
+            }
+            default:
+                return false;
+        }
+    } catch (const std::runtime_error&) {
+        // The rules rejected the order
+        return false;
+    }
+}
+
+void Simulator::endTurn(bool side) {
+    // Remove destroyed units
+    for (auto& army : units) {
+        army.erase(std::remove_if(army.begin(), army.end(), [this](const Unit& unit) {
+            if (unit.getHealth() == 0) {
+                hash ^= zobristUnitKey(unit);
+                return true;
+            }
+            return false;
+        }), army.end());
+    }
+
+    // Start the next turn with the events scheduled for it, as the engine does
+    for (const ScheduledEvent& event : scheduler.advance(now + 1)) {
+        bool owner = event.owner != 0;
+        Unit* unit = findMutableUnit(owner, event.unitId);
+        if (event.type == ScheduledEvent::Type::Reset) {
+            if (unit) {
+                unit->reset();
+            }
+        } else if (event.type == ScheduledEvent::Type::BuildComplete) {
+            addUnit(owner, scheduler.completeBuild(event, unit));
+        }
+    }
+    ++now;
+
+    // Credit the income of both sides once per round
+    if (side == roundEndingSide) {
+        for (bool paid : {false, true}) {
+            gold[paid] += economy->computeIncome(units[paid]);
+        }
+    }
+    hash ^= otherSideToMoveKey;
+}
+
+bool Simulator::isBaseDestroyed(bool side) const {
+    return std::none_of(units[side].begin(), units[side].end(), [](const Unit& unit) { return unit.getName() == "Base"; });
+}
+
+void Simulator::addUnit(bool side, const std::optional<Unit>& unit) {
+    if (unit) {
+        units[side].push_back(*unit);
+        influence.addUnit(*unit);
+        hash ^= zobristUnitKey(*unit);
+    }
+}
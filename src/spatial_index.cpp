@@ -0,0 +1,169 @@
+#include "spatial_index.hpp"
+#include <algorithm>
+
+SpatialIndex::SpatialIndex(unsigned int width, unsigned int height, unsigned int cellSize)
+    : width(std::max(width, 1u)), height(std::max(height, 1u)), cellSize(std::max(cellSize, 1u)),
+      bucketsX((this->width + this->cellSize - 1) / this->cellSize),
+      bucketsY((this->height + this->cellSize - 1) / this->cellSize),
+      bucketStart(bucketsX * bucketsY + 1, 0), bucketOwners(bucketsX * bucketsY) {}
+
+unsigned int SpatialIndex::bucketOf(unsigned short x, unsigned short y) const {
+    // Units outside the map are kept in the closest bucket
+    unsigned int bx = std::min<unsigned int>(x, width - 1) / cellSize;
+    unsigned int by = std::min<unsigned int>(y, height - 1) / cellSize;
+    return by * bucketsX + bx;
+}
+
+void SpatialIndex::rebuild(const std::vector<const std::vector<Unit>*>& armies) {
+    byId.clear();
+    std::fill(bucketStart.begin(), bucketStart.end(), 0);
+    std::fill(bucketOwners.begin(), bucketOwners.end(), OwnerSet());
+    entries.clear();
+
+    // Count the units of every bucket and note their owners
+    for (const std::vector<Unit>* army : armies) {
+        for (const Unit& unit : *army) {
+            if (unit.getHealth() > 0) {
+                unsigned int bucket = bucketOf(unit.getPositionX(), unit.getPositionY());
+                ++bucketStart[bucket + 1];
+                bucketOwners[bucket] |= OwnerSet::of(unit.getOwner());
+            }
+        }
+    }
+
+    // Turn the counts into start indices and place every unit in its bucket
+    for (size_t bucket = 1; bucket < bucketStart.size(); ++bucket) {
+        bucketStart[bucket] += bucketStart[bucket - 1];
+    }
+    entries.resize(bucketStart.back());
+
+    std::vector<unsigned int> fill(bucketStart.begin(), bucketStart.end() - 1);
+    for (const std::vector<Unit>* army : armies) {
+        for (const Unit& unit : *army) {
+            if (unit.getHealth() == 0) {
+                continue;
+            }
+            Entry entry = {unit.getId(), unit.getPositionX(), unit.getPositionY(), unit.getOwner(), &unit};
+            entries[fill[bucketOf(entry.x, entry.y)]++] = entry;
+            byId[entry.id] = entry;
+        }
+    }
+}
+
+const SpatialIndex::Entry* SpatialIndex::find(unsigned short id) const {
+    auto it = byId.find(id);
+    return it == byId.end() ? nullptr : &it->second;
+}
+
+std::vector<SpatialIndex::Entry> SpatialIndex::withinRange(OwnerSet owners, unsigned short x, unsigned short y, unsigned short radius) const {
+    std::vector<Entry> result;
+
+    // Visit the buckets overlapping the bounding box of the diamond
+    unsigned int minX = x > radius ? x - radius : 0;
+    unsigned int minY = y > radius ? y - radius : 0;
+    unsigned int maxX = std::min<unsigned int>(x + radius, width - 1);
+    unsigned int maxY = std::min<unsigned int>(y + radius, height - 1);
+    if (minX > maxX || minY > maxY) {
+        return result;
+    }
+
+    for (unsigned int by = minY / cellSize; by <= maxY / cellSize; ++by) {
+        for (unsigned int bx = minX / cellSize; bx <= maxX / cellSize; ++bx) {
+            unsigned int bucket = by * bucketsX + bx;
+            if (!bucketOwners[bucket].intersects(owners)) {
+                continue;
+            }
+            for (unsigned int i = bucketStart[bucket]; i < bucketStart[bucket + 1]; ++i) {
+                const Entry& entry = entries[i];
+                if (owners.contains(entry.owner) && std::abs(entry.x - x) + std::abs(entry.y - y) <= radius) {
+                    result.push_back(entry);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<SpatialIndex::Entry> SpatialIndex::kNearest(OwnerSet owners, unsigned short x, unsigned short y, size_t k) const {
+    std::vector<std::pair<unsigned int, Entry>> found;
+    if (k == 0) {
+        return {};
+    }
+
+    auto byDistance = [](const std::pair<unsigned int, Entry>& a, const std::pair<unsigned int, Entry>& b) {
+        return a.first != b.first ? a.first < b.first : a.second.id < b.second.id;
+    };
+
+    // Visit square rings of buckets around the query bucket. Every unit beyond ring r is
+    // more than r * cellSize cells away, so the search stops once k units are closer.
+    int centerX = std::min<unsigned int>(x, width - 1) / cellSize;
+    int centerY = std::min<unsigned int>(y, height - 1) / cellSize;
+    int maxRing = std::max({centerX, centerY, static_cast<int>(bucketsX) - 1 - centerX, static_cast<int>(bucketsY) - 1 - centerY});
+
+    for (int ring = 0; ring <= maxRing; ++ring) {
+        for (int by = centerY - ring; by <= centerY + ring; ++by) {
+            if (by < 0 || by >= static_cast<int>(bucketsY)) {
+                continue;
+            }
+            // Rows inside the ring only contribute their two border buckets
+            int step = (by == centerY - ring || by == centerY + ring) ? 1 : std::max(1, 2 * ring);
+            for (int bx = centerX - ring; bx <= centerX + ring; bx += step) {
+                if (bx < 0 || bx >= static_cast<int>(bucketsX)) {
+                    continue;
+                }
+                unsigned int bucket = by * bucketsX + bx;
+                if (!bucketOwners[bucket].intersects(owners)) {
+                    continue;
+                }
+                for (unsigned int i = bucketStart[bucket]; i < bucketStart[bucket + 1]; ++i) {
+                    const Entry& entry = entries[i];
+                    if (!owners.contains(entry.owner)) {
+                        continue;
+                    }
+                    found.push_back({static_cast<unsigned int>(std::abs(entry.x - x) + std::abs(entry.y - y)), entry});
+                }
+            }
+        }
+
+        if (found.size() >= k) {
+            std::nth_element(found.begin(), found.begin() + (k - 1), found.end(), byDistance);
+            if (found[k - 1].first <= static_cast<unsigned int>(ring) * cellSize) {
+                break;
+            }
+        }
+    }
+
+    std::sort(found.begin(), found.end(), byDistance);
+    if (found.size() > k) {
+        found.resize(k);
+    }
+
+    std::vector<Entry> result;
+    for (const auto& [distance, entry] : found) {
+        result.push_back(entry);
+    }
+    return result;
+}
+
+bool SpatialIndex::isOccupied(OwnerSet owners, unsigned short x, unsigned short y) const {
+    if (x >= width || y >= height) {
+        return false;
+    }
+    unsigned int bucket = bucketOf(x, y);
+    if (!bucketOwners[bucket].intersects(owners)) {
+        return false;
+    }
+    for (unsigned int i = bucketStart[bucket]; i < bucketStart[bucket + 1]; ++i) {
+        const Entry& entry = entries[i];
+        if (entry.x == x && entry.y == y && owners.contains(entry.owner)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SpatialIndex::isWithinRange(unsigned short id, unsigned short x, unsigned short y, unsigned short radius) const {
+    const Entry* entry = find(id);
+    return entry && std::abs(entry->x - x) + std::abs(entry->y - y) <= radius;
+}
@@ -0,0 +1,210 @@
+#include "status.hpp"
+#include <array>
+#include <charconv>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+// One prototype per owner and unit type, so parsed units are copies instead of lookups by name
+struct PrototypeTable {
+    std::array<int, 256> slot;  // The index of the type of every initial, or -1
+    std::vector<Unit> units;    // The prototypes of every owner, one block of types per owner
+};
+
+const PrototypeTable& prototypes() {
+    static const PrototypeTable table = []() {
+        PrototypeTable result;
+        result.slot.fill(-1);
+        int typeCount = 0;
+        for (const auto& [initial, name] : unitTypeMap) {
+            result.slot[static_cast<unsigned char>(initial)] = typeCount++;
+        }
+        result.units.reserve(maxPlayers * typeCount);
+        for (unsigned int owner = 0; owner < maxPlayers; ++owner) {
+            for (const auto& [initial, name] : unitTypeMap) {
+                result.units.emplace_back(static_cast<OwnerId>(owner), 0, name);
+            }
+        }
+        return result;
+    }();
+    return table;
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Return the next whitespace-separated token of the line and advance past it
+std::string_view nextToken(std::string_view& line) {
+    size_t start = 0;
+    while (start < line.size() && isSpace(line[start])) {
+        ++start;
+    }
+    size_t end = start;
+    while (end < line.size() && !isSpace(line[end])) {
+        ++end;
+    }
+    std::string_view token = line.substr(start, end - start);
+    line.remove_prefix(end);
+    return token;
+}
+
+// Parse a whole token as a number that fits the type
+template <typename T>
+bool parseNumber(std::string_view token, T& value) {
+    auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+    return !token.empty() && error == std::errc() && end == token.data() + token.size();
+}
+
+// Parse the next token of the line as a number that fits the type
+template <typename T>
+bool nextNumber(std::string_view& line, T& value) {
+    return parseNumber(nextToken(line), value);
+}
+
+}  // namespace
+
+Unit makeStatusUnit(OwnerId owner, char initial, unsigned short id, unsigned short x, unsigned short y, unsigned short health) {
+    // Map the abbreviated unit type to its prototype
+    const PrototypeTable& table = prototypes();
+    int slot = table.slot[static_cast<unsigned char>(initial)];
+    if (slot < 0 || owner >= maxPlayers) {
+        throw std::runtime_error("Invalid unit type: " + std::string(1, initial));
+    }
+
+    Unit unit = table.units[owner * (table.units.size() / maxPlayers) + slot];
+    if (health > unit.getHealth()) {
+        throw std::runtime_error("Invalid unit health: " + std::to_string(health));
+    }
+    unit.setId(id);
+    unit.setPosition(x, y);
+    unit.takeDamage(unit.getHealth() - health);
+    return unit;
+}
+
+namespace {
+
+// Parse the gold line and the unit lines of a status, handing the units to the player
+// returned by receiverOf for their owner. Units of owners without a receiver are skipped.
+template <typename GoldHandler, typename Receiver>
+void parseStatusLines(std::string_view buffer, GoldHandler onGold, Receiver receiverOf) {
+    bool firstLine = true;
+
+    while (!buffer.empty()) {
+        // Cut the next line out of the buffer
+        size_t end = buffer.find('\n');
+        std::string_view line = buffer.substr(0, end);
+        buffer.remove_prefix(end == std::string_view::npos ? buffer.size() : end + 1);
+
+        // The first line contains the gold of every player, by player ID
+        if (firstLine) {
+            firstLine = false;
+            std::vector<unsigned int> gold;
+            for (std::string_view token = nextToken(line); !token.empty(); token = nextToken(line)) {
+                unsigned int value = 0;
+                if (!parseNumber(token, value)) {
+                    throw std::runtime_error("Invalid gold: " + std::string(token));
+                }
+                gold.push_back(value);
+            }
+            onGold(gold);
+            continue;
+        }
+
+        if (line.empty()) {
+            continue;
+        }
+
+        // Every field must be present and fit its type, bases may be followed by what they build.
+        // Lines of another format, such as the P and E sides of the old status, are rejected.
+        std::string_view fields = line;
+        unsigned int owner = 0;
+        unsigned short id = 0, x = 0, y = 0, health = 0;
+        bool valid = nextNumber(fields, owner) && owner < maxPlayers;
+        std::string_view unitType = nextToken(fields);
+        valid = valid && !unitType.empty() && nextNumber(fields, id) && nextNumber(fields, x) && nextNumber(fields, y) &&
+                nextNumber(fields, health);
+        if (!valid) {
+            throw std::runtime_error("Invalid status line: " + std::string(line));
+        }
+
+        Player* receiver = receiverOf(owner);
+        if (receiver) {
+            receiver->addUnitToPlayerUnits(makeStatusUnit(receiver->getID(), unitType[0], id, x, y, health));
+        }
+    }
+}
+
+}  // namespace
+
+void parseStatus(std::string_view buffer, unsigned int playerId, Player& player, Player& enemy) {
+    parseStatusLines(buffer,
+        [&](const std::vector<unsigned int>& gold) {
+            // A single value is the gold of every player, otherwise the enemy gets the gold of all the other players
+            if (gold.size() == 1) {
+                player.setGold(gold[0]);
+                enemy.setGold(gold[0]);
+            } else if (!gold.empty()) {
+                unsigned int enemyGold = 0;
+                for (size_t id = 0; id < gold.size(); ++id) {
+                    if (id == playerId) {
+                        player.setGold(gold[id]);
+                    } else {
+                        enemyGold += gold[id];
+                    }
+                }
+                enemy.setGold(enemyGold);
+            }
+        },
+        [&](unsigned int owner) { return owner == playerId ? &player : &enemy; });
+}
+
+void parseStatus(std::string_view buffer, const std::vector<Player*>& players) {
+    parseStatusLines(buffer,
+        [&](const std::vector<unsigned int>& gold) {
+            // A single value is the gold of every player, otherwise players without a value keep their gold
+            for (size_t id = 0; id < players.size(); ++id) {
+                if (gold.size() == 1 || id < gold.size()) {
+                    players[id]->setGold(gold[gold.size() == 1 ? 0 : id]);
+                }
+            }
+        },
+        [&](unsigned int owner) -> Player* {
+            if (owner >= players.size()) {
+                throw std::runtime_error("Invalid unit owner: " + std::to_string(owner));
+            }
+            return players[owner];
+        });
+}
+
+namespace {
+
+// Read a whole stream at once
+std::string readWholeStream(std::istream& statusFile) {
+    std::string buffer;
+    statusFile.seekg(0, std::ios::end);
+    std::streamoff size = statusFile.tellg();
+    if (size > 0) {
+        buffer.resize(static_cast<size_t>(size));
+        statusFile.seekg(0, std::ios::beg);
+        statusFile.read(buffer.data(), size);
+        buffer.resize(static_cast<size_t>(statusFile.gcount()));
+    } else {
+        // The stream cannot be measured, read it until the end instead
+        statusFile.clear();
+        statusFile.seekg(0, std::ios::beg);
+        buffer.assign(std::istreambuf_iterator<char>(statusFile), std::istreambuf_iterator<char>());
+    }
+    return buffer;
+}
+
+}  // namespace
+
+void readStatus(std::istream& statusFile, unsigned int playerId, Player& player, Player& enemy) {
+    parseStatus(readWholeStream(statusFile), playerId, player, enemy);
+}
+
+void readStatus(std::istream& statusFile, const std::vector<Player*>& players) {
+    parseStatus(readWholeStream(statusFile), players);
+}
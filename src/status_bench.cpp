@@ -0,0 +1,185 @@
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <functional>
+#include "status.hpp"
+
+// The status parser the bots used before parseStatus, reading every line through a string stream
+// and building every unit by name, for the two-sided view of playerId
+void parseStatusReference(const std::string& buffer, unsigned int playerId, Player& player, Player& enemy) {
+    std::istringstream statusStream(buffer);
+    std::string line;
+
+    // Read the first line containing the gold of every player
+    if (std::getline(statusStream, line)) {
+        std::istringstream iss(line);
+        std::vector<unsigned int> gold;
+        for (unsigned int value; iss >> value;) {
+            gold.push_back(value);
+        }
+        if (gold.size() == 1) {
+            player.setGold(gold[0]);
+            enemy.setGold(gold[0]);
+        } else if (!gold.empty()) {
+            unsigned int enemyGold = 0;
+            for (size_t id = 0; id < gold.size(); ++id) {
+                if (id == playerId) {
+                    player.setGold(gold[id]);
+                } else {
+                    enemyGold += gold[id];
+                }
+            }
+            enemy.setGold(enemyGold);
+        }
+    }
+
+    // Read the units of every player
+    std::string unitType;
+    unsigned int owner;
+    int id, x, y, hp;
+    while (std::getline(statusStream, line)) {
+        std::istringstream iss(line);
+        if (!(iss >> owner >> unitType >> id >> x >> y >> hp)) {
+            continue;
+        }
+
+        // Map the abbreviated unit type to the full name
+        if (unitTypeMap.find(unitType[0]) == unitTypeMap.end()) {
+            throw std::runtime_error("Invalid unit type: " + unitType);
+        }
+        Player& receiver = owner == playerId ? player : enemy;
+        Unit unit(receiver.getID(), id, unitTypeMap.at(unitType[0]));
+        unit.setPosition(x, y);
+        unit.takeDamage(unit.getHealth() - hp);
+        receiver.addUnitToPlayerUnits(unit);
+    }
+}
+
+// Generate a status with the given number of units spread over the players
+std::string generateStatus(unsigned int units, unsigned int players, std::mt19937& gen) {
+    std::vector<char> initials;
+    for (const auto& [initial, name] : unitTypeMap) {
+        initials.push_back(initial);
+    }
+    std::uniform_int_distribution<size_t> disType(0, initials.size() - 1);
+    std::uniform_int_distribution<unsigned int> disOwner(0, players - 1);
+    std::uniform_int_distribution<unsigned int> disPosition(0, 8191);
+    std::uniform_int_distribution<unsigned int> disGold(0, 100000);
+
+    std::string status;
+    for (unsigned int owner = 0; owner < players; ++owner) {
+        status += (owner > 0 ? " " : "") + std::to_string(disGold(gen));
+    }
+    status += '\n';
+    for (unsigned int id = 0; id < units; ++id) {
+        char initial = initials[disType(gen)];
+        unsigned short maxHealth = Unit(0, 0, unitTypeMap.at(initial)).getHealth();
+        std::uniform_int_distribution<unsigned int> disHealth(1, maxHealth);
+        // IDs wrap around past the largest unit ID, the parsers do not need them to be unique
+        status += std::to_string(disOwner(gen)) + ' ' + initial + ' ' + std::to_string(id % 65536) + ' ' + std::to_string(disPosition(gen)) +
+                  ' ' + std::to_string(disPosition(gen)) + ' ' + std::to_string(disHealth(gen));
+        if (initial == 'B') {
+            status += " 0";
+        }
+        status += '\n';
+    }
+    return status;
+}
+
+// Check that both parsers give the same gold and the same units, field by field
+bool sameArmies(Player& expected, Player& actual) {
+    if (expected.getGold() != actual.getGold() || expected.getPlayerUnits().size() != actual.getPlayerUnits().size()) {
+        return false;
+    }
+    for (size_t index = 0; index < expected.getPlayerUnits().size(); ++index) {
+        const Unit& a = expected.getPlayerUnits()[index];
+        const Unit& b = actual.getPlayerUnits()[index];
+        if (a.getOwner() != b.getOwner() || a.getId() != b.getId() || a.getName() != b.getName() ||
+            a.getPositionX() != b.getPositionX() || a.getPositionY() != b.getPositionY() || a.getHealth() != b.getHealth()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check that every malformed unit line is rejected instead of parsed
+bool rejectsMalformedLines() {
+    const std::vector<std::string> lines = {
+        "0 W 1 2 3",         // Missing health
+        "0 W 1 2",           // Missing position
+        "0",                 // Missing everything but the owner
+        "0 W x 2 3 10",      // ID is not a number
+        "0 W 1 2 3 10x",     // Trailing garbage in a number
+        "0 W 1 70000 3 10",  // Position out of range
+        "0 W 1 2 3 -1",      // Negative health
+        "0 W 1 2 3 60000",   // Health above the maximum of the type
+        "99 W 1 2 3 10",     // Owner out of range
+        "0 Z 1 2 3 10",      // Unknown type
+        "P W 1 2 3 10",      // Side of the old format instead of an owner ID
+        "E B 2 4 4 200 0",   // Side of the old format on a base
+    };
+    for (const std::string& line : lines) {
+        Player player(0, "Player 1", 0);
+        Player enemy(1, "Player 2", 0);
+        try {
+            parseStatus("100 100\n0 W 7 1 1 10\n" + line + "\n", 0, player, enemy);
+            std::cout << "Accepted malformed line: " << line << std::endl;
+            return false;
+        } catch (const std::runtime_error&) {
+        }
+    }
+    return true;
+}
+
+// Run the parser repeatedly and return the throughput in lines per second
+double measure(const std::function<void(Player&, Player&)>& parse, unsigned int lines, int runs) {
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run) {
+        Player player(0, "Player 1", 0);
+        Player enemy(1, "Player 2", 0);
+        parse(player, enemy);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(lines) * runs / elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    unsigned int units = 200000;
+    int runs = 5;
+
+    if (argc > 1) {
+        units = std::stoi(argv[1]);
+    }
+    if (argc > 2) {
+        runs = std::stoi(argv[2]);
+    }
+
+    std::mt19937 gen(42);
+    std::cout << "Units: " << units << ", runs: " << runs << std::endl;
+
+    bool allMatch = true;
+    for (unsigned int players : {2u, 4u, maxPlayers}) {
+        std::string status = generateStatus(units, players, gen);
+        bool match = true;
+        for (unsigned int playerId = 0; playerId < players; ++playerId) {
+            Player expectedPlayer(0, "Player 1", 0), expectedEnemy(1, "Player 2", 0);
+            Player actualPlayer(0, "Player 1", 0), actualEnemy(1, "Player 2", 0);
+            parseStatusReference(status, playerId, expectedPlayer, expectedEnemy);
+            parseStatus(status, playerId, actualPlayer, actualEnemy);
+            match = match && sameArmies(expectedPlayer, actualPlayer) && sameArmies(expectedEnemy, actualEnemy);
+        }
+        allMatch = allMatch && match;
+
+        double reference = measure([&](Player& player, Player& enemy) { parseStatusReference(status, 0, player, enemy); }, units, runs);
+        double single = measure([&](Player& player, Player& enemy) { parseStatus(status, 0, player, enemy); }, units, runs);
+
+        std::cout << players << " players: reference " << reference / 1e6 << " Mlines/s, single pass " << single / 1e6
+                  << " Mlines/s, speedup " << single / reference << "x, armies " << (match ? "match" : "DIFFER") << std::endl;
+    }
+
+    bool rejected = rejectsMalformedLines();
+    std::cout << "Malformed lines: " << (rejected ? "rejected" : "ACCEPTED") << std::endl;
+
+    return allMatch && rejected ? 0 : 1;
+}
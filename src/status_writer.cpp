@@ -0,0 +1,140 @@
+#include "status_writer.hpp"
+#include <charconv>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// Append a number formatted with std::to_chars
+void appendNumber(std::string& buffer, unsigned int value) {
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr);
+}
+
+void appendUnits(std::string& buffer, Player& owner, const TurnScheduler& scheduler) {
+    for (const Unit& unit : owner.getPlayerUnits()) {
+        appendNumber(buffer, owner.getID());
+        buffer += ' ';
+        buffer += unit.getInitial();
+        buffer += ' ';
+        appendNumber(buffer, unit.getId());
+        buffer += ' ';
+        appendNumber(buffer, unit.getPositionX());
+        buffer += ' ';
+        appendNumber(buffer, unit.getPositionY());
+        buffer += ' ';
+        appendNumber(buffer, unit.getHealth());
+        if (unit.getInitial() == 'B') {
+            const Unit* creation = scheduler.getCurrentBuild(unit.getId());
+            buffer += ' ';
+            buffer += creation ? creation->getInitial() : '0';
+        }
+        buffer += '\n';
+    }
+}
+
+}  // namespace
+
+void serializeStatus(std::string& buffer, const std::vector<Player*>& players, const TurnScheduler& scheduler) {
+    buffer.clear();
+    for (size_t index = 0; index < players.size(); ++index) {
+        if (index > 0) {
+            buffer += ' ';
+        }
+        appendNumber(buffer, players[index]->getGold());
+    }
+    buffer += '\n';
+    for (Player* player : players) {
+        appendUnits(buffer, *player, scheduler);
+    }
+}
+
+StatusWriter::StatusWriter(const std::filesystem::path& path)
+    : path(path), temporaryPath(path.string() + ".tmp"), back(0), pending(false), stopping(false) {
+    thread = std::thread(&StatusWriter::run, this);
+}
+
+StatusWriter::~StatusWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+}
+
+std::string& StatusWriter::getBackBuffer() {
+    return buffers[back];
+}
+
+void StatusWriter::publish() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() { return !pending; });
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+
+    // The filled back buffer becomes the front buffer, and the written front buffer is reused
+    back = 1 - back;
+    pending = true;
+    lock.unlock();
+    changed.notify_all();
+}
+
+void StatusWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() { return !pending; });
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
+
+void StatusWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this]() { return pending || stopping; });
+        if (!pending) {
+            return;
+        }
+
+        // The front buffer is not touched by the mediator while a write is pending
+        const std::string& front = buffers[1 - back];
+        lock.unlock();
+        writeSnapshot(front);
+        lock.lock();
+
+        pending = false;
+        changed.notify_all();
+    }
+}
+
+void StatusWriter::writeSnapshot(const std::string& contents) {
+    int file = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool written = file >= 0;
+
+    // A single write normally covers the whole snapshot, the loop only handles short writes
+    size_t offset = 0;
+    while (written && offset < contents.size()) {
+        ssize_t count = ::write(file, contents.data() + offset, contents.size() - offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        written = count > 0;
+        offset += written ? static_cast<size_t>(count) : 0;
+    }
+    if (file >= 0 && ::close(file) != 0) {
+        written = false;
+    }
+
+    if (!written || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::string reason = std::strerror(errno);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error.empty()) {
+            error = "Failed to write the status file " + path.string() + ": " + reason;
+        }
+    }
+}
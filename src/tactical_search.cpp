@@ -0,0 +1,476 @@
+#include "tactical_search.hpp"
+#include "zobrist.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+// Kinds of state hashed next to the units
+const std::uint32_t sideToMoveKind = 1;
+const std::uint32_t actingUnitKind = 2;
+
+// A base is worth far more than its health, losing it loses the match
+const int baseValue = 1000;
+const int infinity = std::numeric_limits<int>::max() / 2;
+
+// The action of one unit: a move, an attack, both or neither
+struct Action {
+    bool moves = false;
+    unsigned short x = 0;
+    unsigned short y = 0;
+    bool attacks = false;
+    unsigned short targetId = 0;
+    int priority = 0;   // Higher is searched first
+};
+
+bool canAct(const Unit& unit) {
+    return unit.getHealth() > 0 && unit.getName() != "Base";
+}
+
+int unitValue(const Unit& unit) {
+    if (unit.getHealth() == 0) {
+        return 0;
+    }
+    return unit.getHealth() + unit.getCost() + (unit.getName() == "Base" ? baseValue : 0);
+}
+
+// A position of the search. The hash covers the units, the side to move and the unit about to act.
+class State {
+public:
+    std::vector<Unit> units[2];
+    bool side = false;
+    size_t acting = 0;
+    std::uint64_t hash = 0;
+
+    explicit State(const Skirmish& skirmish) : units{skirmish.units[0], skirmish.units[1]} {
+        hash = zobristHash({&units[0], &units[1]}) ^ zobristStateKey(sideToMoveKind, side) ^
+               zobristStateKey(actingUnitKind, static_cast<std::uint32_t>(acting));
+        skipIdleSides();
+    }
+
+    bool isOver() const {
+        return !hasActingUnit(false) && !hasActingUnit(true);
+    }
+
+    const Unit& actingUnit() const {
+        return units[side][acting];
+    }
+
+    // The material balance for the side to move
+    int evaluate() const {
+        int balance = 0;
+        for (const Unit& unit : units[side]) {
+            balance += unitValue(unit);
+        }
+        for (const Unit& unit : units[!side]) {
+            balance -= unitValue(unit);
+        }
+        return balance;
+    }
+
+    // Carry out an action of the acting unit with the engine's rules and pass the turn on.
+    // Returns false if the rules reject the action.
+    bool apply(const Action& action, const Map& map) {
+        Unit& unit = units[side][acting];
+        std::vector<Unit>& enemies = units[!side];
+        try {
+            if (action.moves) {
+                std::uint64_t key = zobristUnitKey(unit);
+                unit.moveAction(action.x, action.y, enemies, map);
+                hash ^= key ^ zobristUnitKey(unit);
+            }
+            if (action.attacks) {
+                auto target = std::find_if(enemies.begin(), enemies.end(), [&](const Unit& enemy) { return enemy.getId() == action.targetId; });
+                if (target == enemies.end() || target->getHealth() == 0) {
+                    return false;
+                }
+                std::uint64_t key = zobristUnitKey(*target);
+                unit.attackAction(action.targetId, enemies);
+                hash ^= key ^ zobristUnitKey(*target);
+            }
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+        advance();
+        return true;
+    }
+
+private:
+    bool hasActingUnit(bool whichSide) const {
+        return std::any_of(units[whichSide].begin(), units[whichSide].end(), canAct);
+    }
+
+    void setActing(bool newSide, size_t newActing) {
+        hash ^= zobristStateKey(sideToMoveKind, side) ^ zobristStateKey(actingUnitKind, static_cast<std::uint32_t>(acting));
+        side = newSide;
+        acting = newActing;
+        hash ^= zobristStateKey(sideToMoveKind, side) ^ zobristStateKey(actingUnitKind, static_cast<std::uint32_t>(acting));
+    }
+
+    // Move on to the next unit of the side, or end the turn of the side once all have acted
+    void advance() {
+        size_t next = acting + 1;
+        while (next < units[side].size() && !canAct(units[side][next])) {
+            ++next;
+        }
+        if (next < units[side].size()) {
+            setActing(side, next);
+        } else {
+            endTurn();
+        }
+    }
+
+    // As the engine does: destroyed units are removed and the units of the side are made ready again
+    void endTurn() {
+        for (auto& army : units) {
+            army.erase(std::remove_if(army.begin(), army.end(), [this](const Unit& unit) {
+                if (unit.getHealth() == 0) {
+                    hash ^= zobristUnitKey(unit);
+                    return true;
+                }
+                return false;
+            }), army.end());
+        }
+        for (Unit& unit : units[side]) {
+            unit.reset();
+        }
+        setActing(!side, 0);
+        skipIdleSides();
+    }
+
+    // Point at the first unit able to act, passing the turn of a side that has none
+    void skipIdleSides() {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            auto first = std::find_if(units[side].begin(), units[side].end(), canAct);
+            if (first != units[side].end()) {
+                setActing(side, first - units[side].begin());
+                return;
+            }
+            for (Unit& unit : units[side]) {
+                unit.reset();
+            }
+            setActing(!side, 0);
+        }
+    }
+};
+
+// Candidate actions of the acting unit, in a fixed order so a move index identifies the same action
+std::vector<Action> generateActions(const State& state, const Map& map) {
+    const Unit& unit = state.actingUnit();
+    const std::vector<Unit>& enemies = state.units[!state.side];
+    int x = unit.getPositionX();
+    int y = unit.getPositionY();
+    int speed = unit.getSpeed();
+
+    auto nearestEnemy = [&](int cellX, int cellY) {
+        int nearest = infinity;
+        for (const Unit& enemy : enemies) {
+            if (enemy.getHealth() > 0) {
+                nearest = std::min(nearest, std::abs(enemy.getPositionX() - cellX) + std::abs(enemy.getPositionY() - cellY));
+            }
+        }
+        return nearest;
+    };
+    auto isFree = [&](int cellX, int cellY) {
+        if (cellX < 0 || cellY < 0 || cellX >= static_cast<int>(map.getWidth()) || cellY >= static_cast<int>(map.getHeight()) ||
+            map.getCell(cellX, cellY) == '9') {
+            return false;
+        }
+        return std::none_of(enemies.begin(), enemies.end(),
+                            [&](const Unit& enemy) { return enemy.getPositionX() == cellX && enemy.getPositionY() == cellY; });
+    };
+
+    // Candidate cells: stay, close in keeping a point of speed to attack, close in as far as possible, fall back
+    std::vector<std::pair<int, int>> cells = {{x, y}};
+    std::pair<int, int> closeAttack = {x, y}, closeFull = {x, y}, fallBack = {x, y};
+    int closeAttackDistance = nearestEnemy(x, y), closeFullDistance = closeAttackDistance, fallBackDistance = closeAttackDistance;
+    for (int dy = -speed; dy <= speed; ++dy) {
+        for (int dx = -(speed - std::abs(dy)); dx <= speed - std::abs(dy); ++dx) {
+            int cellX = x + dx;
+            int cellY = y + dy;
+            if ((dx == 0 && dy == 0) || !isFree(cellX, cellY)) {
+                continue;
+            }
+            int distance = nearestEnemy(cellX, cellY);
+            int steps = std::abs(dx) + std::abs(dy);
+            if (steps < speed && distance < closeAttackDistance) {
+                closeAttack = {cellX, cellY};
+                closeAttackDistance = distance;
+            }
+            if (distance < closeFullDistance) {
+                closeFull = {cellX, cellY};
+                closeFullDistance = distance;
+            }
+            if (distance > fallBackDistance) {
+                fallBack = {cellX, cellY};
+                fallBackDistance = distance;
+            }
+        }
+    }
+    for (const auto& cell : {closeAttack, closeFull, fallBack}) {
+        if (std::find(cells.begin(), cells.end(), cell) == cells.end()) {
+            cells.push_back(cell);
+        }
+    }
+
+    std::vector<Action> actions;
+    for (const auto& [cellX, cellY] : cells) {
+        Action move;
+        move.moves = cellX != x || cellY != y;
+        move.x = cellX;
+        move.y = cellY;
+        int steps = std::abs(cellX - x) + std::abs(cellY - y);
+        actions.push_back(move);
+
+        // An attack costs a point of speed
+        if (steps >= speed) {
+            continue;
+        }
+        for (const Unit& enemy : enemies) {
+            if (enemy.getHealth() == 0 || std::abs(enemy.getPositionX() - cellX) + std::abs(enemy.getPositionY() - cellY) > unit.getAttackRange()) {
+                continue;
+            }
+            Action attack = move;
+            attack.attacks = true;
+            attack.targetId = enemy.getId();
+            int damage = std::min<int>(unit.calculateDamage(enemy), enemy.getHealth());
+            attack.priority = damage == enemy.getHealth() ? 2 * baseValue + unitValue(enemy) : baseValue + damage;
+            actions.push_back(attack);
+        }
+    }
+    return actions;
+}
+
+class Searcher {
+public:
+    Searcher(const Map& map, TranspositionTable& table, size_t nodeLimit, const CancellationToken& token, unsigned int firstTurnPlies)
+        : map(map), table(table), nodeLimit(nodeLimit), token(token), firstTurnPlies(firstTurnPlies) {}
+
+    size_t nodes = 0;
+    bool aborted = false;
+    TranspositionStatistics statistics;
+
+    // Negamax alpha-beta. The value is for the side to move, and a child with the same side to
+    // move keeps the window and the sign. The first turn of the searching side never takes a
+    // cutoff from the table, so its principal variation is complete.
+    int search(const State& state, unsigned int depth, int alpha, int beta, unsigned int ply, std::vector<Action>& line) {
+        line.clear();
+        if (++nodes >= nodeLimit || ((nodes & 1023) == 0 && token.isCancelled())) {
+            aborted = true;
+            return 0;
+        }
+        if (depth == 0 || state.isOver()) {
+            return state.evaluate();
+        }
+
+        int originalAlpha = alpha;
+        int tableMove = -1;
+        TranspositionEntry entry;
+        if (table.probe(state.hash, entry, statistics)) {
+            tableMove = entry.bestMove;
+            if (entry.depth >= depth && ply >= firstTurnPlies) {
+                if (entry.bound == TranspositionEntry::Bound::Exact) {
+                    return entry.value;
+                }
+                if (entry.bound == TranspositionEntry::Bound::Lower) {
+                    alpha = std::max(alpha, static_cast<int>(entry.value));
+                } else if (entry.bound == TranspositionEntry::Bound::Upper) {
+                    beta = std::min(beta, static_cast<int>(entry.value));
+                }
+                if (alpha >= beta) {
+                    return entry.value;
+                }
+            }
+        }
+
+        std::vector<Action> actions = generateActions(state, map);
+        std::vector<size_t> order(actions.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            if ((static_cast<int>(a) == tableMove) != (static_cast<int>(b) == tableMove)) {
+                return static_cast<int>(a) == tableMove;
+            }
+            return actions[a].priority > actions[b].priority;
+        });
+
+        int best = -infinity;
+        size_t bestIndex = 0;
+        std::vector<Action> childLine;
+        for (size_t index : order) {
+            State child = state;
+            if (!child.apply(actions[index], map)) {
+                continue;
+            }
+            int value = child.side == state.side ? search(child, depth - 1, alpha, beta, ply + 1, childLine)
+                                                 : -search(child, depth - 1, -beta, -alpha, ply + 1, childLine);
+            if (aborted) {
+                return 0;
+            }
+            if (value > best) {
+                best = value;
+                bestIndex = index;
+                line.assign(1, actions[index]);
+                line.insert(line.end(), childLine.begin(), childLine.end());
+            }
+            alpha = std::max(alpha, value);
+            if (alpha >= beta) {
+                break;
+            }
+        }
+
+        TranspositionEntry result;
+        result.value = best;
+        result.depth = static_cast<std::uint8_t>(std::min(depth, 255u));
+        result.bound = best <= originalAlpha ? TranspositionEntry::Bound::Upper
+                     : best >= beta          ? TranspositionEntry::Bound::Lower
+                                             : TranspositionEntry::Bound::Exact;
+        result.bestMove = static_cast<std::uint8_t>(std::min<size_t>(bestIndex, 255));
+        table.store(state.hash, result, statistics);
+        return best;
+    }
+
+private:
+    const Map& map;
+    TranspositionTable& table;
+    size_t nodeLimit;
+    const CancellationToken& token;
+    unsigned int firstTurnPlies;
+};
+
+}  // namespace
+
+TacticalSearch::TacticalSearch(const Map& map, TranspositionTable& table, unsigned int maxDepth, size_t nodeLimit)
+    : map(map), table(table), maxDepth(maxDepth), nodeLimit(nodeLimit) {
+}
+
+TacticalResult TacticalSearch::search(const Skirmish& skirmish, const CancellationToken& token) const {
+    TraceSpan span("TacticalSearch::search", "bot", "units", skirmish.units[0].size() + skirmish.units[1].size());
+    TacticalResult result;
+    State root(skirmish);
+    if (root.isOver() || root.side != false) {
+        return result;
+    }
+
+    // The plies of the first turn of side 0 are the orders being searched for
+    std::vector<unsigned short> actingIds;
+    for (const Unit& unit : skirmish.units[0]) {
+        if (canAct(unit)) {
+            actingIds.push_back(unit.getId());
+        }
+    }
+
+    Searcher searcher(map, table, nodeLimit, token, actingIds.size());
+    std::vector<Action> line;
+    for (unsigned int depth = 1; depth <= maxDepth; ++depth) {
+        int value = searcher.search(root, depth, -infinity, infinity, 0, line);
+        if (searcher.aborted) {
+            break;
+        }
+
+        // Keep the orders of the deepest completed iteration
+        result = TacticalResult();
+        result.value = value;
+        result.depth = depth;
+        for (size_t ply = 0; ply < line.size() && ply < actingIds.size(); ++ply) {
+            const Action& action = line[ply];
+            result.unitIds.push_back(actingIds[ply]);
+            if (action.moves) {
+                Order order;
+                order.unitId = actingIds[ply];
+                order.action = 'M';
+                order.x = action.x;
+                order.y = action.y;
+                result.orders.push_back(order);
+            }
+            if (action.attacks) {
+                Order order;
+                order.unitId = actingIds[ply];
+                order.action = 'A';
+                order.targetId = action.targetId;
+                result.orders.push_back(order);
+            }
+        }
+    }
+    result.nodes = searcher.nodes;
+    result.statistics = searcher.statistics;
+    table.addStatistics(searcher.statistics);
+    return result;
+}
+
+std::vector<Skirmish> findSkirmishes(const std::vector<Unit>& units, const SpatialIndex& enemyIndex, OwnerSet enemies,
+                                     size_t maxUnitsPerSide) {
+    // Find the engaged units and the enemies each of them can reach this turn
+    std::vector<size_t> engaged;
+    std::vector<std::vector<SpatialIndex::Entry>> reach;
+    for (size_t index = 0; index < units.size(); ++index) {
+        const Unit& unit = units[index];
+        if (unit.getHealth() == 0 || unit.getName() == "Base" || unit.getName() == "Worker") {
+            continue;
+        }
+        std::vector<SpatialIndex::Entry> inReach = enemyIndex.withinRange(enemies, unit.getPositionX(), unit.getPositionY(),
+                                                                          unit.getSpeed() + unit.getAttackRange());
+        if (!inReach.empty()) {
+            engaged.push_back(index);
+            reach.push_back(std::move(inReach));
+        }
+    }
+
+    // Join engaged units sharing an enemy
+    std::vector<size_t> group(engaged.size());
+    std::iota(group.begin(), group.end(), 0);
+    auto find = [&](size_t index) {
+        while (group[index] != index) {
+            group[index] = group[group[index]];
+            index = group[index];
+        }
+        return index;
+    };
+    std::unordered_map<unsigned short, size_t> firstReacher;
+    for (size_t index = 0; index < engaged.size(); ++index) {
+        for (const SpatialIndex::Entry& entry : reach[index]) {
+            auto [it, inserted] = firstReacher.emplace(entry.id, index);
+            if (!inserted) {
+                size_t a = find(index);
+                size_t b = find(it->second);
+                group[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+
+    // Collect the units of every group, in ID order on both sides
+    std::unordered_map<size_t, size_t> skirmishOf;
+    std::vector<Skirmish> skirmishes;
+    std::vector<std::vector<const Unit*>> enemyUnits;
+    for (size_t index = 0; index < engaged.size(); ++index) {
+        auto [it, inserted] = skirmishOf.emplace(find(index), skirmishes.size());
+        if (inserted) {
+            skirmishes.emplace_back();
+            enemyUnits.emplace_back();
+        }
+        skirmishes[it->second].units[0].push_back(units[engaged[index]]);
+        for (const SpatialIndex::Entry& entry : reach[index]) {
+            enemyUnits[it->second].push_back(entry.unit);
+        }
+    }
+
+    std::vector<Skirmish> result;
+    auto byId = [](const Unit& a, const Unit& b) { return a.getId() < b.getId(); };
+    for (size_t index = 0; index < skirmishes.size(); ++index) {
+        std::vector<const Unit*>& reached = enemyUnits[index];
+        std::sort(reached.begin(), reached.end(), [](const Unit* a, const Unit* b) { return a->getId() < b->getId(); });
+        reached.erase(std::unique(reached.begin(), reached.end()), reached.end());
+        if (skirmishes[index].units[0].size() > maxUnitsPerSide || reached.size() > maxUnitsPerSide) {
+            continue;
+        }
+        for (const Unit* enemy : reached) {
+            skirmishes[index].units[1].push_back(*enemy);
+        }
+        std::sort(skirmishes[index].units[0].begin(), skirmishes[index].units[0].end(), byId);
+        result.push_back(std::move(skirmishes[index]));
+    }
+    return result;
+}
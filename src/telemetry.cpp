@@ -0,0 +1,331 @@
+#include "telemetry.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+const char telemetryMagic[4] = {'S', 'K', 'T', 'L'};
+const char footerMagic[4] = {'S', 'K', 'T', 'F'};
+const std::uint64_t telemetryVersion = 1;
+// The tail holds the offset of the footer and the footer magic
+const std::streamoff tailSize = 8 + 4;
+
+const std::vector<std::string> columnNames = {"time", "owner", "unit", "type", "x", "y", "health", "damage", "orders"};
+const std::vector<TelemetryEncoding> columnEncodings = {
+    TelemetryEncoding::Delta, TelemetryEncoding::Varint, TelemetryEncoding::Varint,
+    TelemetryEncoding::Dictionary, TelemetryEncoding::Delta, TelemetryEncoding::Delta,
+    TelemetryEncoding::Varint, TelemetryEncoding::Varint, TelemetryEncoding::Dictionary
+};
+
+void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void putFixed64(std::string& out, std::uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        out += static_cast<char>(value >> shift);
+    }
+}
+
+// Chunks are decoded from memory, a cursor walks through them
+struct Cursor {
+    const std::string& data;
+    size_t position;
+
+    std::uint8_t byte() {
+        if (position >= data.size()) {
+            throw std::runtime_error("Unexpected end of a telemetry chunk.");
+        }
+        return static_cast<std::uint8_t>(data[position++]);
+    }
+
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t next = byte();
+            value |= static_cast<std::uint64_t>(next & 0x7F) << shift;
+            if (!(next & 0x80)) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Invalid varint in the telemetry file.");
+    }
+
+    std::uint64_t fixed64() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 8) {
+            value |= static_cast<std::uint64_t>(byte()) << shift;
+        }
+        return value;
+    }
+
+    std::string bytes(size_t length) {
+        if (data.size() - position < length) {
+            throw std::runtime_error("Unexpected end of a telemetry chunk.");
+        }
+        position += length;
+        return data.substr(position - length, length);
+    }
+};
+
+void encodeVarints(std::string& out, const std::vector<std::uint64_t>& values) {
+    for (std::uint64_t value : values) {
+        putVarint(out, value);
+    }
+}
+
+// Differences are zigzag encoded so that small negative steps stay short
+void encodeDeltas(std::string& out, const std::vector<std::uint64_t>& values) {
+    std::uint64_t previous = 0;
+    for (std::uint64_t value : values) {
+        std::int64_t delta = static_cast<std::int64_t>(value - previous);
+        putVarint(out, (static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63));
+        previous = value;
+    }
+}
+
+void encodeDictionary(std::string& out, const std::vector<std::string>& values) {
+    std::unordered_map<std::string, std::uint64_t> codes;
+    std::vector<const std::string*> dictionary;
+    std::string indices;
+    for (const std::string& value : values) {
+        auto [entry, inserted] = codes.emplace(value, dictionary.size());
+        if (inserted) {
+            dictionary.push_back(&entry->first);
+        }
+        putVarint(indices, entry->second);
+    }
+    putVarint(out, dictionary.size());
+    for (const std::string* entry : dictionary) {
+        putVarint(out, entry->size());
+        out += *entry;
+    }
+    out += indices;
+}
+
+size_t columnIndex(const std::string& column) {
+    auto found = std::find(columnNames.begin(), columnNames.end(), column);
+    if (found == columnNames.end()) {
+        throw std::runtime_error("Unknown telemetry column " + column + ".");
+    }
+    return found - columnNames.begin();
+}
+
+}  // namespace
+
+TelemetryWriter::TelemetryWriter(const std::string& path, size_t rowGroupSize)
+    : file(path, std::ios::binary | std::ios::trunc), rowGroupSize(std::max<size_t>(rowGroupSize, 1)), rowGroupCount(0), closed(false) {
+    if (!file) {
+        throw std::runtime_error("Failed to create the telemetry file " + path + ".");
+    }
+    std::string header(telemetryMagic, sizeof(telemetryMagic));
+    putVarint(header, telemetryVersion);
+    putVarint(header, columnNames.size());
+    for (size_t column = 0; column < columnNames.size(); ++column) {
+        putVarint(header, columnNames[column].size());
+        header += columnNames[column];
+        header += static_cast<char>(columnEncodings[column]);
+    }
+    file.write(header.data(), header.size());
+}
+
+TelemetryWriter::~TelemetryWriter() {
+    try {
+        close();
+    } catch (const std::runtime_error&) {
+        // Nothing more can be done about telemetry that cannot be finished
+    }
+}
+
+void TelemetryWriter::addRow(const TelemetryRow& row) {
+    times.push_back(row.time);
+    owners.push_back(row.owner);
+    unitIds.push_back(row.unitId);
+    types.push_back(row.type);
+    xs.push_back(row.x);
+    ys.push_back(row.y);
+    healths.push_back(row.health);
+    damages.push_back(row.damage);
+    orders.push_back(row.orders);
+    if (times.size() >= rowGroupSize) {
+        flushRowGroup();
+    }
+}
+
+void TelemetryWriter::flushRowGroup() {
+    if (times.empty()) {
+        return;
+    }
+
+    // Every column is encoded into its own chunk and its location noted in the footer
+    std::string chunk;
+    putVarint(footer, static_cast<std::uint64_t>(file.tellp()));
+    putVarint(footer, times.size());
+    auto writeChunk = [&]() {
+        putVarint(footer, chunk.size());
+        file.write(chunk.data(), chunk.size());
+        chunk.clear();
+    };
+    encodeDeltas(chunk, times);
+    writeChunk();
+    encodeVarints(chunk, owners);
+    writeChunk();
+    encodeVarints(chunk, unitIds);
+    writeChunk();
+    encodeDictionary(chunk, types);
+    writeChunk();
+    encodeDeltas(chunk, xs);
+    writeChunk();
+    encodeDeltas(chunk, ys);
+    writeChunk();
+    encodeVarints(chunk, healths);
+    writeChunk();
+    encodeVarints(chunk, damages);
+    writeChunk();
+    encodeDictionary(chunk, orders);
+    writeChunk();
+    ++rowGroupCount;
+
+    times.clear();
+    owners.clear();
+    unitIds.clear();
+    types.clear();
+    xs.clear();
+    ys.clear();
+    healths.clear();
+    damages.clear();
+    orders.clear();
+}
+
+void TelemetryWriter::close() {
+    if (closed) {
+        return;
+    }
+    closed = true;
+    flushRowGroup();
+
+    std::string trailer;
+    std::uint64_t footerOffset = static_cast<std::uint64_t>(file.tellp());
+    putVarint(trailer, rowGroupCount);
+    trailer += footer;
+    putFixed64(trailer, footerOffset);
+    trailer.append(footerMagic, sizeof(footerMagic));
+    file.write(trailer.data(), trailer.size());
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write the telemetry file.");
+    }
+}
+
+TelemetryReader::TelemetryReader(const std::string& path) : file(path, std::ios::binary) {
+    if (!file) {
+        throw std::runtime_error("Failed to open the telemetry file " + path + ".");
+    }
+
+    std::string tail(tailSize, '\0');
+    char magic[4];
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, telemetryMagic)
+        || !file.seekg(-tailSize, std::ios::end) || !file.read(&tail[0], tailSize)
+        || !std::equal(tail.end() - 4, tail.end(), footerMagic)) {
+        throw std::runtime_error(path + " is not a finished telemetry file.");
+    }
+    std::uint64_t footerOffset = Cursor{tail, 0}.fixed64();
+    std::uint64_t footerEnd = static_cast<std::uint64_t>(file.tellg()) - tailSize;
+    if (footerOffset > footerEnd) {
+        throw std::runtime_error(path + " has a corrupted footer.");
+    }
+
+    // The header is not needed: the columns of this version are known
+    std::string footer(footerEnd - footerOffset, '\0');
+    file.seekg(footerOffset);
+    file.read(&footer[0], footer.size());
+    Cursor cursor{footer, 0};
+    rowGroups.resize(cursor.varint());
+    for (RowGroup& rowGroup : rowGroups) {
+        std::uint64_t offset = cursor.varint();
+        rowGroup.rowCount = cursor.varint();
+        rowGroup.chunks.resize(columnNames.size());
+        for (Chunk& chunk : rowGroup.chunks) {
+            chunk.offset = offset;
+            chunk.length = cursor.varint();
+            offset += chunk.length;
+        }
+        if (offset > footerOffset) {
+            throw std::runtime_error(path + " has a corrupted footer.");
+        }
+    }
+}
+
+const std::vector<std::string>& TelemetryReader::getColumnNames() {
+    return columnNames;
+}
+
+TelemetryEncoding TelemetryReader::getEncoding(const std::string& column) {
+    return columnEncodings[columnIndex(column)];
+}
+
+size_t TelemetryReader::getRowGroupCount() const {
+    return rowGroups.size();
+}
+
+std::uint64_t TelemetryReader::getRowCount(size_t rowGroup) const {
+    return rowGroups.at(rowGroup).rowCount;
+}
+
+std::string TelemetryReader::readChunk(size_t rowGroup, const std::string& column) {
+    const Chunk& chunk = rowGroups.at(rowGroup).chunks[columnIndex(column)];
+    std::string data(chunk.length, '\0');
+    file.clear();
+    file.seekg(chunk.offset);
+    if (!file.read(&data[0], data.size())) {
+        throw std::runtime_error("Failed to read the " + column + " column.");
+    }
+    return data;
+}
+
+std::vector<std::int64_t> TelemetryReader::readNumbers(size_t rowGroup, const std::string& column) {
+    TelemetryEncoding encoding = getEncoding(column);
+    if (encoding == TelemetryEncoding::Dictionary) {
+        throw std::runtime_error("The " + column + " column does not hold numbers.");
+    }
+    std::string data = readChunk(rowGroup, column);
+    Cursor cursor{data, 0};
+    std::vector<std::int64_t> values(rowGroups[rowGroup].rowCount);
+    std::int64_t previous = 0;
+    for (std::int64_t& value : values) {
+        std::uint64_t raw = cursor.varint();
+        if (encoding == TelemetryEncoding::Delta) {
+            previous += static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+            value = previous;
+        } else {
+            value = static_cast<std::int64_t>(raw);
+        }
+    }
+    return values;
+}
+
+std::vector<std::string> TelemetryReader::readStrings(size_t rowGroup, const std::string& column) {
+    if (getEncoding(column) != TelemetryEncoding::Dictionary) {
+        throw std::runtime_error("The " + column + " column does not hold strings.");
+    }
+    std::string data = readChunk(rowGroup, column);
+    Cursor cursor{data, 0};
+    std::vector<std::string> dictionary(cursor.varint());
+    for (std::string& entry : dictionary) {
+        entry = cursor.bytes(cursor.varint());
+    }
+    std::vector<std::string> values(rowGroups[rowGroup].rowCount);
+    for (std::string& value : values) {
+        std::uint64_t code = cursor.varint();
+        if (code >= dictionary.size()) {
+            throw std::runtime_error("Invalid dictionary code in the " + column + " column.");
+        }
+        value = dictionary[code];
+    }
+    return values;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include "telemetry.hpp"
+
+// Generate rows as a match records them: turns of four players, one row per unit, with units
+// anywhere on the largest map, wounded, sometimes dealing damage and given a few kinds of orders
+std::vector<TelemetryRow> generateRows(size_t count, std::mt19937& gen) {
+    const std::vector<std::string> types = {"Base", "Worker", "Swordsman", "Archer", "Knight", "Pikeman", "Catapult", "Ram"};
+    const std::vector<std::string> orders = {"", "M", "A", "MA", "B"};
+    std::vector<TelemetryRow> rows;
+    std::uint64_t time = 0;
+    while (rows.size() < count) {
+        ++time;
+        std::uint8_t owner = time % 4;
+        size_t units = 1 + gen() % 64;
+        for (size_t unit = 0; unit < units && rows.size() < count; ++unit) {
+            TelemetryRow row;
+            row.time = time;
+            row.owner = owner;
+            row.unitId = static_cast<std::uint16_t>(owner * 1000 + unit * 3 + gen() % 3);
+            row.type = types[gen() % types.size()];
+            row.x = static_cast<std::uint16_t>(gen() % 8192);
+            row.y = static_cast<std::uint16_t>(gen() % 8192);
+            row.health = static_cast<std::uint16_t>(gen() % 201);
+            row.damage = gen() % 4 == 0 ? gen() % 100000 : 0;
+            row.orders = orders[gen() % orders.size()];
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
+
+// The value of a column in a row, as the reader returns it, by column index in file order
+std::string columnValue(const TelemetryRow& row, size_t column) {
+    switch (column) {
+        case 0: return std::to_string(row.time);
+        case 1: return std::to_string(row.owner);
+        case 2: return std::to_string(row.unitId);
+        case 3: return row.type;
+        case 4: return std::to_string(row.x);
+        case 5: return std::to_string(row.y);
+        case 6: return std::to_string(row.health);
+        case 7: return std::to_string(row.damage);
+        case 8: return row.orders;
+        default: throw std::runtime_error("Unknown telemetry column: " + std::to_string(column));
+    }
+}
+
+// Read a whole column, one row group at a time, as strings
+std::vector<std::string> readColumn(TelemetryReader& reader, const std::string& column) {
+    std::vector<std::string> values;
+    for (size_t rowGroup = 0; rowGroup < reader.getRowGroupCount(); ++rowGroup) {
+        if (TelemetryReader::getEncoding(column) == TelemetryEncoding::Dictionary) {
+            std::vector<std::string> strings = reader.readStrings(rowGroup, column);
+            values.insert(values.end(), strings.begin(), strings.end());
+        } else {
+            for (std::int64_t number : reader.readNumbers(rowGroup, column)) {
+                values.push_back(std::to_string(number));
+            }
+        }
+    }
+    return values;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rowCount = 25000;
+    size_t rowGroupSize = 16384;
+
+    if (argc > 1) {
+        rowCount = std::stoul(argv[1]);
+    }
+    if (argc > 2) {
+        rowGroupSize = std::max(1ul, std::stoul(argv[2]));
+    }
+
+    std::mt19937 gen(42);
+    std::vector<TelemetryRow> rows = generateRows(rowCount, gen);
+    const std::string path = (std::filesystem::temp_directory_path() / "telemetry_bench.tlm").string();
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        TelemetryWriter writer(path, rowGroupSize);
+        for (const TelemetryRow& row : rows) {
+            writer.addRow(row);
+        }
+        writer.close();
+    }
+    std::chrono::duration<double> writing = std::chrono::steady_clock::now() - start;
+
+    // Every column is read on its own and compared with the rows it was written from
+    TelemetryReader reader(path);
+    std::uint64_t readRows = 0;
+    for (size_t rowGroup = 0; rowGroup < reader.getRowGroupCount(); ++rowGroup) {
+        readRows += reader.getRowCount(rowGroup);
+    }
+    bool allMatch = readRows == rows.size();
+    std::cout << "Rows: " << rows.size() << ", row groups: " << reader.getRowGroupCount() << ", "
+              << static_cast<double>(std::filesystem::file_size(path)) / rows.size() << " bytes/row, writing "
+              << rows.size() / writing.count() / 1e6 << " Mrows/s" << std::endl;
+    const std::vector<std::string>& columns = TelemetryReader::getColumnNames();
+    for (size_t column = 0; column < columns.size(); ++column) {
+        start = std::chrono::steady_clock::now();
+        std::vector<std::string> values = readColumn(reader, columns[column]);
+        std::chrono::duration<double> reading = std::chrono::steady_clock::now() - start;
+
+        bool match = values.size() == rows.size();
+        for (size_t row = 0; match && row < rows.size(); ++row) {
+            match = values[row] == columnValue(rows[row], column);
+        }
+        allMatch = allMatch && match;
+        std::cout << columns[column] << ": reading " << rows.size() / reading.count() / 1e6 << " Mrows/s, values "
+                  << (match ? "match" : "DIFFER") << std::endl;
+    }
+    std::filesystem::remove(path);
+
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+#include <iostream>
+#include "telemetry.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Invalid amount of arguments. Usage: ./telemetry <telemetry file> [column...]" << std::endl;
+        return 1;
+    }
+
+    try {
+        TelemetryReader reader(argv[1]);
+        std::vector<std::string> columns(argv + 2, argv + argc);
+        if (columns.empty()) {
+            columns = TelemetryReader::getColumnNames();
+        }
+        for (size_t column = 0; column < columns.size(); ++column) {
+            // Validates the column before anything is printed
+            TelemetryReader::getEncoding(columns[column]);
+            std::cout << (column ? "," : "") << columns[column];
+        }
+        std::cout << '\n';
+
+        // Only the chunks of the requested columns are read, one row group at a time
+        for (size_t rowGroup = 0; rowGroup < reader.getRowGroupCount(); ++rowGroup) {
+            std::vector<std::vector<std::string>> values;
+            for (const std::string& column : columns) {
+                if (TelemetryReader::getEncoding(column) == TelemetryEncoding::Dictionary) {
+                    values.push_back(reader.readStrings(rowGroup, column));
+                } else {
+                    std::vector<std::string> formatted;
+                    for (std::int64_t number : reader.readNumbers(rowGroup, column)) {
+                        formatted.push_back(std::to_string(number));
+                    }
+                    values.push_back(std::move(formatted));
+                }
+            }
+            for (std::uint64_t row = 0; row < reader.getRowCount(rowGroup); ++row) {
+                for (size_t column = 0; column < values.size(); ++column) {
+                    std::cout << (column ? "," : "") << values[column][row];
+                }
+                std::cout << '\n';
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int worker = 0; worker < threadCount; ++worker) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    // Worker 0 is the thread calling parallelFor, so only the others get their own thread
+    for (unsigned int worker = 1; worker < threadCount; ++worker) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        stopping = true;
+    }
+    batchStarted.notify_all();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+unsigned int ThreadPool::size() const {
+    return queues.size();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, unsigned int)>& batchTask) {
+    if (count == 0) {
+        return;
+    }
+
+    // The batch state has to be in place before any index becomes visible in a queue
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        task = &batchTask;
+        failure = nullptr;
+        remaining.store(count);
+    }
+
+    // Hand out contiguous blocks of indices so neighbouring tasks stay on the same worker
+    size_t workers = queues.size();
+    size_t blockSize = (count + workers - 1) / workers;
+    for (size_t worker = 0; worker < workers; ++worker) {
+        std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+        for (size_t index = worker * blockSize; index < std::min(count, (worker + 1) * blockSize); ++index) {
+            queues[worker]->tasks.push_back(index);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        ++generation;
+    }
+    batchStarted.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(batchMutex);
+    batchFinished.wait(lock, [this]() { return remaining.load() == 0; });
+    task = nullptr;
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void ThreadPool::workerLoop(unsigned int worker) {
+    unsigned long seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(batchMutex);
+            batchStarted.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runTasks(worker);
+    }
+}
+
+void ThreadPool::runTasks(unsigned int worker) {
+    size_t index;
+    while (takeTask(worker, index)) {
+        try {
+            (*task)(index, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(batchMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+
+        // The last task to finish wakes up the caller
+        if (remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(batchMutex);
+            batchFinished.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::takeTask(unsigned int worker, size_t& index) {
+    // Take from the front of the worker's own queue first
+    {
+        WorkerQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            index = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // Steal from the back of the other queues
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        WorkerQueue& victim = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            index = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
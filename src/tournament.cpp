@@ -0,0 +1,390 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "status.hpp"
+#include "map_cache.hpp"
+#include "trace.hpp"
+
+namespace fs = std::filesystem;
+
+struct Settings {
+    fs::path mediator;              // The mediator running every match
+    std::vector<fs::path> bots;     // The competing bots
+    std::vector<fs::path> maps;     // The maps every pairing is played on
+    unsigned int swissRounds = 0;   // Rounds of Swiss pairings, 0 for a round robin
+    unsigned int workers = 1;       // Matches running at once
+    unsigned int turns = 10;        // Turns per player and match
+    int timeLimit = 1;              // Time limit per bot turn in seconds
+};
+
+struct Match {
+    unsigned int id;                                    // Index of the match in the tournament
+    unsigned int round;                                 // Swiss round of the match, 0 in a round robin
+    size_t map;                                         // Index of the map
+    size_t players[2];                                  // Index of the bot playing as player 1 and as player 2
+    fs::path directory;                                 // Scratch directory of the match
+    std::chrono::steady_clock::time_point start;        // When the mediator was started
+};
+
+struct Standing {
+    double points = 0.0;                // 1 per win and 0.5 per draw
+    unsigned int wins = 0;
+    unsigned int draws = 0;
+    unsigned int losses = 0;
+    unsigned int errors = 0;            // Matches that could not be finished
+    std::vector<size_t> opponents;      // Bots already met, to avoid Swiss rematches
+};
+
+// Start the mediator in the directory of a match, with its output sent to a log file
+pid_t startMatch(const Settings& settings, const Match& match) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    if (chdir(match.directory.c_str()) != 0) {
+        _exit(127);
+    }
+    int log = open("log.txt", O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (log >= 0) {
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+        close(log);
+    }
+    std::vector<std::string> args = {settings.mediator.string(), "data/map.txt", settings.bots[match.players[0]].string(),
+                                     settings.bots[match.players[1]].string(), std::to_string(settings.turns),
+                                     std::to_string(settings.timeLimit), "-"};
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    _exit(127);
+}
+
+// Decide a finished match from its final status: a player who lost their base loses,
+// otherwise the army with more health left wins. Returns the winning player ID, or -1 for a draw.
+int decideMatch(const fs::path& statusFile) {
+    std::ifstream status(statusFile);
+    Player players[2] = {Player(0, "Player 1", 0), Player(1, "Player 2", 0)};
+    readStatus(status, 0, players[0], players[1]);
+
+    bool hasBase[2] = {false, false};
+    unsigned long health[2] = {0, 0};
+    for (int id : {0, 1}) {
+        for (const Unit& unit : players[id].getPlayerUnits()) {
+            hasBase[id] = hasBase[id] || unit.getInitial() == 'B';
+            health[id] += unit.getHealth();
+        }
+    }
+    if (hasBase[0] != hasBase[1]) {
+        return hasBase[0] ? 0 : 1;
+    }
+    if (health[0] != health[1]) {
+        return health[0] > health[1] ? 0 : 1;
+    }
+    return -1;
+}
+
+// Find the player whose bot failed a turn in the log of a failed match, or -1 if the mediator itself failed
+int findForfeit(const fs::path& logFile) {
+    std::ifstream log(logFile);
+    std::string line;
+    while (std::getline(log, line)) {
+        for (int id : {0, 1}) {
+            if (line.rfind("Player " + std::to_string(id + 1) + "'s turn failed", 0) == 0) {
+                return id;
+            }
+        }
+    }
+    return -1;
+}
+
+std::string jsonString(const std::string& value) {
+    std::string escaped = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped + "\"";
+}
+
+// Play a batch of independent matches on a pool of worker processes, streaming every result as it comes in
+void playMatches(const Settings& settings, std::vector<Match>& matches, std::vector<Standing>& standings,
+                 std::ofstream& results) {
+    std::unordered_map<pid_t, Match*> running;
+    size_t next = 0;
+    while (next < matches.size() || !running.empty()) {
+        // Keep every worker busy
+        while (running.size() < settings.workers && next < matches.size()) {
+            Match& match = matches[next++];
+            fs::create_directories(match.directory / "data");
+            fs::copy_file(settings.maps[match.map], match.directory / "data" / "map.txt", fs::copy_options::overwrite_existing);
+            std::ofstream(match.directory / "data" / "orders.txt");
+            match.start = std::chrono::steady_clock::now();
+            pid_t pid = startMatch(settings, match);
+            if (pid < 0) {
+                throw std::runtime_error("Failed to start a match process.");
+            }
+            running[pid] = &match;
+        }
+
+        // Collect whichever match finishes first
+        int status = 0;
+        struct rusage usage = {};
+        pid_t pid = wait4(-1, &status, 0, &usage);
+        if (pid < 0 && errno != EINTR) {
+            throw std::runtime_error("Failed to wait for the match processes.");
+        }
+        auto found = running.find(pid);
+        if (found == running.end()) {
+            continue;
+        }
+        Match& match = *found->second;
+        running.erase(found);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - match.start;
+
+        // A bot failing a turn forfeits the match, a mediator failure leaves it undecided
+        bool finished = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        int forfeit = finished ? -1 : findForfeit(match.directory / "log.txt");
+        int winner = -1;
+        std::string outcome = "error";
+        if (finished) {
+            winner = decideMatch(match.directory / "data" / "status.txt");
+            outcome = winner < 0 ? "draw" : (winner == 0 ? "player1" : "player2");
+        } else if (forfeit >= 0) {
+            winner = !forfeit;
+            outcome = winner == 0 ? "player1" : "player2";
+        }
+        for (int id : {0, 1}) {
+            Standing& standing = standings[match.players[id]];
+            standing.opponents.push_back(match.players[!id]);
+            if (!finished && (forfeit < 0 || forfeit == id)) {
+                ++standing.errors;
+                standing.losses += forfeit == id;
+            } else if (winner < 0) {
+                ++standing.draws;
+                standing.points += 0.5;
+            } else if (winner == id) {
+                ++standing.wins;
+                standing.points += 1.0;
+            } else {
+                ++standing.losses;
+            }
+        }
+
+        results << "{\"match\": " << match.id << ", \"round\": " << match.round << ", \"map\": "
+                << jsonString(settings.maps[match.map].string()) << ", \"player1\": "
+                << jsonString(settings.bots[match.players[0]].string()) << ", \"player2\": "
+                << jsonString(settings.bots[match.players[1]].string()) << ", \"result\": \"" << outcome
+                << "\", \"forfeit\": " << (forfeit >= 0 ? "true" : "false") << ", \"seconds\": " << elapsed.count()
+                << ", \"peak_rss_kb\": " << usage.ru_maxrss << "}" << std::endl;
+        std::cerr << "Match " << match.id << ": " << settings.bots[match.players[0]].filename().string() << " vs "
+                  << settings.bots[match.players[1]].filename().string() << " on " << settings.maps[match.map].filename().string()
+                  << ": " << outcome << " in " << elapsed.count() << " s" << std::endl;
+
+        // Failed matches are kept for inspection
+        if (finished) {
+            fs::remove_all(match.directory);
+        } else {
+            std::cerr << "The match failed, see " << (match.directory / "log.txt") << std::endl;
+        }
+    }
+}
+
+// Every pairing is played on every map with both sides
+void addPairing(const Settings& settings, const fs::path& scratch, unsigned int round, size_t first, size_t second,
+                std::vector<Match>& matches, unsigned int& nextId) {
+    for (size_t map = 0; map < settings.maps.size(); ++map) {
+        for (bool swap : {false, true}) {
+            Match match = {};
+            match.id = nextId++;
+            match.round = round;
+            match.map = map;
+            match.players[0] = swap ? second : first;
+            match.players[1] = swap ? first : second;
+            match.directory = scratch / ("match_" + std::to_string(match.id));
+            matches.push_back(match);
+        }
+    }
+}
+
+// Pair the bots by score, avoiding rematches when possible. With an odd number of bots the
+// lowest ranked bot without a bye sits the round out and scores a win.
+std::vector<std::pair<size_t, size_t>> swissPairings(std::vector<Standing>& standings, std::vector<bool>& hadBye) {
+    std::vector<size_t> ranking(standings.size());
+    std::iota(ranking.begin(), ranking.end(), 0);
+    std::stable_sort(ranking.begin(), ranking.end(), [&](size_t a, size_t b) {
+        return standings[a].points > standings[b].points;
+    });
+
+    if (ranking.size() % 2 == 1) {
+        auto bye = std::find_if(ranking.rbegin(), ranking.rend(), [&](size_t bot) { return !hadBye[bot]; });
+        size_t bot = bye != ranking.rend() ? *bye : ranking.back();
+        hadBye[bot] = true;
+        standings[bot].points += 1.0;
+        ++standings[bot].wins;
+        ranking.erase(std::find(ranking.begin(), ranking.end(), bot));
+    }
+
+    std::vector<std::pair<size_t, size_t>> pairings;
+    std::vector<bool> paired(standings.size(), false);
+    for (size_t i = 0; i < ranking.size(); ++i) {
+        size_t bot = ranking[i];
+        if (paired[bot]) {
+            continue;
+        }
+        // The next unpaired bot it has not met yet, or the next unpaired bot if it met them all
+        size_t opponent = standings.size();
+        for (size_t j = i + 1; j < ranking.size(); ++j) {
+            size_t candidate = ranking[j];
+            if (paired[candidate]) {
+                continue;
+            }
+            if (opponent == standings.size()) {
+                opponent = candidate;
+            }
+            const std::vector<size_t>& met = standings[bot].opponents;
+            if (std::find(met.begin(), met.end(), candidate) == met.end()) {
+                opponent = candidate;
+                break;
+            }
+        }
+        paired[bot] = paired[opponent] = true;
+        pairings.emplace_back(bot, opponent);
+    }
+    return pairings;
+}
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    settings.workers = std::max(1u, std::thread::hardware_concurrency());
+    fs::path resultsFile;
+
+    // Positional arguments, then the maps and the options
+    std::vector<std::string> positional;
+    bool readingMaps = false;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--maps") {
+                readingMaps = true;
+            } else if (arg == "--swiss" && hasValue) {
+                settings.swissRounds = std::stoi(argv[++i]);
+            } else if (arg == "--workers" && hasValue) {
+                settings.workers = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--turns" && hasValue) {
+                settings.turns = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--time-limit" && hasValue) {
+                settings.timeLimit = std::stoi(argv[++i]);
+            } else if (readingMaps) {
+                settings.maps.push_back(fs::absolute(arg));
+            } else {
+                positional.push_back(arg);
+            }
+        }
+    } catch (const std::exception&) {
+        positional.clear();
+    }
+    if (positional.size() < 4 || settings.maps.empty()) {
+        std::cerr << "Invalid arguments. Usage: ./tournament <mediator> <results file> <bot> <bot> [bot...] --maps <map> [map...]"
+                     " [--swiss <rounds>] [--workers <n>] [--turns <n>] [--time-limit <seconds>]" << std::endl;
+        return 1;
+    }
+    settings.mediator = fs::absolute(positional[0]);
+    resultsFile = positional[1];
+    for (size_t i = 2; i < positional.size(); ++i) {
+        settings.bots.push_back(fs::absolute(positional[i]));
+    }
+    for (const fs::path& file : settings.bots) {
+        if (!fs::exists(file)) {
+            std::cerr << file << " does not exist." << std::endl;
+            return 1;
+        }
+    }
+    for (const fs::path& file : settings.maps) {
+        if (!fs::exists(file)) {
+            std::cerr << file << " does not exist." << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream results(resultsFile);
+    if (!results) {
+        std::cerr << "Failed to open the results file." << std::endl;
+        return 1;
+    }
+
+    // Every match gets its own copy of the data directory, so matches can run side by side
+    const fs::path scratch = fs::temp_directory_path() / ("skirmish_tournament_" + std::to_string(getpid()));
+    // The matches share one map cache, so only the first turn on each map computes the bots' precomputed fields
+    setenv(mapCacheVariable, fs::absolute(scratch / "cache").c_str(), 0);
+    // Matches run in their scratch directories, so their traces are written to the absolute trace directory
+    if (!getTraceDirectory().empty()) {
+        setenv(traceDirectoryVariable, fs::absolute(getTraceDirectory()).c_str(), 1);
+    }
+    std::vector<Standing> standings(settings.bots.size());
+    unsigned int nextId = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    try {
+        if (settings.swissRounds == 0) {
+            // Round robin: every pairing is independent, so the whole tournament fills the pool at once
+            std::vector<Match> matches;
+            for (size_t first = 0; first < settings.bots.size(); ++first) {
+                for (size_t second = first + 1; second < settings.bots.size(); ++second) {
+                    addPairing(settings, scratch, 0, first, second, matches, nextId);
+                }
+            }
+            playMatches(settings, matches, standings, results);
+        } else {
+            // Swiss: the pairings of a round depend on the results of the previous ones
+            std::vector<bool> hadBye(settings.bots.size(), false);
+            for (unsigned int round = 1; round <= settings.swissRounds; ++round) {
+                std::vector<Match> matches;
+                for (const auto& [first, second] : swissPairings(standings, hadBye)) {
+                    addPairing(settings, scratch, round, first, second, matches, nextId);
+                }
+                playMatches(settings, matches, standings, results);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<size_t> ranking(settings.bots.size());
+    std::iota(ranking.begin(), ranking.end(), 0);
+    std::stable_sort(ranking.begin(), ranking.end(), [&](size_t a, size_t b) {
+        return standings[a].points > standings[b].points;
+    });
+    std::cout << nextId << " matches in " << elapsed.count() << " s on " << settings.workers << " workers" << std::endl;
+    for (size_t place = 0; place < ranking.size(); ++place) {
+        const Standing& standing = standings[ranking[place]];
+        std::cout << place + 1 << ". " << settings.bots[ranking[place]].string() << ": " << standing.points << " points ("
+                  << standing.wins << " wins, " << standing.draws << " draws, " << standing.losses << " losses, "
+                  << standing.errors << " errors)" << std::endl;
+    }
+
+    std::error_code error;
+    fs::remove_all(scratch / "cache", error);
+    if (fs::is_empty(scratch, error)) {
+        fs::remove(scratch, error);
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Escape a string for a JSON string literal
+std::string escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += ' ';
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// The ID of the calling thread, unique across the processes of the machine
+std::uint32_t currentThread() {
+    thread_local std::uint32_t thread = static_cast<std::uint32_t>(syscall(SYS_gettid));
+    return thread;
+}
+
+}  // namespace
+
+Tracer::Tracer()
+    : enabled(false), flushed(false), directory(getTraceDirectory()), lane(static_cast<std::uint32_t>(getpid())),
+      processName("Process " + std::to_string(getpid())) {
+    enabled = !directory.empty();
+    if (enabled) {
+        events.reserve(4096);
+    }
+}
+
+Tracer::~Tracer() {
+    flush();
+}
+
+Tracer& Tracer::get() {
+    static Tracer tracer;
+    return tracer;
+}
+
+std::uint64_t Tracer::now() {
+    // The steady clock is CLOCK_MONOTONIC, the same in every process since the machine started
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool Tracer::isEnabled() const {
+    return enabled;
+}
+
+void Tracer::setProcess(std::uint32_t lane, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->lane = lane;
+    processName = name;
+}
+
+void Tracer::record(const TraceEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (enabled) {
+        events.push_back(event);
+    }
+}
+
+std::string Tracer::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!enabled || flushed) {
+        return "";
+    }
+    enabled = false;
+    flushed = true;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::string path = directory + "/" + getTraceMatch() + "_" + std::to_string(getpid()) + ".json";
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return "";
+    }
+
+    // A JSON array with one event per line, which is a trace on its own and easy to merge
+    std::string pid = std::to_string(lane);
+    file << "[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"name\":\"" << escape(processName)
+         << "\"}},\n";
+    file << "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"sort_index\":" << pid << "}}";
+    for (const TraceEvent& event : events) {
+        file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":" << event.start
+             << ",\"dur\":" << event.duration << ",\"pid\":" << pid << ",\"tid\":" << event.thread;
+        if (event.argumentName) {
+            file << ",\"args\":{\"" << event.argumentName << "\":" << event.argument << "}";
+        }
+        file << "}";
+    }
+    file << "\n]\n";
+    events.clear();
+    events.shrink_to_fit();
+    return file.flush() ? path : "";
+}
+
+TraceSpan::TraceSpan(const char* name, const char* category, const char* argumentName, std::int64_t argument)
+    : name(name), category(category), argumentName(argumentName), argument(argument),
+      start(Tracer::get().isEnabled() ? Tracer::now() : 0) {
+}
+
+TraceSpan::~TraceSpan() {
+    if (start != 0) {
+        Tracer::get().record({name, category, start, Tracer::now() - start, currentThread(), argumentName, argument});
+    }
+}
+
+std::string getTraceDirectory() {
+    const char* directory = std::getenv(traceDirectoryVariable);
+    return directory ? directory : "";
+}
+
+std::string getTraceMatch() {
+    const char* match = std::getenv(traceMatchVariable);
+    return match && *match ? match : "match_" + std::to_string(getpid());
+}
+
+std::string mergeTraces(const std::string& directory, const std::string& match) {
+    // The files of the processes of the match, named <match>_<pid>.json
+    std::vector<std::filesystem::path> parts;
+    std::string prefix = match + "_";
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() > prefix.size() + 5 && name.compare(0, prefix.size(), prefix) == 0 &&
+            name.compare(name.size() - 5, 5, ".json") == 0) {
+            std::string pid = name.substr(prefix.size(), name.size() - prefix.size() - 5);
+            if (std::all_of(pid.begin(), pid.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+                parts.push_back(entry.path());
+            }
+        }
+    }
+    std::sort(parts.begin(), parts.end());
+
+    std::string path = directory + "/" + match + ".json";
+    std::ofstream merged(path, std::ios::trunc);
+    if (!merged) {
+        throw std::runtime_error("Failed to create the trace file " + path + ".");
+    }
+    merged << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const std::filesystem::path& part : parts) {
+        // Every event is on a line of its own, between the brackets of the array
+        std::ifstream file(part);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] != '{') {
+                continue;
+            }
+            if (line.back() == ',') {
+                line.pop_back();
+            }
+            merged << (first ? "" : ",\n") << line;
+            first = false;
+        }
+    }
+    merged << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"match\":\"" << escape(match) << "\"}}\n";
+    if (!merged.flush()) {
+        throw std::runtime_error("Failed to write the trace file " + path + ".");
+    }
+    for (const std::filesystem::path& part : parts) {
+        std::filesystem::remove(part, error);
+    }
+    return path;
+}
@@ -0,0 +1,147 @@
+#include "transposition_table.hpp"
+#include <stdexcept>
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The transposition table needs lock-free 64-bit atomics.");
+
+namespace {
+
+// Layout of the packed entry: value in bits 0-31, depth in 32-39, bound in 40-41,
+// best move in 42-49 and generation in 50-57
+std::uint64_t pack(const TranspositionEntry& entry, std::uint8_t generation) {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(entry.value)) |
+           static_cast<std::uint64_t>(entry.depth) << 32 |
+           static_cast<std::uint64_t>(entry.bound) << 40 |
+           static_cast<std::uint64_t>(entry.bestMove) << 42 |
+           static_cast<std::uint64_t>(generation) << 50;
+}
+
+TranspositionEntry unpack(std::uint64_t data) {
+    TranspositionEntry entry;
+    entry.value = static_cast<std::int32_t>(static_cast<std::uint32_t>(data));
+    entry.depth = static_cast<std::uint8_t>(data >> 32);
+    entry.bound = static_cast<TranspositionEntry::Bound>((data >> 40) & 3);
+    entry.bestMove = static_cast<std::uint8_t>(data >> 42);
+    return entry;
+}
+
+std::uint8_t generationOf(std::uint64_t data) {
+    return static_cast<std::uint8_t>(data >> 50);
+}
+
+}  // namespace
+
+double TranspositionStatistics::getHitRate() const {
+    return probes == 0 ? 0.0 : static_cast<double>(hits) / probes;
+}
+
+void TranspositionStatistics::add(const TranspositionStatistics& other) {
+    probes += other.probes;
+    hits += other.hits;
+    stores += other.stores;
+    replacements += other.replacements;
+}
+
+TranspositionTable::TranspositionTable(size_t bucketCount) : generation(0) {
+    if (bucketCount == 0) {
+        throw std::runtime_error("A transposition table needs at least one bucket.");
+    }
+    size_t buckets = 1;
+    while (buckets < bucketCount) {
+        buckets <<= 1;
+    }
+    bucketMask = buckets - 1;
+    slots = std::make_unique<Slot[]>(buckets * bucketSize);
+    clear();
+}
+
+bool TranspositionTable::probe(std::uint64_t hash, TranspositionEntry& entry, TranspositionStatistics& statistics) const {
+    ++statistics.probes;
+    Slot* bucket = &slots[(hash & bucketMask) * bucketSize];
+    for (size_t index = 0; index < bucketSize; ++index) {
+        std::uint64_t data = bucket[index].data.load(std::memory_order_relaxed);
+        std::uint64_t check = bucket[index].check.load(std::memory_order_relaxed);
+        // A torn slot or the slot of another position fails the check
+        if ((check ^ data) == hash && unpack(data).bound != TranspositionEntry::Bound::None) {
+            entry = unpack(data);
+            ++statistics.hits;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t hash, const TranspositionEntry& entry, TranspositionStatistics& statistics) {
+    std::uint8_t current = generation.load(std::memory_order_relaxed);
+    Slot* bucket = &slots[(hash & bucketMask) * bucketSize];
+
+    // Take the slot of the same position or an empty slot, or else the slot least worth keeping
+    Slot* victim = nullptr;
+    int victimWorth = 0;
+    bool replacing = false;
+    for (size_t index = 0; index < bucketSize; ++index) {
+        std::uint64_t data = bucket[index].data.load(std::memory_order_relaxed);
+        std::uint64_t check = bucket[index].check.load(std::memory_order_relaxed);
+        TranspositionEntry stored = unpack(data);
+        if (stored.bound == TranspositionEntry::Bound::None || (check ^ data) == hash) {
+            // A deeper result of the same search is worth more than a shallower one
+            if (stored.bound != TranspositionEntry::Bound::None && generationOf(data) == current && stored.depth > entry.depth &&
+                entry.bound != TranspositionEntry::Bound::Exact) {
+                return;
+            }
+            victim = &bucket[index];
+            replacing = false;
+            break;
+        }
+        int age = static_cast<std::uint8_t>(current - generationOf(data));
+        int worth = static_cast<int>(stored.depth) - 4 * age;
+        if (!victim || worth < victimWorth) {
+            victim = &bucket[index];
+            victimWorth = worth;
+            replacing = true;
+        }
+    }
+
+    std::uint64_t data = pack(entry, current);
+    victim->data.store(data, std::memory_order_relaxed);
+    victim->check.store(hash ^ data, std::memory_order_relaxed);
+    ++statistics.stores;
+    if (replacing) {
+        ++statistics.replacements;
+    }
+}
+
+void TranspositionTable::newSearch() {
+    generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+    for (size_t index = 0; index < getCapacity(); ++index) {
+        slots[index].check.store(0, std::memory_order_relaxed);
+        slots[index].data.store(0, std::memory_order_relaxed);
+    }
+    generation.store(0, std::memory_order_relaxed);
+    probes.store(0, std::memory_order_relaxed);
+    hits.store(0, std::memory_order_relaxed);
+    stores.store(0, std::memory_order_relaxed);
+    replacements.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::addStatistics(const TranspositionStatistics& statistics) {
+    probes.fetch_add(statistics.probes, std::memory_order_relaxed);
+    hits.fetch_add(statistics.hits, std::memory_order_relaxed);
+    stores.fetch_add(statistics.stores, std::memory_order_relaxed);
+    replacements.fetch_add(statistics.replacements, std::memory_order_relaxed);
+}
+
+TranspositionStatistics TranspositionTable::getStatistics() const {
+    TranspositionStatistics statistics;
+    statistics.probes = probes.load(std::memory_order_relaxed);
+    statistics.hits = hits.load(std::memory_order_relaxed);
+    statistics.stores = stores.load(std::memory_order_relaxed);
+    statistics.replacements = replacements.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+size_t TranspositionTable::getCapacity() const {
+    return (bucketMask + 1) * bucketSize;
+}
@@ -1,4 +1,5 @@
 #include "unit.hpp"
+#include "spatial_index.hpp"
 #include <iostream>
 // Map of unit attributes for each unit name
 const std::unordered_map<std::string, UnitAttributes> Unit::unitAttributesMap = {
@@ -26,7 +27,7 @@ const std::unordered_map<std::string, std::unordered_map<std::string, unsigned s
 };
 
 // Constructor for the Unit class
-Unit::Unit(bool owner, unsigned short id, const std::string& name) : owner(owner), id(id), name(name) {
+Unit::Unit(OwnerId owner, unsigned short id, const std::string& name) : owner(owner), id(id), name(name) {
     // Check if the unit name exists in the unitAttributesMap
     auto it = unitAttributesMap.find(name);
     if (it == unitAttributesMap.end()) {
@@ -43,6 +44,18 @@ Unit::Unit(bool owner, unsigned short id, const std::string& name) : owner(owner
     baseSpeed = speed;
 }
 
+Unit::Creation::Creation(const Creation& other) : unit(other.unit ? std::make_unique<Unit>(*other.unit) : nullptr) {
+}
+
+Unit::Creation& Unit::Creation::operator=(const Creation& other) {
+    if (this != &other) {
+        unit = other.unit ? std::make_unique<Unit>(*other.unit) : nullptr;
+    }
+    return *this;
+}
+
+Unit::Creation::~Creation() = default;
+
 // Getters for various unit attributes
 unsigned short Unit::getId() const {
     return id;
@@ -80,7 +93,7 @@ std::string Unit::getName() const {
     return name;
 }
 
-bool Unit::getOwner() const {
+OwnerId Unit::getOwner() const {
     return owner;
 }
 
@@ -96,6 +109,10 @@ void Unit::setPosition(unsigned int x, unsigned int y) {
     position[1] = y;
 }
 
+void Unit::setId(unsigned short newId) {
+    id = newId;
+}
+
 // Calculate the damage inflicted by the current unit to the target unit
 unsigned short Unit::calculateDamage(const Unit& target) const {
     const std::string& targetName = target.getName();
@@ -118,7 +135,7 @@ unsigned short Unit::calculateDamage(const Unit& target) const {
 }
 
 // Calculate the distance between the unit's current position and the target position (x, y)
-unsigned short Unit::calculateDistance(unsigned short x, unsigned short y) {
+unsigned short Unit::calculateDistance(unsigned short x, unsigned short y) const {
     return std::abs(position[0] - x) + std::abs(position[1] - y);
 }
 
@@ -141,16 +158,6 @@ void Unit::initializeUnitAttributes() {
 
 // Perform an attack action on the target unit with the specified ID
 void Unit::attackAction(unsigned short targetId, const std::vector<Unit>& units) {
-    if (name == "Base") {
-        throw std::runtime_error("Base unit cannot perform attack action. ");
-    }
-    if (speed == 0) {
-        throw std::runtime_error("Unit cannot attack. Speed is 0.");
-    }
-    if (hasAttacked) {
-        throw std::runtime_error("Unit can only attack once.");
-    }
-    
     // Find the target unit with the specified ID
     const Unit* tempTargetUnit = nullptr;
     for (const Unit& unit : units) {
@@ -160,36 +167,64 @@ void Unit::attackAction(unsigned short targetId, const std::vector<Unit>& units)
         }
     }
 
-    Unit* targetUnit = const_cast<Unit*>(tempTargetUnit);
+    attackUnit(tempTargetUnit, targetId);
+}
 
-    if (targetUnit) {
-        // Throw an error when trying to attack an ally
-        if (owner == targetUnit->owner) {
-            throw std::runtime_error("A unit cannot attack their allies.");
-        }
+// Perform an attack action on the target unit found in the spatial index
+void Unit::attackAction(unsigned short targetId, const SpatialIndex& index) {
+    const SpatialIndex::Entry* entry = index.find(targetId);
+    attackUnit(entry ? entry->unit : nullptr, targetId);
+}
 
-        // Calculate the distance between the unit's current position and the target unit's position
-        unsigned short distance = calculateDistance(targetUnit->getPositionX(), targetUnit->getPositionY());
+// Validate an attack on the target unit found in the spatial index without dealing damage
+const Unit& Unit::declareAttack(unsigned short targetId, const SpatialIndex& index) {
+    const SpatialIndex::Entry* entry = index.find(targetId);
+    return prepareAttack(entry ? entry->unit : nullptr, targetId);
+}
 
-        // Check if the target unit is within the attack range
-        if (distance > attackRange) {
-            throw std::runtime_error("Target unit is out of attack range.");
-        }
+// Validate the attack and deal the damage to the target unit
+void Unit::attackUnit(const Unit* tempTargetUnit, unsigned short targetId) {
+    Unit& targetUnit = const_cast<Unit&>(prepareAttack(tempTargetUnit, targetId));
 
-        // Calculate the damage to be dealt to the target unit
-        unsigned short damage = calculateDamage(*targetUnit);
+    // Deal the calculated amount of damage to the target unit
+    targetUnit.takeDamage(calculateDamage(targetUnit));
+}
 
-        // Deal the calculated amount of damage to the target unit
-        targetUnit->takeDamage(damage);
+// Validate the attack and spend the unit's attack for this turn
+const Unit& Unit::prepareAttack(const Unit* targetUnit, unsigned short targetId) {
+    if (name == "Base") {
+        throw std::runtime_error("Base unit cannot perform attack action. ");
+    }
+    if (speed == 0) {
+        throw std::runtime_error("Unit cannot attack. Speed is 0.");
+    }
+    if (hasAttacked) {
+        throw std::runtime_error("Unit can only attack once.");
+    }
+    if (!targetUnit) {
+        throw std::runtime_error("Target unit with ID " + std::to_string(targetId) + " not found.");
+    }
 
-        // Decrease the unit's speed by 1 after a successful attack
-        speed -= 1;
+    // Throw an error when trying to attack an ally
+    if (owner == targetUnit->owner) {
+        throw std::runtime_error("A unit cannot attack their allies.");
+    }
 
-        // Set the hasAttacked flag to true
-        hasAttacked = true;
-    } else {
-        throw std::runtime_error("Target unit with ID " + std::to_string(targetId) + " not found.");
+    // Calculate the distance between the unit's current position and the target unit's position
+    unsigned short distance = calculateDistance(targetUnit->getPositionX(), targetUnit->getPositionY());
+
+    // Check if the target unit is within the attack range
+    if (distance > attackRange) {
+        throw std::runtime_error("Target unit is out of attack range.");
     }
+
+    // Decrease the unit's speed by 1 after a successful attack
+    speed -= 1;
+
+    // Set the hasAttacked flag to true
+    hasAttacked = true;
+
+    return *targetUnit;
 }
 
 // Perform a move action to the specified position (x, y)
@@ -226,6 +261,38 @@ void Unit::moveAction(unsigned short x, unsigned short y, const std::vector<Unit
     speed -= distance;
 }
 
+// Perform a move action, looking up the target position in the spatial index
+void Unit::moveAction(unsigned short x, unsigned short y, const SpatialIndex& index, const Map& map) {
+    unsigned short distance = calculateDistance(x, y);
+
+    if (name == "Base") {
+        throw std::runtime_error("Base unit cannot perform move action. ");
+    }
+    if (distance > speed) {
+        throw std::runtime_error("Movement distance exceeds the unit's speed.");
+    }
+
+    // Check if the target position is within the map's boundaries
+    if (x >= map.getWidth() || y >= map.getHeight()) {
+        throw std::runtime_error("Target position is outside the map's boundaries.");
+    }
+
+    // Check if the target position is an obstacle
+    if (map.getCell(x, y) == '9') {
+        throw std::runtime_error("Target position is an obstacle and cannot be moved to.");
+    }
+
+    // Check if the target position is occupied by an enemy unit
+    if (index.isOccupied(enemiesOf(owner), x, y)) {
+        throw std::runtime_error("Cannot enter the enemy's unit space.");
+    }
+
+    position[0] = x;
+    position[1] = y;
+
+    speed -= distance;
+}
+
 // Take the specified amount of damage
 void Unit::takeDamage(unsigned short amount) {
     if (amount >= health) {
@@ -255,7 +322,7 @@ void Unit::reset() {
 
 // Deploy the unit on the home base's space
 void Unit::deploy(const Unit& base) {
-    if (name == "Base") {
+    if (base.name == "Base") {
         position[0] = base.position[0];
         position[1] = base.position[1];
     } else {
@@ -268,35 +335,32 @@ bool Unit::isWorker() const {
     return name == "Worker";
 }
 
-void Unit::createUnit(const Unit& unit) {
+std::optional<Unit> Unit::createUnit(const Unit& unit) {
     // Check if the current unit is a base
     if (name != "Base") {
         throw std::runtime_error("Only a base unit can create units.");
     }
 
     // Check if a unit is already being created
-    if (currentCreation) {
-        if (currentCreation->getId() != unit.getId() && currentCreation != nullptr) {
+    if (currentCreation.unit) {
+        if (currentCreation.unit->getId() != unit.getId()) {
             throw std::runtime_error("Base is already creating a different unit.");
         }
-        // Check if the current unit being created has finished building
-        if (!currentCreation->buildingTick()) {
-            return;  // Do nothing if the current unit is still being built
-        }
-        // Deploy the unit on the base itself
-        currentCreation->deploy(*this);
-        currentCreation = nullptr;  // Reset the currentCreation pointer
     } else {
         // Create a new unit
-        currentCreation = new Unit(unit);
-        // Check if the unit being created has already finished building
-        if (!currentCreation->buildingTick()) {
-            return;  // Do nothing if the unit is still being built
-        }
-        // Deploy the unit on the base itself
-        currentCreation->deploy(*this);
-        currentCreation = nullptr;  // Reset the currentCreation pointer
+        currentCreation.unit = std::make_unique<Unit>(unit);
+    }
+
+    // Check if the current unit being created has finished building
+    if (!currentCreation.unit->buildingTick()) {
+        return std::nullopt;  // Do nothing if the current unit is still being built
     }
+
+    // Deploy the unit on the base itself
+    currentCreation.unit->deploy(*this);
+    Unit deployed = *currentCreation.unit;
+    currentCreation.unit.reset();  // Reset the current creation
+    return deployed;
 }
 
 // Check if a worker unit is on mine
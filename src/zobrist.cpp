@@ -0,0 +1,48 @@
+#include "zobrist.hpp"
+
+namespace {
+
+// The finalizer of SplitMix64, a bijection on 64-bit values
+std::uint64_t mix(std::uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ull;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBull;
+    value ^= value >> 31;
+    return value;
+}
+
+// Scrambles the packed fields of units
+const std::uint64_t unitSeed = 0x9E3779B97F4A7C15ull;
+// Spreads the unit ID over the word before the second round of mixing
+const std::uint64_t idSeed = 0xD6E8FEB86659FD93ull;
+// Scrambles the kind and value of state keys
+const std::uint64_t stateSeed = 0xA0761D6478BD642Full;
+
+}  // namespace
+
+std::uint64_t zobristUnitKey(const Unit& unit) {
+    std::uint64_t packed = static_cast<std::uint64_t>(static_cast<unsigned char>(unit.getInitial())) << 56 |
+                           static_cast<std::uint64_t>(unit.getOwner()) << 48 |
+                           static_cast<std::uint64_t>(unit.getPositionX()) << 32 |
+                           static_cast<std::uint64_t>(unit.getPositionY()) << 16 |
+                           unit.getHealth();
+    return mix(mix(packed ^ unitSeed) ^ (static_cast<std::uint64_t>(unit.getId()) + 1) * idSeed);
+}
+
+std::uint64_t zobristStateKey(std::uint32_t kind, std::uint32_t value) {
+    // Unit keys are mixed again with their ID, so no bit pattern of the packed fields keeps the
+    // two apart; state keys use a seed of their own and only collide with a unit key by chance
+    std::uint64_t packed = static_cast<std::uint64_t>(kind) << 32 | value;
+    return mix(packed ^ stateSeed);
+}
+
+std::uint64_t zobristHash(const std::vector<const std::vector<Unit>*>& armies) {
+    std::uint64_t hash = 0;
+    for (const std::vector<Unit>* army : armies) {
+        for (const Unit& unit : *army) {
+            hash ^= zobristUnitKey(unit);
+        }
+    }
+    return hash;
+}